@@ -1,11 +1,12 @@
 #version 410 core
 
 //#common.inc
+//#draw.inc
 
 layout (location = 0) in vec3 attr_position;
 
-uniform mat4 mtx_model;
-
 void main() {
+    mat4 mtx_model = drawTransform();
+
     gl_Position = camera.viewproj * mtx_model * vec4(attr_position, 1.0);
 }
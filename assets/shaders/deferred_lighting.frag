@@ -0,0 +1,52 @@
+#version 410 core
+
+//#common.inc
+//#lights.inc
+
+in VSOut {
+  vec2 texcoords;
+} fs_in;
+
+uniform sampler2D gbuffer_albedo_spec;
+uniform sampler2D gbuffer_normal;
+uniform sampler2D gbuffer_depth;
+
+uniform mat4 mtx_inv_viewproj;
+uniform mat4 mtx_light_vp;
+
+out vec4 out_color;
+
+void main() {
+  float depth = texture(gbuffer_depth, fs_in.texcoords).r;
+  if (depth >= 1.0)
+    discard;
+
+  // Forward passes drawn afterwards test against the G-buffer depth
+  gl_FragDepth = depth;
+
+  vec4 albedoSpec = texture(gbuffer_albedo_spec, fs_in.texcoords);
+  vec4 normalShininess = texture(gbuffer_normal, fs_in.texcoords);
+
+  vec4 clipPos = vec4(vec3(fs_in.texcoords, depth) * 2.0 - 1.0, 1.0);
+  vec4 worldPos = mtx_inv_viewproj * clipPos;
+  vec3 fragpos = worldPos.xyz / worldPos.w;
+
+  vec3 diffColor = albedoSpec.rgb;
+  vec3 specColor = vec3(albedoSpec.a);
+  vec3 normal = normalize(normalShininess.xyz);
+  float shininess = normalShininess.w;
+  vec3 viewDir = normalize(camera.pos.xyz - fragpos);
+
+  float shadowBias = max(0.0025 * (1.0 - dot(normal, lights.main.direction)), 0.0005);
+  float shadow = shadowFactor(mtx_light_vp * vec4(fragpos, 1.0), shadowBias);
+
+  vec3 result = calculateDirectionalLight(lights.main, diffColor, specColor, normal, viewDir, shininess, shadow);
+
+  uvec2 cluster = fetchLightCluster(fragpos);
+  for (uint i = 0u; i < cluster.y; ++i) {
+    PointLight light = fetchPointLight(fetchLightIndex(cluster.x + i));
+    result += calculatePointLight(light, diffColor, specColor, fragpos, normal, viewDir, shininess);
+  }
+
+  out_color = vec4(result, 1.0);
+}
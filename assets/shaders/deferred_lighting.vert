@@ -0,0 +1,14 @@
+#version 410 core
+
+layout (location = 0) in vec3 attr_position;
+layout (location = 2) in vec2 attr_texcoords;
+
+out VSOut {
+  vec2 texcoords;
+} vs_out;
+
+void main() {
+  // Screen quad spans -0.5..0.5, scale it to cover the viewport
+  vs_out.texcoords = attr_texcoords;
+  gl_Position = vec4(attr_position.xy * 2.0, 0.0, 1.0);
+}
@@ -0,0 +1,9 @@
+#version 410 core
+
+layout (location = 0) in vec3 attr_position;
+
+uniform mat4 mtx_mvp;
+
+void main() {
+    gl_Position = mtx_mvp * vec4(attr_position, 1.0);
+}
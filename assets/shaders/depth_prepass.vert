@@ -0,0 +1,13 @@
+#version 410 core
+
+//#common.inc
+//#draw.inc
+
+layout (location = 0) in vec3 attr_position;
+
+void main() {
+    mat4 mtx_model = drawTransform();
+
+    // Same expression as the main pass shaders, the main pass depth test is GL_EQUAL
+    gl_Position = camera.viewproj * mtx_model * vec4(attr_position, 1.0);
+}
@@ -0,0 +1,55 @@
+#version 410 core
+
+// G-buffer variant of illum.frag for the deferred path, shading happens in deferred_lighting.frag
+
+const uint SlotFlag_Diffuse  = 0x00000001u;
+const uint SlotFlag_Specular = 0x00000002u;
+const uint SlotFlag_Normal   = 0x00000004u;
+
+in VSOut {
+  vec3 fragpos;
+  vec4 fragpos_lightspace;
+  vec3 normal;
+  vec2 texcoords;
+  mat3 tbn;
+  flat int draw_index;
+} fs_in;
+
+struct Material {
+  uint      active_slots;
+  sampler2D texture_diffuse;
+  sampler2D texture_specular;
+  sampler2D texture_normal;
+
+  vec3     color;
+  vec3     specular;
+  float    shininess;
+};
+
+uniform Material  material;
+
+layout (location = 0) out vec4 out_albedo_spec;
+layout (location = 1) out vec4 out_normal_shininess;
+
+void main() {
+  vec3 diffColor = material.color;
+  vec3 specColor = material.specular;
+
+  vec3 normal = normalize(fs_in.normal);
+
+  if ((material.active_slots & SlotFlag_Diffuse) != 0) {
+      diffColor = texture(material.texture_diffuse, fs_in.texcoords).rgb;
+  }
+  if ((material.active_slots & SlotFlag_Specular) != 0) {
+      specColor = texture(material.texture_specular, fs_in.texcoords).rgb;
+  }
+  if ((material.active_slots & SlotFlag_Normal) != 0) {
+    normal = texture(material.texture_normal, fs_in.texcoords).rgb;
+    normal = normalize(normal * 2.0f - 1.0f);
+    normal = normalize(fs_in.tbn * normal);
+  }
+
+  // Specular color is reduced to a single intensity
+  out_albedo_spec = vec4(diffColor, dot(specColor, vec3(1.0 / 3.0)));
+  out_normal_shininess = vec4(normal, material.shininess);
+}
@@ -10,5 +10,10 @@ uniform sampler2D texture_font;
 out vec4 out_color;
 
 void main() {
-  out_color = vec4(fs_in.color, texture(texture_font, fs_in.texcoords).r);
+  // Distance field, 0.5 is the glyph outline. Smoothing over one screen pixel keeps edges sharp at any scale.
+  float distance = texture(texture_font, fs_in.texcoords).r;
+  float smoothing = max(fwidth(distance), 0.0001f);
+  float alpha = smoothstep(0.5f - smoothing, 0.5f + smoothing, distance);
+
+  out_color = vec4(fs_in.color, alpha);
 }
@@ -2,9 +2,11 @@
 
 //#common.inc
 
-layout (location = 0) in vec3 attr_position;
-layout (location = 1) in vec2 attr_texcoords;
-layout (location = 2) in vec3 attr_color;
+layout (location = 0) in vec2 attr_corner;
+layout (location = 1) in vec3 attr_position;
+layout (location = 2) in vec2 attr_size;
+layout (location = 3) in vec4 attr_atlas_rect;
+layout (location = 4) in vec4 attr_color;
 
 out VSOut {
   vec2 texcoords;
@@ -12,10 +14,12 @@ out VSOut {
 } vs_out;
 
 void main() {
-  float x = ((attr_position.x / camera.viewport.x) * 2.0f) - 1.0f;
-  float y = ((attr_position.y / camera.viewport.y) * 2.0f) - 1.0f;
+  vec2 position = attr_position.xy + attr_corner * attr_size;
+  float x = ((position.x / camera.viewport.x) * 2.0f) - 1.0f;
+  float y = ((position.y / camera.viewport.y) * 2.0f) - 1.0f;
 
-  vs_out.texcoords = attr_texcoords;
-  vs_out.color = attr_color;
+  // Atlas v grows downwards
+  vs_out.texcoords = mix(attr_atlas_rect.xw, attr_atlas_rect.zy, attr_corner);
+  vs_out.color = attr_color.rgb;
   gl_Position = vec4(x, y, attr_position.z, 1.0f);
 }
@@ -3,6 +3,14 @@
 #include "../utils/mesh_utils.h"
 #include <imgui.h>
 
+SceneCubemaps::~SceneCubemaps() {
+  Material::Destroy(_skybox.getModelMaterial());
+  GfxModel::Destroy(_skybox.getModel());
+  Material::Destroy(_sphere.getModelMaterial());
+  Material::Destroy(_box.getModelMaterial());
+  Texture::Destroy(_skyboxTexture);
+}
+
 void SceneCubemaps::init() {
   // Init refraction indices
   _refractionIndices.reserve(4);
@@ -23,15 +31,16 @@ void SceneCubemaps::init() {
   }
 
   // Skybox
-  TextureRef skyboxTexture = Texture::CreateCubemap(params);
+  _skyboxTexture = Texture::CreateCubemap(params);
   MaterialRef skyboxMaterial = Material::Create(getAssetManager().getShader("skybox"));
-  skyboxMaterial->setTextureSlot(MaterialSlotId_0, "material.cubemap_skybox", skyboxTexture);
+  skyboxMaterial->setTextureSlot(MaterialSlotId_0, "material.cubemap_skybox", _skyboxTexture);
 
   _skybox.attachModel(GfxModel::Create(MeshUtils::CreateSkybox(), skyboxMaterial));
+  _skybox.setFlag(Entity::Flags::NoCulling, true);
 
   // Reflective Sphere
   MaterialRef sphereMaterial = Material::Create(getAssetManager().getShader("env_mapping"));
-  sphereMaterial->setTextureSlot(MaterialSlotId_0, "material.cubemap", skyboxTexture);
+  sphereMaterial->setTextureSlot(MaterialSlotId_0, "material.cubemap", _skyboxTexture);
   sphereMaterial->setParamInt("material.refract", 0);
 
   _sphere.attachModel(getAssetManager().loadModel("models/sphere.gfx"));
@@ -41,7 +50,7 @@ void SceneCubemaps::init() {
 
   // Refractive Box
   MaterialRef boxMaterial = Material::Create(getAssetManager().getShader("env_mapping"));
-  boxMaterial->setTextureSlot(MaterialSlotId_0, "material.cubemap", skyboxTexture);
+  boxMaterial->setTextureSlot(MaterialSlotId_0, "material.cubemap", _skyboxTexture);
   boxMaterial->setParamInt("material.refract", 1);
   boxMaterial->setParamFloat("material.refract_index", _refractionIndices[_currentIndex].value);
 
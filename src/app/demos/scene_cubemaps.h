@@ -16,6 +16,7 @@ public:
     : Scene(manager) {
       _time = 0.0f;
   }
+  virtual ~SceneCubemaps();
 
   virtual void init() override;
   virtual void update(float frameTime) override;
@@ -27,6 +28,7 @@ private:
   Entity    _skybox;
   Entity    _sphere;
   Entity    _box;
+  TextureRef _skyboxTexture;
   float     _time;
 
   std::vector<RefractionIndex> _refractionIndices;
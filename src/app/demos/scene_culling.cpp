@@ -0,0 +1,108 @@
+#include "scene_culling.h"
+
+#include "../utils/mesh_utils.h"
+#include <imgui.h>
+
+#define CRATE_SPACING 2.5f
+
+SceneCulling::~SceneCulling() {
+  destroyCrates();
+  GfxModel::Destroy(_ground.getModel());
+}
+
+void SceneCulling::init() {
+  _crateModel = getAssetManager().loadModel("models/wooden_crate.gfx");
+
+  _ground.attachModel(GfxModel::Create(MeshUtils::CreateGroundPlane(2.0f, 15, 2.0f), getAssetManager().getMaterial("stone_floor")));
+
+  // Big occluder for the Hi-Z pass
+  _wall.attachModel(_crateModel);
+  _wall.setPosition(glm::vec3(0.0f, 3.0f, 12.0f));
+  _wall.setScale(glm::vec3(24.0f, 6.0f, 0.5f));
+  _wall.setFlag(Entity::Flags::RenderShadow, true);
+
+  createCrates();
+}
+
+void SceneCulling::update(float frameTime) {
+  _time += frameTime;
+
+  if (!_animate) return;
+
+  for (auto& crate : _crates) {
+    const glm::mat4 worldTM = computeCrateTM(crate);
+    for (auto id : crate.objects) {
+      _renderer.updateRenderObject(id, worldTM);
+    }
+  }
+}
+
+void SceneCulling::render(Renderer& renderer) {
+  // Crates are retained render objects, only the ground goes through the per-frame list
+  _ground.render(renderer);
+
+  if (_showWall) {
+    _wall.render(renderer);
+  }
+}
+
+void SceneCulling::onInputEvent(const InputEvent& event) {
+
+}
+
+void SceneCulling::onGUI() {
+  ImGui::Separator();
+  ImGui::Text("Culling Scene");
+  ImGui::Separator();
+
+  auto& stats = _renderer.getStats();
+  ImGui::Text("Render objects %d", stats.renderObjects);
+  ImGui::Text("Culling %s", _renderer.isGPUCullingEnabled() ? "GPU (compute)" : "CPU (frustum)");
+  if (!_renderer.isGPUCullingEnabled()) {
+    ImGui::Text("Culled items %d", stats.culledItems);
+  }
+  ImGui::Text("Occlusion %s, occluded items %d", _renderer.isOcclusionCullingEnabled() ? "ON" : "OFF", stats.occludedItems);
+
+  ImGui::Checkbox("Animate", &_animate);
+  ImGui::Checkbox("Occluder wall", &_showWall);
+
+  if (ImGui::SliderInt("Grid size", &_gridSize, 8, 128)) {
+    destroyCrates();
+    createCrates();
+  }
+}
+
+void SceneCulling::createCrates() {
+  const float offset = (_gridSize - 1) * CRATE_SPACING * 0.5f;
+
+  _crates.resize(_gridSize * _gridSize);
+  for (int z = 0; z < _gridSize; ++z) {
+    for (int x = 0; x < _gridSize; ++x) {
+      auto& crate = _crates[z * _gridSize + x];
+      crate.position = glm::vec3(x * CRATE_SPACING - offset, 1.0f, z * CRATE_SPACING - offset);
+      crate.phase = (float)(x + z) * 0.25f;
+
+      const glm::mat4 worldTM = computeCrateTM(crate);
+      for (uint32_t idx = 0; idx < _crateModel->getMeshCount(); ++idx) {
+        crate.objects.push_back(_renderer.createRenderObject(_crateModel->getMesh(idx), _crateModel->getMaterial(), worldTM, DrawFlags_Shadow));
+      }
+    }
+  }
+}
+
+void SceneCulling::destroyCrates() {
+  for (auto& crate : _crates) {
+    for (auto id : crate.objects) {
+      _renderer.destroyRenderObject(id);
+    }
+  }
+
+  _crates.clear();
+}
+
+glm::mat4 SceneCulling::computeCrateTM(const Crate& crate) const {
+  const float angle = _animate ? _time + crate.phase : crate.phase;
+  const auto r = glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f));
+
+  return glm::translate(glm::mat4(1.0f), crate.position) * glm::toMat4(r);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "scene.h"
+#include "../utils/entity.h"
+
+
+class SceneCulling: public Scene {
+private:
+  struct Crate {
+    glm::vec3 position;
+    float     phase;
+    std::vector<RenderObjectId> objects;
+  };
+
+public:
+  SceneCulling(AssetManager& manager, Renderer& renderer)
+    : Scene(manager)
+    , _renderer(renderer) {
+      _time = 0.0f;
+      _gridSize = 64;
+      _animate = false;
+      _showWall = true;
+  }
+  virtual ~SceneCulling();
+
+  virtual void init() override;
+  virtual void update(float frameTime) override;
+  virtual void render(Renderer& renderer) override;
+  virtual void onInputEvent(const InputEvent& event) override;
+  virtual void onGUI() override;
+
+private:
+  void createCrates();
+  void destroyCrates();
+  glm::mat4 computeCrateTM(const Crate& crate) const;
+
+private:
+  Renderer&   _renderer;
+  GfxModelRef _crateModel;
+  Entity      _ground;
+  Entity      _wall;
+
+  std::vector<Crate> _crates;
+  float _time;
+  int   _gridSize;
+  bool  _animate;
+  bool  _showWall;
+};
@@ -0,0 +1,171 @@
+#include "scene_lights.h"
+
+#include "../utils/mesh_utils.h"
+#include <imgui.h>
+
+#define AREA_SIZE 30.0f
+#define CRATE_GRID 8
+
+#define BENCHMARK_WARMUP_FRAMES 30
+#define BENCHMARK_FRAMES 120
+
+static const int LIGHT_PRESETS[] = { 8, 64, 512 };
+static const int LIGHT_PRESET_COUNT = 3;
+static const Renderer::RenderPath BENCHMARK_PATHS[] = { Renderer::RenderPath::Forward, Renderer::RenderPath::Deferred };
+static const int BENCHMARK_STEPS = LIGHT_PRESET_COUNT * 2;
+
+static const char* renderPathName(Renderer::RenderPath path) {
+  return path == Renderer::RenderPath::Deferred ? "Deferred" : "Forward";
+}
+
+// Fully saturated color from a hue in [0, 1)
+static ColorRGB hueToColor(float hue) {
+  const float r = fabsf(hue * 6.0f - 3.0f) - 1.0f;
+  const float g = 2.0f - fabsf(hue * 6.0f - 2.0f);
+  const float b = 2.0f - fabsf(hue * 6.0f - 4.0f);
+
+  return glm::clamp(ColorRGB(r, g, b), ColorRGB(0.0f), ColorRGB(1.0f));
+}
+
+SceneLights::~SceneLights() {
+  GfxModel::Destroy(_ground.getModel());
+}
+
+void SceneLights::init() {
+  _ground.attachModel(GfxModel::Create(MeshUtils::CreateGroundPlane(AREA_SIZE / 15.0f, 15, 2.0f), getAssetManager().getMaterial("stone_floor")));
+
+  auto crateModel = getAssetManager().loadModel("models/wooden_crate.gfx");
+  const float spacing = AREA_SIZE / CRATE_GRID;
+  const float offset = (CRATE_GRID - 1) * spacing * 0.5f;
+
+  _crates.resize(CRATE_GRID * CRATE_GRID);
+  for (int z = 0; z < CRATE_GRID; ++z) {
+    for (int x = 0; x < CRATE_GRID; ++x) {
+      auto& crate = _crates[z * CRATE_GRID + x];
+      crate.attachModel(crateModel);
+      crate.setPosition(glm::vec3(x * spacing - offset, 1.0f, z * spacing - offset));
+    }
+  }
+
+  createLights();
+}
+
+void SceneLights::update(float frameTime) {
+  _time += frameTime;
+  _frameTime = frameTime;
+
+  for (auto& moving : _lights) {
+    const float angle = _time * moving.speed + moving.phase;
+    moving.light.position = moving.center + glm::vec3(cosf(angle), 0.0f, sinf(angle)) * moving.orbitRadius;
+  }
+}
+
+void SceneLights::render(Renderer& renderer) {
+  if (_benchmarkStep >= 0) {
+    updateBenchmark(renderer);
+  }
+
+  _ground.render(renderer);
+  for (auto& crate : _crates) {
+    crate.render(renderer);
+  }
+
+  for (auto& moving : _lights) {
+    renderer.drawLight(moving.light);
+  }
+}
+
+void SceneLights::onInputEvent(const InputEvent& event) {
+
+}
+
+void SceneLights::onGUI() {
+  ImGui::Separator();
+  ImGui::Text("Lights Scene");
+  ImGui::Separator();
+
+  if (ImGui::SliderInt("Point lights", &_lightCount, 8, 1024)) {
+    createLights();
+  }
+
+  ImGui::Text("Presets:");
+  for (int preset : LIGHT_PRESETS) {
+    ImGui::SameLine();
+    if (ImGui::Button(std::to_string(preset).c_str())) {
+      _lightCount = preset;
+      createLights();
+    }
+  }
+
+  if (_benchmarkStep >= 0) {
+    ImGui::Text("Benchmark running... %d/%d", _benchmarkStep + 1, BENCHMARK_STEPS);
+  }
+  else if (ImGui::Button("Benchmark forward vs deferred")) {
+    _benchmarkStep = 0;
+    _benchmarkFrames = 0;
+    _benchmarkResults.clear();
+  }
+
+  for (const auto& result : _benchmarkResults) {
+    ImGui::Text("%-8s %4d lights | frame %.3f ms | GPU main %.3f ms", renderPathName(result.path), result.lightCount, result.frameMs, result.gpuMainMs);
+  }
+}
+
+void SceneLights::updateBenchmark(Renderer& renderer) {
+  // Each step runs one render path and light preset, timings are averaged after a warm-up
+  const Renderer::RenderPath path = BENCHMARK_PATHS[_benchmarkStep / LIGHT_PRESET_COUNT];
+  const int lightCount = LIGHT_PRESETS[_benchmarkStep % LIGHT_PRESET_COUNT];
+
+  if (_benchmarkFrames == 0) {
+    if (_benchmarkStep == 0) {
+      _benchmarkRestorePath = renderer.getRenderPath();
+    }
+
+    renderer.setRenderPath(path);
+    _lightCount = lightCount;
+    createLights();
+    _benchmarkResults.push_back({ path, lightCount, 0.0f, 0.0f });
+  }
+  else if (_benchmarkFrames > BENCHMARK_WARMUP_FRAMES) {
+    // Stats belong to the previous frame
+    auto& result = _benchmarkResults.back();
+    result.frameMs += _frameTime * 1000.0f / BENCHMARK_FRAMES;
+    result.gpuMainMs += renderer.getStats().gpuMainMs / BENCHMARK_FRAMES;
+  }
+
+  if (++_benchmarkFrames <= BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+    return;
+
+  const auto& result = _benchmarkResults.back();
+  LOG_INFO("[SceneLights] {} {} lights: frame {:.3f} ms, GPU main {:.3f} ms", renderPathName(result.path), result.lightCount, result.frameMs, result.gpuMainMs);
+
+  _benchmarkFrames = 0;
+  if (++_benchmarkStep == BENCHMARK_STEPS) {
+    _benchmarkStep = -1;
+    renderer.setRenderPath(_benchmarkRestorePath);
+  }
+}
+
+void SceneLights::createLights() {
+  // Deterministic layout so runs with the same count are comparable
+  std::srand(1234);
+  auto random = []() { return (float)std::rand() / (float)RAND_MAX; };
+
+  _lights.resize(_lightCount);
+  for (int i = 0; i < _lightCount; ++i) {
+    auto& moving = _lights[i];
+    moving.center = glm::vec3((random() - 0.5f) * AREA_SIZE, 0.5f + random() * 1.5f, (random() - 0.5f) * AREA_SIZE);
+    moving.orbitRadius = 0.5f + random() * 2.0f;
+    moving.speed = 0.5f + random();
+    moving.phase = random() * 6.2831853f;
+
+    moving.light = Light(Light::Type::Point);
+    moving.light.position = moving.center;
+    moving.light.properties.color = hueToColor(random());
+    moving.light.properties.ambientMultiplier = 0.0f;
+    moving.light.properties.specularMultiplier = 0.5f;
+    moving.light.properties.attenuationConstant = 1.0f;
+    moving.light.properties.attenuationLinear = 0.7f;
+    moving.light.properties.attenuationQuadratic = 1.8f;
+  }
+}
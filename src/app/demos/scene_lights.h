@@ -0,0 +1,58 @@
+#pragma once
+
+#include "scene.h"
+#include "../utils/entity.h"
+
+
+class SceneLights: public Scene {
+private:
+  struct MovingLight {
+    Light     light;
+    glm::vec3 center;
+    float     orbitRadius;
+    float     speed;
+    float     phase;
+  };
+
+  // Forward vs deferred timings over the light presets
+  struct BenchmarkResult {
+    Renderer::RenderPath path;
+    int   lightCount;
+    float frameMs;
+    float gpuMainMs;
+  };
+
+public:
+  SceneLights(AssetManager& manager)
+    : Scene(manager) {
+      _time = 0.0f;
+      _lightCount = 256;
+      _frameTime = 0.0f;
+      _benchmarkStep = -1;
+  }
+  virtual ~SceneLights();
+
+  virtual void init() override;
+  virtual void update(float frameTime) override;
+  virtual void render(Renderer& renderer) override;
+  virtual void onInputEvent(const InputEvent& event) override;
+  virtual void onGUI() override;
+
+private:
+  void createLights();
+  void updateBenchmark(Renderer& renderer);
+
+private:
+  Entity    _ground;
+  std::vector<Entity> _crates;
+  std::vector<MovingLight> _lights;
+
+  float _time;
+  int   _lightCount;
+  float _frameTime;
+
+  int   _benchmarkStep;
+  int   _benchmarkFrames;
+  Renderer::RenderPath _benchmarkRestorePath;
+  std::vector<BenchmarkResult> _benchmarkResults;
+};
@@ -3,6 +3,13 @@
 #include "../utils/mesh_utils.h"
 #include <imgui.h>
 
+ScenePlayground::~ScenePlayground() {
+  GfxModel::Destroy(_ground.getModel());
+  for (auto& light : _pointLights) {
+    Material::Destroy(light.getModelMaterial());
+  }
+}
+
 void ScenePlayground::init() {
   auto floorMaterial = getAssetManager().getMaterial("stone_floor");
 
@@ -16,6 +16,7 @@ public:
     _sunSpecularMult = 0.8f;
     _sunPosition = computeSunPosition();
   }
+  virtual ~ScenePlayground();
 
   virtual void init() override;
   virtual void update(float frameTime) override;
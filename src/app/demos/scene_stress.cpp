@@ -0,0 +1,194 @@
+#include "scene_stress.h"
+
+#include <imgui.h>
+#include <SDL.h>
+
+#define ENTITY_SPACING 1.2f
+#define ENTITIES_PER_LIGHT 400
+#define MAX_LIGHTS 256
+#define SPIN_BATCH_SIZE 1024
+#define MAX_HIERARCHY_DEPTH 4
+#define SATELLITE_OFFSET 3.0f
+
+#define BENCHMARK_WARMUP_FRAMES 10
+#define BENCHMARK_FRAMES 60
+
+static const int ENTITY_PRESETS[] = { 1000, 10000, 50000, 100000 };
+static const int BENCHMARK_COUNTS[] = { 12500, 25000, 50000, 100000 };
+static const int BENCHMARK_STEPS = 4;
+
+static float elapsedMs(uint64_t start) {
+  return (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+void SceneStress::init() {
+  _model = getAssetManager().loadModel("models/wooden_crate.gfx");
+
+  createEntities();
+}
+
+void SceneStress::update(float frameTime) {
+  if (_animate) {
+    _time += frameTime;
+
+    const uint64_t start = SDL_GetPerformanceCounter();
+    spinEntities();
+    _updateMs = elapsedMs(start);
+  }
+
+  const uint64_t start = SDL_GetPerformanceCounter();
+  _world.updateTransforms(_jobSystem);
+  _transformsMs = elapsedMs(start);
+}
+
+void SceneStress::render(Renderer& renderer) {
+  const uint64_t start = SDL_GetPerformanceCounter();
+  _world.render(renderer);
+  _emitMs = elapsedMs(start);
+
+  if (_benchmarkStep >= 0) {
+    updateBenchmark();
+  }
+}
+
+void SceneStress::onInputEvent(const InputEvent& event) {
+
+}
+
+void SceneStress::onGUI() {
+  ImGui::Separator();
+  ImGui::Text("Stress Scene");
+  ImGui::Separator();
+
+  if (ImGui::SliderInt("Entities", &_entityCount, 1000, 100000)) {
+    createEntities();
+  }
+
+  ImGui::Text("Presets:");
+  for (int preset : ENTITY_PRESETS) {
+    ImGui::SameLine();
+    if (ImGui::Button(std::to_string(preset).c_str())) {
+      _entityCount = preset;
+      createEntities();
+    }
+  }
+
+  if (ImGui::SliderInt("Hierarchy depth", &_hierarchyDepth, 0, MAX_HIERARCHY_DEPTH)) {
+    createEntities();
+  }
+
+  ImGui::Checkbox("Animate", &_animate);
+
+  const float perEntity = 1000000.0f / std::max(1u, _world.getEntityCount());
+  ImGui::Text(
+    "Entities %d | renderables %d | lights %d | levels %d",
+    _world.getEntityCount(), _world.getRenderables().size(), _world.getLights().size(), _world.getLevelCount()
+  );
+  ImGui::Text("Spin %.3f ms | transforms %.3f ms | emit %.3f ms", _updateMs, _transformsMs, _emitMs);
+  ImGui::Text("Per entity: spin %.1f ns | transforms %.1f ns | emit %.1f ns", _updateMs * perEntity, _transformsMs * perEntity, _emitMs * perEntity);
+
+  if (_benchmarkStep >= 0) {
+    ImGui::Text("Benchmark running... %d/%d", _benchmarkStep + 1, BENCHMARK_STEPS);
+  }
+  else if (ImGui::Button("Benchmark scaling")) {
+    _animate = true;
+    _benchmarkStep = 0;
+    _benchmarkFrames = 0;
+    _benchmarkResults.clear();
+  }
+
+  for (const auto& result : _benchmarkResults) {
+    const float nsPerEntity = 1000000.0f / result.entityCount;
+    ImGui::Text(
+      "%6d entities | spin %.3f ms (%.1f ns) | transforms %.3f ms (%.1f ns) | emit %.3f ms (%.1f ns)",
+      result.entityCount, result.updateMs, result.updateMs * nsPerEntity, result.transformsMs, result.transformsMs * nsPerEntity,
+      result.emitMs, result.emitMs * nsPerEntity
+    );
+  }
+}
+
+void SceneStress::createEntities() {
+  _world.clear();
+
+  // Square grid of roots centered on the origin, each one with a chain of satellites orbiting their parent.
+  // Every few entities carries a light.
+  const int groupSize = 1 + _hierarchyDepth;
+  const int groupCount = (_entityCount + groupSize - 1) / groupSize;
+  const int side = (int)ceilf(sqrtf((float)groupCount));
+  const float offset = (side - 1) * ENTITY_SPACING * 0.5f;
+
+  EntityId parent;
+  for (int i = 0; i < _entityCount; ++i) {
+    const int group = i / groupSize;
+    EntityId entity;
+
+    if (i % groupSize == 0) {
+      entity = _world.createEntity(glm::vec3((group % side) * ENTITY_SPACING - offset, 0.5f, (group / side) * ENTITY_SPACING - offset));
+      _world.setScale(entity, glm::vec3(0.25f));
+    }
+    else {
+      entity = _world.createEntity(glm::vec3(SATELLITE_OFFSET, 0.0f, 0.0f));
+      _world.setScale(entity, glm::vec3(0.6f));
+      _world.setParent(entity, parent);
+    }
+
+    _world.addRenderable(entity, _model);
+    parent = entity;
+
+    if (i % ENTITIES_PER_LIGHT == 0 && _world.getLights().size() < MAX_LIGHTS) {
+      Light::Properties props;
+      props.color = ColorRGB(0.5f + 0.5f * sinf(i * 0.1f), 0.5f + 0.5f * cosf(i * 0.07f), 0.8f);
+      props.ambientMultiplier = 0.0f;
+      props.attenuationLinear = 0.7f;
+      props.attenuationQuadratic = 1.8f;
+      _world.addLight(entity, props);
+    }
+  }
+
+  _world.updateTransforms(_jobSystem);
+}
+
+void SceneStress::spinEntities() {
+  // Reads positions and writes rotations straight into the dense arrays, speed derives from the position
+  auto& transforms = _world.getTransforms();
+  const float time = _time;
+
+  _jobSystem.parallelFor(transforms.size(), SPIN_BATCH_SIZE, [&transforms, time](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      const glm::vec3& position = transforms.positions[i];
+      const float speed = 0.5f + glm::fract(position.x * 0.37f + position.z * 0.11f);
+      transforms.rotations[i] = glm::angleAxis(time * speed, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+  });
+
+  _world.markDirty(0, transforms.size());
+}
+
+void SceneStress::updateBenchmark() {
+  // Each step rebuilds the world with one entity count, timings are averaged after a warm-up
+  if (_benchmarkFrames == 0) {
+    _entityCount = BENCHMARK_COUNTS[_benchmarkStep];
+    createEntities();
+    _benchmarkResults.push_back({ _entityCount, 0.0f, 0.0f, 0.0f });
+  }
+  else if (_benchmarkFrames > BENCHMARK_WARMUP_FRAMES) {
+    auto& result = _benchmarkResults.back();
+    result.updateMs += _updateMs / BENCHMARK_FRAMES;
+    result.transformsMs += _transformsMs / BENCHMARK_FRAMES;
+    result.emitMs += _emitMs / BENCHMARK_FRAMES;
+  }
+
+  if (++_benchmarkFrames <= BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES)
+    return;
+
+  const auto& result = _benchmarkResults.back();
+  LOG_INFO(
+    "[SceneStress] {} entities: spin {:.3f} ms, transforms {:.3f} ms, emit {:.3f} ms",
+    result.entityCount, result.updateMs, result.transformsMs, result.emitMs
+  );
+
+  _benchmarkFrames = 0;
+  if (++_benchmarkStep == BENCHMARK_STEPS) {
+    _benchmarkStep = -1;
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "scene.h"
+#include "core/world.h"
+
+class SceneStress: public Scene {
+private:
+  // Per-entity cost of each system at one entity count, to check it stays flat as the count grows
+  struct ScalingResult {
+    int   entityCount;
+    float updateMs;
+    float transformsMs;
+    float emitMs;
+  };
+
+public:
+  SceneStress(AssetManager& manager, JobSystem& jobSystem)
+    : Scene(manager)
+    , _jobSystem(jobSystem) {
+      _time = 0.0f;
+      _entityCount = 100000;
+      _hierarchyDepth = 0;
+      _animate = true;
+      _updateMs = 0.0f;
+      _transformsMs = 0.0f;
+      _emitMs = 0.0f;
+      _benchmarkStep = -1;
+  }
+
+  virtual void init() override;
+  virtual void update(float frameTime) override;
+  virtual void render(Renderer& renderer) override;
+  virtual void onInputEvent(const InputEvent& event) override;
+  virtual void onGUI() override;
+
+private:
+  void createEntities();
+  void spinEntities();
+  void updateBenchmark();
+
+private:
+  JobSystem&  _jobSystem;
+  World       _world;
+  GfxModelRef _model;
+
+  float _time;
+  int   _entityCount;
+  int   _hierarchyDepth;
+  bool  _animate;
+
+  float _updateMs;
+  float _transformsMs;
+  float _emitMs;
+
+  int   _benchmarkStep;
+  int   _benchmarkFrames;
+  std::vector<ScalingResult> _benchmarkResults;
+};
@@ -1,21 +1,31 @@
 #include "sandbox_app.h"
 #include "demos/scene_cubemaps.h"
+#include "demos/scene_culling.h"
+#include "demos/scene_lights.h"
 #include "demos/scene_playground.h"
+#include "demos/scene_stress.h"
 
 #include <imgui.h>
 
 #define SCENE_PLAYGROUND 0
 #define SCENE_CUBEMAPS   1
+#define SCENE_CULLING    2
+#define SCENE_LIGHTS     3
+#define SCENE_STRESS     4
 
 SandboxApp::SandboxApp()
   : _inputFlags(0)
   , _mousePosition(0.0f, 0.0f)
-  , _selectedScene(~0) {
+  , _selectedScene(~0)
+  , _requestedScene(~0)
+  , _recordInterval(1)
+  , _recordFormat(0) {
 
 }
 
 bool SandboxApp::onInit() {
-  changeScene(SCENE_PLAYGROUND);
+  _requestedScene = SCENE_PLAYGROUND;
+  changeScene(_requestedScene);
 
   return true;
 }
@@ -85,6 +95,11 @@ void SandboxApp::onMouseEvent(const MouseEvent& event) {
 }
 
 void SandboxApp::onUpdate(const UpdateContext& ctx) {
+  // Switched before anything is submitted, render items do not keep the old scene's meshes alive
+  if (_requestedScene != _selectedScene) {
+    changeScene(_requestedScene);
+  }
+
   // Update
   const float cameraSpeed = _camera.movementSpeed * ctx.frameTime;
   if (hasInputFlag(InputFlag_MoveLeft)) {
@@ -119,11 +134,23 @@ void SandboxApp::onGUI() {
     if (ImGui::BeginMenu("Demo Scene")){
       if (ImGui::MenuItem("Playground", nullptr, nullptr, _selectedScene != SCENE_PLAYGROUND)) {
         LOG_INFO("[App] Switching to playground scene");
-        changeScene(SCENE_PLAYGROUND);
+        _requestedScene = SCENE_PLAYGROUND;
       }
       if (ImGui::MenuItem("Cubemaps", nullptr, nullptr, _selectedScene != SCENE_CUBEMAPS)) {
         LOG_INFO("[App] Switching to cubemaps scene");
-        changeScene(SCENE_CUBEMAPS);
+        _requestedScene = SCENE_CUBEMAPS;
+      }
+      if (ImGui::MenuItem("Culling", nullptr, nullptr, _selectedScene != SCENE_CULLING)) {
+        LOG_INFO("[App] Switching to culling scene");
+        _requestedScene = SCENE_CULLING;
+      }
+      if (ImGui::MenuItem("Many lights", nullptr, nullptr, _selectedScene != SCENE_LIGHTS)) {
+        LOG_INFO("[App] Switching to lights scene");
+        _requestedScene = SCENE_LIGHTS;
+      }
+      if (ImGui::MenuItem("Entity stress", nullptr, nullptr, _selectedScene != SCENE_STRESS)) {
+        LOG_INFO("[App] Switching to stress scene");
+        _requestedScene = SCENE_STRESS;
       }
       ImGui::EndMenu();
     }
@@ -145,6 +172,91 @@ void SandboxApp::onGUI() {
       if (ImGui::Button("Toggle render debug")) {
         getRenderer()->toggleDebug();
       }
+      if (getRenderer()->isMultiDrawSupported() && ImGui::Button("Toggle multi-draw indirect")) {
+        getRenderer()->toggleMultiDraw();
+      }
+      if (getRenderer()->isGPUCullingSupported() && ImGui::Button("Toggle GPU culling")) {
+        getRenderer()->toggleGPUCulling();
+      }
+      if (ImGui::Button("Toggle occlusion culling")) {
+        getRenderer()->toggleOcclusionCulling();
+      }
+      if (ImGui::Button("Toggle depth pre-pass")) {
+        getRenderer()->toggleDepthPrepass();
+      }
+      if (ImGui::Button("Toggle per-object light lists")) {
+        const bool perObject = getRenderer()->getLightAssignment() == Renderer::LightAssignment::PerObject;
+        getRenderer()->setLightAssignment(perObject ? Renderer::LightAssignment::Clustered : Renderer::LightAssignment::PerObject);
+      }
+      if (ImGui::Button("Toggle deferred shading")) {
+        const bool deferred = getRenderer()->getRenderPath() == Renderer::RenderPath::Deferred;
+        getRenderer()->setRenderPath(deferred ? Renderer::RenderPath::Forward : Renderer::RenderPath::Deferred);
+      }
+
+      int latency = (int)getFrameLatency();
+      if (ImGui::SliderInt("Frame latency", &latency, 0, Renderer::MaxFrameLatency)) {
+        setFrameLatency((uint32_t)latency);
+      }
+    }
+
+    if (ImGui::CollapsingHeader("Render graph")) {
+      for (const auto& timing : getRenderer()->getPassTimings()) {
+        if (timing.culled) {
+          ImGui::TextDisabled("%-16s culled", timing.name.c_str());
+        }
+        else {
+          ImGui::Text("%-16s CPU %.3f ms | GPU %.3f ms", timing.name.c_str(), timing.cpuMs, timing.gpuMs);
+        }
+      }
+      ImGui::Text("Pooled targets %d", getRenderer()->getPooledTargetCount());
+    }
+
+    if (ImGui::CollapsingHeader("Job system")) {
+      ImGui::Text("Workers %d", getJobSystem()->getWorkerCount());
+      if (ImGui::Button("Run benchmark")) {
+        // Render thread stopped so it does not compete for the workers
+        runWithGraphicsContext([this]() { _jobBenchmarkResults = JobBenchmark::run(*getJobSystem()); });
+      }
+
+      for (const auto& result : _jobBenchmarkResults) {
+        ImGui::Text("%2d threads | run %6.1f ns/job | parallelFor %6.2f us | workload %7.3f ms (%.2fx)",
+          result.threads, result.runNs, result.parallelForUs, result.workloadMs, result.speedup);
+      }
+    }
+
+    if (ImGui::CollapsingHeader("SIMD math")) {
+      ImGui::Text("Supported %s", SimdMath::getLevelName(SimdMath::getSupportedLevel()));
+
+      int level = (int)SimdMath::getLevel();
+      if (ImGui::SliderInt("Level", &level, 0, (int)SimdMath::getSupportedLevel(), SimdMath::getLevelName((SimdMath::Level)level))) {
+        // Kernels are also used by the recorder workers
+        runWithGraphicsContext([level]() { SimdMath::setLevel((SimdMath::Level)level); });
+      }
+
+      if (ImGui::Button("Run SIMD benchmark")) {
+        runWithGraphicsContext([this]() { _simdBenchmarkResults = SimdBenchmark::run(); });
+      }
+
+      for (const auto& result : _simdBenchmarkResults) {
+        ImGui::Text("%-13s | glm %7.3f ms | scalar %7.3f ms | SSE2 %7.3f ms | AVX2 %7.3f ms | error %g",
+          result.kernel, result.glmMs, result.levelMs[0], result.levelMs[1], result.levelMs[2], result.maxError);
+      }
+    }
+
+    if (ImGui::CollapsingHeader("Recording")) {
+      const char* formats[] = { "Y4M", "PNG", "JPEG" };
+      ImGui::SliderInt("Every Nth frame", &_recordInterval, 1, 10);
+      ImGui::Combo("Format", &_recordFormat, formats, IM_ARRAYSIZE(formats));
+
+      if (!getRenderer()->isRecording() && ImGui::Button("Start recording")) {
+        getRenderer()->startRecording((uint32_t)_recordInterval, (FrameRecorder::Format)_recordFormat);
+      }
+      if (getRenderer()->isRecording() && ImGui::Button("Stop recording")) {
+        getRenderer()->stopRecording();
+      }
+
+      const auto& stats = getRenderer()->getStats();
+      ImGui::Text("Captured %d frames | %.1f fps | waited %.1f ms | dropped %d", stats.recordedFrames, stats.recordFps, stats.recordWaitMs, stats.recordDropped);
     }
 
     _scene->onGUI();
@@ -175,7 +287,21 @@ void SandboxApp::onGUI() {
       _camera.position.x, _camera.position.y, _camera.position.z,
       _camera.pitch, _camera.yaw, _camera.fov
     );
-    ImGui::Text("Drawcalls main=%d shadow=%d total=%d", stats.drawcalls, stats.drawcallsShadows, stats.drawcalls+stats.drawcallsShadows);
+    ImGui::Text("Drawcalls main=%d shadow=%d total=%d", stats.drawcalls, stats.drawcallsShadows, stats.drawcalls+stats.drawcallsShadows+stats.drawcallsPrepass);
+    ImGui::Text("Draw items %d | Multi-draw %s | Record threads %d", stats.drawItems, getRenderer()->isMultiDrawEnabled() ? "ON" : "OFF", stats.recordThreads);
+    ImGui::Text("Culled items %d | GPU culling %s", stats.culledItems, getRenderer()->isGPUCullingEnabled() ? "ON" : "OFF");
+    ImGui::Text("Visible items %d | Occluded %d (occluders %d) | Occlusion %s", stats.visibleItems, stats.occludedItems, stats.occluders, getRenderer()->isOcclusionCullingEnabled() ? "ON" : "OFF");
+    ImGui::Text("GPU shadow %.3f ms | pre-pass %.3f ms (%d draws, %s) | main %.3f ms", stats.gpuShadowMs, stats.gpuPrepassMs, stats.drawcallsPrepass, getRenderer()->isDepthPrepassEnabled() ? "ON" : "OFF", stats.gpuMainMs);
+    ImGui::Text("Point lights %d | Cluster light indices %d | Object lights %d", stats.pointlights, stats.lightIndices, stats.objectLights);
+    ImGui::Text("Render path %s | Deferred items %d", getRenderer()->getRenderPath() == Renderer::RenderPath::Deferred ? "Deferred" : "Forward", stats.deferredItems);
+    ImGui::Text("Text glyphs %d | upload %.1f KB | runs %d (laid out %d)", stats.glyphs, stats.glyphs * sizeof(GlyphInstance) / 1024.0f, stats.textRuns, stats.textLayouts);
+    ImGui::Text("Font atlas glyphs %d | uploads %d", stats.atlasGlyphs, stats.atlasUploads);
+    ImGui::Text("Text stream %s | stalls %d", stats.streamPersistent ? "persistent" : "unsynchronized", stats.streamStalls);
+    ImGui::Text(
+      "Resources meshes %d | materials %d | textures %d | pending destroy %d",
+      ResourcePool<Mesh>::Get().getAliveCount(), ResourcePool<Material>::Get().getAliveCount(), ResourcePool<Texture>::Get().getAliveCount(),
+      ResourcePool<Mesh>::Get().getPendingCount() + ResourcePool<Material>::Get().getPendingCount() + ResourcePool<Texture>::Get().getPendingCount()
+    );
     ImGui::Text("Frame time %.3f ms (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
     ImGui::End();
@@ -185,24 +311,55 @@ void SandboxApp::onGUI() {
 void SandboxApp::changeScene(uint32_t id) {
   if (_selectedScene == id) return;
 
-  if (id == SCENE_PLAYGROUND) {
-    _scene.reset(new ScenePlayground(*getAssetManager()));
-    _scene->init();
-    _selectedScene = id;
+  // Scenes create and release GL resources, the render thread hands the context over meanwhile
+  runWithGraphicsContext([this, id]() {
+    if (id == SCENE_PLAYGROUND) {
+      _scene.reset(new ScenePlayground(*getAssetManager()));
+      _scene->init();
+      _selectedScene = id;
 
-    _camera.position = glm::vec3(0.0f, 3.5f, 6.0f);
-    _camera.pitch = -20.0f;
-    _camera.yaw = 0.0f;
-  }
-  else if (id == SCENE_CUBEMAPS) {
-    _scene.reset(new SceneCubemaps(*getAssetManager()));
-    _scene->init();
-    _selectedScene = id;
-
-    _camera.position = glm::vec3(2.76f, 0.84f, 5.54f);
-    _camera.pitch = 4.6f;
-    _camera.yaw = 19.0f;
-  }
+      _camera.position = glm::vec3(0.0f, 3.5f, 6.0f);
+      _camera.pitch = -20.0f;
+      _camera.yaw = 0.0f;
+    }
+    else if (id == SCENE_CUBEMAPS) {
+      _scene.reset(new SceneCubemaps(*getAssetManager()));
+      _scene->init();
+      _selectedScene = id;
+
+      _camera.position = glm::vec3(2.76f, 0.84f, 5.54f);
+      _camera.pitch = 4.6f;
+      _camera.yaw = 19.0f;
+    }
+    else if (id == SCENE_CULLING) {
+      _scene.reset();
+      _scene.reset(new SceneCulling(*getAssetManager(), *getRenderer()));
+      _scene->init();
+      _selectedScene = id;
+
+      _camera.position = glm::vec3(0.0f, 12.0f, 20.0f);
+      _camera.pitch = -25.0f;
+      _camera.yaw = 0.0f;
+    }
+    else if (id == SCENE_LIGHTS) {
+      _scene.reset(new SceneLights(*getAssetManager()));
+      _scene->init();
+      _selectedScene = id;
+
+      _camera.position = glm::vec3(0.0f, 10.0f, 22.0f);
+      _camera.pitch = -30.0f;
+      _camera.yaw = 0.0f;
+    }
+    else if (id == SCENE_STRESS) {
+      _scene.reset(new SceneStress(*getAssetManager(), *getJobSystem()));
+      _scene->init();
+      _selectedScene = id;
+
+      _camera.position = glm::vec3(0.0f, 30.0f, 60.0f);
+      _camera.pitch = -35.0f;
+      _camera.yaw = 0.0f;
+    }
+  });
 }
 
 void SandboxApp::setInputFlag(uint32_t flag, bool set) {
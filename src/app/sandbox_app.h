@@ -2,6 +2,8 @@
 
 #include "core/application.h"
 #include "demos/scene.h"
+#include "utils/job_benchmark.h"
+#include "utils/simd_benchmark.h"
 
 class SandboxApp: public Application {
 private:
@@ -77,4 +79,10 @@ private:
 
   std::unique_ptr<Scene> _scene;
   uint32_t               _selectedScene;
+  uint32_t               _requestedScene;
+
+  std::vector<JobBenchmark::Result>  _jobBenchmarkResults;
+  std::vector<SimdBenchmark::Result> _simdBenchmarkResults;
+  int _recordInterval;
+  int _recordFormat;
 };
@@ -6,7 +6,8 @@ Entity::Entity() {
   _rotation = glm::identity<glm::quat>();
   _scale = glm::vec3(1.0f);
   _flags = 0;
-  updateWorldTM();
+  _worldTM = glm::mat4(1.0f);
+  _worldTMDirty = false;
 }
 
 void Entity::setFlag(Flags flag, bool set) {
@@ -22,17 +23,33 @@ bool Entity::hasFlag(Flags flag) const {
 
 void Entity::setPosition(const glm::vec3& position) {
   _position = position;
-  updateWorldTM();
+  _worldTMDirty = true;
+
+  if (_light)
+    _light->position = _position;
 }
 
 void Entity::setRotation(const glm::quat& rotation) {
   _rotation = rotation;
-  updateWorldTM();
+  _worldTMDirty = true;
 }
 
 void Entity::setScale(const glm::vec3& scale) {
   _scale = scale;
-  updateWorldTM();
+  _worldTMDirty = true;
+}
+
+const glm::mat4& Entity::getWorldTM() const {
+  if (_worldTMDirty) {
+    auto s = glm::scale(glm::mat4(1.0f), _scale);
+    auto r = glm::toMat4(_rotation);
+    auto t = glm::translate(glm::mat4(1.0f), _position);
+
+    _worldTM = t * r * s;
+    _worldTMDirty = false;
+  }
+
+  return _worldTM;
 }
 
 void Entity::attachModel(GfxModelRef model) {
@@ -45,10 +62,12 @@ void Entity::attachLight(const Light::Properties& properties) {
   _light->properties = properties;
 }
 
-void Entity::cloneModelMaterial() {
+MaterialRef Entity::cloneModelMaterial() {
   if (_model) {
     _overrideMaterial = Material::Clone(_model->getMaterial());
   }
+
+  return _overrideMaterial;
 }
 
 void Entity::setOverrideMaterial(MaterialRef material) {
@@ -72,10 +91,11 @@ void Entity::render(Renderer& renderer) {
   }
 
   if (_model) {
-    MaterialRef material = _overrideMaterial ? _overrideMaterial : _model->getMaterial();
+    const MaterialRef& material = _overrideMaterial ? _overrideMaterial : _model->getMaterial();
     for (uint32_t idx = 0; idx < _model->getMeshCount(); ++idx) {
       uint32_t drawFlags = hasFlag(Entity::Flags::RenderShadow) ? DrawFlags_Shadow : DrawFlags_None;
-      renderer.drawMesh(_model->getMesh(idx), material, _worldTM, drawFlags);
+      drawFlags |= hasFlag(Entity::Flags::NoCulling) ? DrawFlags_NoCulling : DrawFlags_None;
+      renderer.drawMesh(_model->getMesh(idx), material, getWorldTM(), drawFlags);
     }
   }
 
@@ -83,14 +103,3 @@ void Entity::render(Renderer& renderer) {
     renderer.drawText(_name, _position + glm::vec3(0.0f, 0.0f, 0.2f));
   }
 }
-
-void Entity::updateWorldTM() {
-  auto s = glm::scale(glm::mat4(1.0f), _scale);
-  auto r = glm::toMat4(_rotation);
-  auto t = glm::translate(glm::mat4(1.0f), _position);
-
-  _worldTM = t * r * s;
-
-  if (_light)
-    _light->position = _position;
-}
@@ -10,7 +10,8 @@ public:
   enum class Flags: uint32_t {
     Hidden = BIT(0),
     DisplayName = BIT(1),
-    RenderShadow = BIT(2)
+    RenderShadow = BIT(2),
+    NoCulling = BIT(3)
   };
 
   Entity();
@@ -22,6 +23,8 @@ public:
   glm::vec3 getPosition() const { return _position; }
   glm::quat getRotation() const { return _rotation; }
   glm::vec3 getScale() const { return _scale; }
+  // Recomputed on first use after the transform changed
+  const glm::mat4& getWorldTM() const;
 
   void setFlag(Flags flag, bool set);
   bool hasFlag(Flags flag) const;
@@ -31,16 +34,15 @@ public:
 
   void attachModel(GfxModelRef model);
   void attachLight(const Light::Properties& properties);
+  GfxModelRef getModel() const { return _model; }
 
-  void cloneModelMaterial();
+  // Models and materials are only referenced, the clone is owned by the caller
+  MaterialRef cloneModelMaterial();
   void setOverrideMaterial(MaterialRef material);
   MaterialRef getModelMaterial() const;
 
   void render(Renderer& renderer);
 
-private:
-  void updateWorldTM();
-
 private:
   std::string _name;
 
@@ -52,5 +54,7 @@ private:
   glm::vec3   _position;
   glm::quat   _rotation;
   glm::vec3   _scale;
-  glm::mat4   _worldTM;
+
+  mutable glm::mat4 _worldTM;
+  mutable bool      _worldTMDirty;
 };
@@ -0,0 +1,81 @@
+#include "job_benchmark.h"
+
+#include <SDL.h>
+
+#define BENCHMARK_EMPTY_JOBS 20000
+#define BENCHMARK_PARALLEL_FORS 2000
+#define BENCHMARK_WORKLOAD_ITEMS (1 << 18)
+#define BENCHMARK_WORKLOAD_BATCH 256
+#define BENCHMARK_REPEATS 5
+
+namespace JobBenchmark {
+  static double elapsedMs(uint64_t start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+  }
+
+  static float workloadItem(uint32_t i) {
+    glm::vec3 v((float)i, 1.0f, 0.5f);
+    for (int k = 0; k < 32; ++k) {
+      v = glm::vec3(std::sin(v.y) + v.z, std::cos(v.x) * 0.5f, v.x * 0.25f + v.y);
+    }
+
+    return v.x + v.y + v.z;
+  }
+
+  std::vector<Result> run(JobSystem& jobSystem) {
+    std::vector<Result> results;
+    std::vector<float> output(BENCHMARK_WORKLOAD_ITEMS);
+
+    const uint32_t restoreWorkers = jobSystem.getActiveWorkers();
+
+    for (uint32_t workers = 0; workers <= jobSystem.getWorkerCount(); ++workers) {
+      jobSystem.setActiveWorkers(workers);
+
+      Result result = {};
+      result.threads = workers + 1;
+
+      // Best of several repeats, the first ones also warm up sleeping workers
+      double runMs = std::numeric_limits<double>::max();
+      double parallelForMs = std::numeric_limits<double>::max();
+      double workloadMs = std::numeric_limits<double>::max();
+
+      for (int repeat = 0; repeat < BENCHMARK_REPEATS; ++repeat) {
+        uint64_t start = SDL_GetPerformanceCounter();
+        JobCounter counter;
+        for (uint32_t i = 0; i < BENCHMARK_EMPTY_JOBS; ++i) {
+          jobSystem.run([]() {}, &counter);
+        }
+        jobSystem.wait(counter);
+        runMs = std::min(runMs, elapsedMs(start));
+
+        start = SDL_GetPerformanceCounter();
+        for (uint32_t i = 0; i < BENCHMARK_PARALLEL_FORS; ++i) {
+          jobSystem.parallelFor(result.threads * 4, 1, [](uint32_t, uint32_t) {});
+        }
+        parallelForMs = std::min(parallelForMs, elapsedMs(start));
+
+        start = SDL_GetPerformanceCounter();
+        jobSystem.parallelFor(BENCHMARK_WORKLOAD_ITEMS, BENCHMARK_WORKLOAD_BATCH, [&output](uint32_t begin, uint32_t end) {
+          for (uint32_t i = begin; i < end; ++i) {
+            output[i] = workloadItem(i);
+          }
+        });
+        workloadMs = std::min(workloadMs, elapsedMs(start));
+      }
+
+      result.runNs = (float)(runMs * 1.0e6 / BENCHMARK_EMPTY_JOBS);
+      result.parallelForUs = (float)(parallelForMs * 1.0e3 / BENCHMARK_PARALLEL_FORS);
+      result.workloadMs = (float)workloadMs;
+      result.speedup = results.empty() ? 1.0f : results.front().workloadMs / result.workloadMs;
+
+      LOG_INFO("[JobBenchmark] {} threads: run {:.1f} ns/job, parallelFor {:.2f} us, workload {:.3f} ms ({:.2f}x)",
+        result.threads, result.runNs, result.parallelForUs, result.workloadMs, result.speedup);
+
+      results.push_back(result);
+    }
+
+    jobSystem.setActiveWorkers(restoreWorkers);
+
+    return results;
+  }
+}
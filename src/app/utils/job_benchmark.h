@@ -0,0 +1,16 @@
+#pragma once
+
+#include "core/job_system.h"
+
+// Scheduling overhead and scaling of the job system, run once per thread count from 1 to all workers
+namespace JobBenchmark {
+  struct Result {
+    uint32_t threads;
+    float    runNs;         // Per empty job, run + wait
+    float    parallelForUs; // Per empty parallelFor split over every thread
+    float    workloadMs;    // parallelFor over a fixed ALU-bound workload
+    float    speedup;       // Workload time with one thread / workloadMs
+  };
+
+  std::vector<Result> run(JobSystem& jobSystem);
+}
@@ -161,6 +161,7 @@ namespace MeshUtils {
           { glm::vec3(-1.0f, -1.0f,  1.0f) },
           { glm::vec3( 1.0f, -1.0f,  1.0f) }
         };
+        params.buildPositionStream = false;
 
         return Mesh::Create(params);
     }
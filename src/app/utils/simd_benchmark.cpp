@@ -0,0 +1,186 @@
+#include "simd_benchmark.h"
+
+#include <SDL.h>
+
+#define BENCHMARK_ITEMS (1 << 16)
+#define BENCHMARK_REPEATS 5
+
+namespace SimdBenchmark {
+  static double elapsedMs(uint64_t start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+  }
+
+  // Deterministic values in [-1, 1]
+  static float noise(uint32_t i, uint32_t channel) {
+    uint32_t h = i * 747796405u + channel * 2891336453u;
+    h = ((h >> ((h >> 28) + 4)) ^ h) * 277803737u;
+    h = (h >> 22) ^ h;
+
+    return (float)h / (float)std::numeric_limits<uint32_t>::max() * 2.0f - 1.0f;
+  }
+
+  static float maxDifference(const glm::mat4& a, const glm::mat4& b) {
+    float error = 0.0f;
+    for (int column = 0; column < 4; ++column) {
+      const glm::vec4 d = glm::abs(a[column] - b[column]);
+      error = std::max(error, std::max(std::max(d.x, d.y), std::max(d.z, d.w)));
+    }
+
+    return error;
+  }
+
+  // Best of several repeats
+  template<typename Fn>
+  static float measure(Fn fn) {
+    double best = std::numeric_limits<double>::max();
+    for (int repeat = 0; repeat < BENCHMARK_REPEATS; ++repeat) {
+      const uint64_t start = SDL_GetPerformanceCounter();
+      fn();
+      best = std::min(best, elapsedMs(start));
+    }
+
+    return (float)best;
+  }
+
+  // Times fn at every supported level and returns the worst error reported by check
+  template<typename Fn, typename CheckFn>
+  static void measureLevels(Result& result, Fn fn, CheckFn check) {
+    const SimdMath::Level restore = SimdMath::getLevel();
+
+    result.maxError = 0.0f;
+    for (int level = 0; level < LevelCount; ++level) {
+      if (level > (int)SimdMath::getSupportedLevel()) {
+        result.levelMs[level] = -1.0f;
+        continue;
+      }
+
+      SimdMath::setLevel((SimdMath::Level)level);
+      result.levelMs[level] = measure(fn);
+      result.maxError = std::max(result.maxError, check());
+    }
+
+    SimdMath::setLevel(restore);
+  }
+
+  std::vector<Result> run() {
+    const uint32_t count = BENCHMARK_ITEMS;
+
+    std::vector<glm::vec3> positions(count);
+    std::vector<glm::quat> rotations(count);
+    std::vector<glm::vec3> scales(count);
+    std::vector<uint32_t> parents(count);
+    std::vector<AABB> boxes(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      positions[i] = glm::vec3(noise(i, 0), noise(i, 1), noise(i, 2)) * 50.0f;
+      rotations[i] = glm::normalize(glm::quat(noise(i, 3), noise(i, 4), noise(i, 5), noise(i, 6)));
+      scales[i] = glm::vec3(1.0f) + glm::vec3(noise(i, 7), noise(i, 8), noise(i, 9)) * 0.5f;
+      parents[i] = (uint32_t)((noise(i, 10) * 0.5f + 0.5f) * (count - 1));
+
+      const glm::vec3 extents = glm::vec3(1.0f) + glm::abs(glm::vec3(noise(i, 11), noise(i, 12), noise(i, 13)));
+      boxes[i] = AABB(positions[i] - extents, positions[i] + extents);
+    }
+
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const glm::mat4 viewProjection = projection * view;
+    const glm::vec4 viewport(0.0f, 0.0f, 1920.0f, 1080.0f);
+    const Frustum frustum = Frustum::FromMatrix(viewProjection);
+
+    std::vector<glm::mat4> expectedTMs(count), tms(count);
+    std::vector<uint8_t> expectedVisible(count), visible(count);
+    std::vector<glm::vec3> expectedPoints(count), points(count);
+
+    std::vector<Result> results;
+
+    // Local matrices
+    {
+      Result result = { "composeTRS" };
+      result.glmMs = measure([&]() {
+        for (uint32_t i = 0; i < count; ++i) {
+          expectedTMs[i] = glm::translate(glm::mat4(1.0f), positions[i]) * glm::toMat4(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+        }
+      });
+      measureLevels(result,
+        [&]() { SimdMath::composeTRS(positions.data(), rotations.data(), scales.data(), tms.data(), count); },
+        [&]() {
+          float error = 0.0f;
+          for (uint32_t i = 0; i < count; ++i) {
+            error = std::max(error, maxDifference(expectedTMs[i], tms[i]));
+          }
+          return error;
+        });
+      results.push_back(result);
+    }
+
+    // Parent multiply, expectedTMs are the local matrices from above
+    {
+      std::vector<glm::mat4> expectedWorld(count), world(count);
+
+      Result result = { "multiply" };
+      result.glmMs = measure([&]() {
+        for (uint32_t i = 0; i < count; ++i) {
+          expectedWorld[i] = expectedTMs[parents[i]] * expectedTMs[i];
+        }
+      });
+      measureLevels(result,
+        [&]() { SimdMath::multiply(expectedTMs.data(), parents.data(), expectedTMs.data(), world.data(), count); },
+        [&]() {
+          float error = 0.0f;
+          for (uint32_t i = 0; i < count; ++i) {
+            error = std::max(error, maxDifference(expectedWorld[i], world[i]));
+          }
+          return error;
+        });
+      results.push_back(result);
+    }
+
+    // Frustum culling
+    {
+      Result result = { "testAABBs" };
+      result.glmMs = measure([&]() {
+        for (uint32_t i = 0; i < count; ++i) {
+          expectedVisible[i] = frustum.intersects(boxes[i]) ? 1 : 0;
+        }
+      });
+      measureLevels(result,
+        [&]() { SimdMath::testAABBs(frustum, boxes.data(), count, visible.data()); },
+        [&]() {
+          uint32_t mismatches = 0;
+          for (uint32_t i = 0; i < count; ++i) {
+            mismatches += expectedVisible[i] != visible[i] ? 1 : 0;
+          }
+          return (float)mismatches;
+        });
+      results.push_back(result);
+    }
+
+    // Screen projection, error in pixels
+    {
+      Result result = { "projectPoints" };
+      result.glmMs = measure([&]() {
+        for (uint32_t i = 0; i < count; ++i) {
+          expectedPoints[i] = glm::project(positions[i], view, projection, viewport);
+        }
+      });
+      measureLevels(result,
+        [&]() { SimdMath::projectPoints(viewProjection, viewport, positions.data(), points.data(), count); },
+        [&]() {
+          float error = 0.0f;
+          for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec3 d = glm::abs(expectedPoints[i] - points[i]);
+            error = std::max(error, std::max(d.x, d.y));
+          }
+          return error;
+        });
+      results.push_back(result);
+    }
+
+    for (const auto& result : results) {
+      LOG_INFO("[SimdBenchmark] {}: glm {:.3f} ms, scalar {:.3f} ms, SSE2 {:.3f} ms, AVX2 {:.3f} ms, max error {}",
+        result.kernel, result.glmMs, result.levelMs[0], result.levelMs[1], result.levelMs[2], result.maxError);
+    }
+
+    return results;
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "core/simd_math.h"
+
+// Batch kernels against the glm code they replace, run once per supported level
+namespace SimdBenchmark {
+  enum {
+    LevelCount = 3,
+  };
+
+  struct Result {
+    const char* kernel;
+    float glmMs;
+    float levelMs[LevelCount]; // Negative when the level is not supported
+    float maxError;            // Largest difference against glm over every level, mismatches for culling
+  };
+
+  std::vector<Result> run();
+}
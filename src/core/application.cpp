@@ -1,5 +1,6 @@
 #include "application.h"
 #include "input.h"
+#include "simd_math.h"
 
 #include <imgui.h>
 #include "imgui/imgui_impl_sdl.h"
@@ -8,13 +9,20 @@
 #include <SDL.h>
 
 Application::Application()
-  : _running(true) {
+  : _running(true)
+  , _frameLatency(0)
+  , _requestedFrameLatency(0) {
 }
 
 Application::~Application() {
 }
 
 bool Application::init(const WindowDesc& desc) {
+  SimdMath::init();
+
+  _jobSystem.reset(new JobSystem());
+  _jobSystem->init();
+
   _window.reset(new Window(desc));
   if (!_window->init()) {
     LOG_ERROR("[Application] Failed to initialize window");
@@ -29,7 +37,7 @@ bool Application::init(const WindowDesc& desc) {
   );
 
   _renderer.reset(new Renderer());
-  _renderer->init(_window->getWidth(), _window->getHeight());
+  _renderer->init(_window->getWidth(), _window->getHeight(), *_jobSystem);
 
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
@@ -38,8 +46,10 @@ bool Application::init(const WindowDesc& desc) {
   ImGui_ImplSDL2_InitForOpenGL(_window->getWindow(), _window->getGLContext());
   ImGui_ImplOpenGL3_Init("#version 150");
 
+  _renderThread.reset(new RenderThread(*_window, *_renderer, *_jobSystem));
+
   _assetManager.reset(new AssetManager());
-  _assetManager->init();
+  _assetManager->init(*_jobSystem);
 
   if (!onInit()) {
     LOG_ERROR("[Application] Failed to initialize application");
@@ -51,11 +61,19 @@ bool Application::init(const WindowDesc& desc) {
 }
 
 void Application::shutdown() {
+  _renderThread->stop();
+
   onShutdown();
 
+  // Loaded assets first, the renderer releases every pooled resource left on destruction
+  _assetManager.reset();
+  _renderer.reset();
+
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplSDL2_Shutdown();
   ImGui::DestroyContext();
+
+  _jobSystem->shutdown();
 }
 
 void Application::run() {
@@ -82,10 +100,46 @@ void Application::run() {
     onGUI();
 
     _renderer->endFrame();
-    _window->update();
+
+    if (_renderThread->isRunning()) {
+      _renderThread->submit();
+    }
+    else {
+      _renderer->renderFrame();
+      _window->update();
+    }
+
+    applyFrameLatency();
   }
 }
 
+void Application::runWithGraphicsContext(const std::function<void()>& fn) {
+  if (!_renderThread->isRunning()) {
+    fn();
+    return;
+  }
+
+  _renderThread->stop();
+  fn();
+  _renderThread->start(_frameLatency);
+}
+
+void Application::applyFrameLatency() {
+  const uint32_t latency = std::min(_requestedFrameLatency, (uint32_t)Renderer::MaxFrameLatency);
+  if (latency == _frameLatency)
+    return;
+
+  // Frames queued with the previous latency are rendered before the ring is resized
+  _renderThread->stop();
+  _renderer->setFrameLatency(latency);
+  if (latency > 0) {
+    _renderThread->start(latency);
+  }
+
+  _frameLatency = latency;
+  LOG_INFO("[Application] Frame latency {}", latency);
+}
+
 void Application::checkSystemEvents() {
   const int maxEvents = 16;
   SDL_Event events[maxEvents];
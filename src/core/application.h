@@ -1,9 +1,11 @@
 #pragma once
 
 #include "input.h"
+#include "job_system.h"
 #include "renderer.h"
 #include "asset_manager.h"
 #include "window.h"
+#include "render_thread.h"
 
 struct UpdateContext {
   UpdateContext(float _frameTime, uint32_t _frameId)
@@ -28,6 +30,15 @@ protected:
   Window*   getWindow() const { return _window.get(); };
   Renderer* getRenderer() const { return _renderer.get(); }
   AssetManager* getAssetManager() const { return _assetManager.get(); }
+  JobSystem* getJobSystem() const { return _jobSystem.get(); }
+
+  // Frames the update thread may run ahead of rendering, 0 renders on the update thread. Applied between frames.
+  void setFrameLatency(uint32_t latency) { _requestedFrameLatency = latency; }
+  uint32_t getFrameLatency() const { return _frameLatency; }
+
+  // Runs fn with the GL context current on the calling thread, needed to create or release GL resources
+  // from the update thread while frames are rendered on the render thread
+  void runWithGraphicsContext(const std::function<void()>& fn);
 
   // To be implemented by custom application
   virtual bool onInit() = 0;
@@ -39,14 +50,19 @@ protected:
 
 private:
   void checkSystemEvents();
+  void applyFrameLatency();
 
 private:
+  std::unique_ptr<JobSystem> _jobSystem;
   std::unique_ptr<Window> _window;
   std::unique_ptr<Input> _input;
   std::unique_ptr<Renderer> _renderer;
   std::unique_ptr<AssetManager> _assetManager;
+  std::unique_ptr<RenderThread> _renderThread;
 
   bool     _running;
+  uint32_t _frameLatency;
+  uint32_t _requestedFrameLatency;
 };
 
 typedef std::function<Application* ()> ApplicationCreator;
@@ -27,43 +27,27 @@ namespace JsonHelper {
     return color;
   }
 
-  void readIllumPongShaderParameters(const Json::Value& root, MaterialRef material) {
-    char textureFile[128];
+  const char* TEXTURE_MAPS[] = { "diffuse", "specular", "normal" };
+  const char* TEXTURE_UNIFORMS[] = { "material.texture_diffuse", "material.texture_specular", "material.texture_normal" };
 
-    if (root["texture_maps"].isObject()){
-      std::string diffuseTexture = JsonHelper::readString(root["texture_maps"], "diffuse", "");
-      std::string specularTexture = JsonHelper::readString(root["texture_maps"], "specular", "");
-      std::string normalTexture = JsonHelper::readString(root["texture_maps"], "normal", "");
+  std::string readTextureMap(const Json::Value& root, uint32_t index) {
+    if (!root["texture_maps"].isObject())
+      return std::string();
 
-      if (diffuseTexture.length() > 0) {
-        snprintf(textureFile, sizeof(textureFile), "materials/%s", diffuseTexture.c_str());
-
-        LOG_INFO("[AssetManager] Loading texture {}", textureFile);
-
-        TextureCreateParams params;
-        params.filePath = textureFile;
-        material->setTextureSlot(MaterialSlotId_0, "material.texture_diffuse", Texture::Create(params));
-      }
-
-      if (specularTexture.length() > 0) {
-        snprintf(textureFile, sizeof(textureFile), "materials/%s", specularTexture.c_str());
-
-        LOG_INFO("[AssetManager] Loading texture {}", textureFile);
-
-        TextureCreateParams params;
-        params.filePath = textureFile;
-        material->setTextureSlot(MaterialSlotId_1, "material.texture_specular", Texture::Create(params));
-      }
+    return JsonHelper::readString(root["texture_maps"], TEXTURE_MAPS[index], "");
+  }
 
-      if (normalTexture.length() > 0) {
-        snprintf(textureFile, sizeof(textureFile), "materials/%s", normalTexture.c_str());
+  void readIllumPongShaderParameters(const Json::Value& root, const ImageData* textures, uint32_t textureCount, MaterialRef material, std::vector<TextureRef>& created) {
+    for (uint32_t i = 0; i < textureCount; ++i) {
+      if (textures[i].data.empty())
+        continue;
 
-        LOG_INFO("[AssetManager] Loading texture {}", textureFile);
+      TextureCreateParams params;
+      params.image = &textures[i];
 
-        TextureCreateParams params;
-        params.filePath = textureFile;
-        material->setTextureSlot(MaterialSlotId_2, "material.texture_normal", Texture::Create(params));
-      }
+      TextureRef texture = Texture::Create(params);
+      material->setTextureSlot((MaterialSlotId)(MaterialSlotId_0 + i), TEXTURE_UNIFORMS[i], texture);
+      created.push_back(texture);
     }
 
     if (root["properties"].isObject()){
@@ -93,9 +77,8 @@ namespace JsonHelper {
 // Assimp Helper
 
 namespace AssimpHelper {
-  MeshRef processMesh(aiMesh *mesh, const aiScene *scene) {
-    MeshCreateParams params;
-    params.vertices.reserve(512);
+  void processMesh(aiMesh *mesh, const aiScene *scene, MeshCreateParams& params) {
+    params.vertices.reserve(mesh->mNumVertices);
     params.indices.reserve(512);
 
     for(unsigned int i = 0; i < mesh->mNumVertices; i++) {
@@ -127,14 +110,11 @@ namespace AssimpHelper {
       for(unsigned int j = 0; j < face.mNumIndices; j++)
         params.indices.push_back(face.mIndices[j]);
     }
-
-    return Mesh::Create(params);
   }
 
-  void processNode(aiNode *node, const aiScene *scene, std::vector<MeshRef>& meshes) {
+  void processNode(aiNode *node, const aiScene *scene, std::vector<aiMesh*>& meshes) {
     for(unsigned int i = 0; i < node->mNumMeshes; i++) {
-      aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-      meshes.push_back(processMesh(mesh, scene));
+      meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
 
     for(unsigned int i = 0; i < node->mNumChildren; i++) {
@@ -145,13 +125,29 @@ namespace AssimpHelper {
 
 // AssetManager
 
-AssetManager::AssetManager() {
+AssetManager::AssetManager()
+  : _jobSystem(nullptr) {
 }
 
 AssetManager::~AssetManager() {
+  // Everything loaded here is owned here, destruction is deferred until the GPU is done with it
+  for (const auto& entry : _models) {
+    GfxModel::Destroy(entry.second);
+  }
+  for (const auto& entry : _materials) {
+    Material::Destroy(entry.second);
+  }
+  for (auto texture : _textures) {
+    Texture::Destroy(texture);
+  }
+  for (const auto& entry : _shaders) {
+    Shader::Destroy(entry.second);
+  }
 }
 
-void AssetManager::init() {
+void AssetManager::init(JobSystem& jobSystem) {
+  _jobSystem = &jobSystem;
+
   const uint32_t SHADER_COUNT = 4;
   const char* SHADERS[SHADER_COUNT] = {
     "color",
@@ -164,6 +160,10 @@ void AssetManager::init() {
     loadShader(SHADERS[i]);
   }
 
+  // Variants writing the G-buffer for the deferred path
+  getShader("illum")->setGBufferVariant(loadShader("illum", "illum_gbuffer"));
+
+  std::vector<std::string> names;
   std::string path = FileUtils::getAbsolutePath("materials");
   for (const auto& file : std::filesystem::directory_iterator(path)) {
     if (file.is_directory())
@@ -172,8 +172,19 @@ void AssetManager::init() {
     if (file.path().extension().generic_string().compare(".mtl") != 0)
       continue;
 
-    auto name = FileUtils::removeExtension(file.path().filename().generic_string());
-    loadMaterial(name.c_str());
+    names.push_back(FileUtils::removeExtension(file.path().filename().generic_string()));
+  }
+
+  // Parsing and image decoding run as jobs, GL objects are created on this thread
+  std::vector<MaterialFile> files(names.size());
+  _jobSystem->parallelFor((uint32_t)names.size(), 1, [&names, &files](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      readMaterialFile(names[i].c_str(), files[i]);
+    }
+  });
+
+  for (size_t i = 0; i < names.size(); ++i) {
+    createMaterial(names[i].c_str(), files[i]);
   }
 
   _defaultMaterial = getMaterial("default");
@@ -217,12 +228,19 @@ GfxModelRef AssetManager::loadModel(const char* path) {
     return nullptr;
   }
 
-  std::vector<MeshRef> meshes;
+  std::vector<aiMesh*> meshes;
   AssimpHelper::processNode(scene->mRootNode, scene, meshes);
 
+  std::vector<MeshCreateParams> meshParams(meshes.size());
+  _jobSystem->parallelFor((uint32_t)meshes.size(), 1, [&meshes, &meshParams, scene](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      AssimpHelper::processMesh(meshes[i], scene, meshParams[i]);
+    }
+  });
+
   GfxModelRef model = GfxModel::Create();
-  for (auto mesh : meshes) {
-    model->addMesh(mesh);
+  for (const auto& params : meshParams) {
+    model->addMesh(Mesh::Create(params));
   }
   model->setMaterial(getMaterial(materialName.c_str()));
 
@@ -232,12 +250,17 @@ GfxModelRef AssetManager::loadModel(const char* path) {
 }
 
 ShaderRef AssetManager::loadShader(const char* name) {
+  return loadShader(name, name);
+}
+
+ShaderRef AssetManager::loadShader(const char* vertexName, const char* fragmentName) {
   char vertexShader[128];
   char fragmentShader[128];
 
-  snprintf(vertexShader, sizeof(vertexShader), "shaders/%s.vert", name);
-  snprintf(fragmentShader, sizeof(fragmentShader), "shaders/%s.frag", name);
+  snprintf(vertexShader, sizeof(vertexShader), "shaders/%s.vert", vertexName);
+  snprintf(fragmentShader, sizeof(fragmentShader), "shaders/%s.frag", fragmentName);
 
+  const char* name = fragmentName;
   LOG_INFO("[AssetManager] Loading shader {}", name);
 
   ShaderCreateParams shaderParams;
@@ -251,17 +274,34 @@ ShaderRef AssetManager::loadShader(const char* name) {
   return shader;
 }
 
-MaterialRef AssetManager::loadMaterial(const char* name) {
+/*static*/ void AssetManager::readMaterialFile(const char* name, MaterialFile& file) {
   char materialFile[128];
   snprintf(materialFile, sizeof(materialFile), "materials/%s.mtl", name);
 
   LOG_INFO("[AssetManager] Loading material {}", materialFile);
 
-  Json::Value root;
-  if (!FileUtils::readJsonFile(materialFile, root)) {
-    return nullptr;
+  file.valid = FileUtils::readJsonFile(materialFile, file.root);
+  if (!file.valid)
+    return;
+
+  char textureFile[128];
+  for (uint32_t i = 0; i < TextureMapCount; ++i) {
+    std::string texture = JsonHelper::readTextureMap(file.root, i);
+    if (texture.empty())
+      continue;
+
+    snprintf(textureFile, sizeof(textureFile), "materials/%s", texture.c_str());
+
+    LOG_INFO("[AssetManager] Loading texture {}", textureFile);
+    FileUtils::readImageFile(textureFile, file.textures[i]);
   }
+}
+
+MaterialRef AssetManager::createMaterial(const char* name, const MaterialFile& file) {
+  if (!file.valid)
+    return nullptr;
 
+  const auto& root = file.root;
   std::string shaderName = JsonHelper::readString(root, "shader", "");
   auto shader = getShader(shaderName.c_str());
 
@@ -276,7 +316,7 @@ MaterialRef AssetManager::loadMaterial(const char* name) {
     JsonHelper::readColorShaderParameters(root, material);
   }
   else if (shaderName.compare("illum")  == 0) {
-    JsonHelper::readIllumPongShaderParameters(root, material);
+    JsonHelper::readIllumPongShaderParameters(root, file.textures.data(), TextureMapCount, material, _textures);
   }
 
   _materials.insert_or_assign(std::string(name), material);
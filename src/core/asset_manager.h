@@ -1,20 +1,35 @@
 #pragma once
 
+#include "file_utils.h"
+#include "job_system.h"
 #include "graphics/material.h"
 #include "graphics/shader.h"
 #include "gfx_model.h"
 
+// Owns the shaders, materials, textures and models it loads. Handles it gives out stay valid
+// until the manager is destroyed.
 class AssetManager {
 private:
   typedef std::map<std::string, ShaderRef> Shaders;
   typedef std::map<std::string, MaterialRef> Materials;
   typedef std::map<std::string, GfxModelRef> Models;
 
+  enum {
+    TextureMapCount = 3 // diffuse, specular, normal
+  };
+
+  // Material file read and its textures decoded, everything but the GL objects
+  struct MaterialFile {
+    Json::Value root;
+    std::array<ImageData, TextureMapCount> textures;
+    bool valid;
+  };
+
 public:
   AssetManager();
   ~AssetManager();
 
-  void init();
+  void init(JobSystem& jobSystem);
 
   MaterialRef getDefaultMaterial() const { return _defaultMaterial; }
   MaterialRef getMaterial(const char* name) const;
@@ -24,12 +39,17 @@ public:
 
 private:
   ShaderRef   loadShader(const char* name);
-  MaterialRef loadMaterial(const char* name);
+  ShaderRef   loadShader(const char* vertexName, const char* fragmentName);
+  static void readMaterialFile(const char* name, MaterialFile& file);
+  MaterialRef createMaterial(const char* name, const MaterialFile& file);
 
 private:
+  JobSystem*  _jobSystem;
+
   Shaders     _shaders;
   Materials   _materials;
   Models      _models;
+  std::vector<TextureRef> _textures;
 
   MaterialRef _defaultMaterial;
 };
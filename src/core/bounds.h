@@ -0,0 +1,77 @@
+#pragma once
+
+struct AABB {
+  AABB()
+    : min(std::numeric_limits<float>::max())
+    , max(-std::numeric_limits<float>::max()) {
+  }
+
+  AABB(const glm::vec3& _min, const glm::vec3& _max)
+    : min(_min)
+    , max(_max) {
+  }
+
+  bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+  glm::vec3 center() const { return (min + max) * 0.5f; }
+  glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+  void expand(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+
+  AABB transform(const glm::mat4& tm) const {
+    const glm::vec3 c = glm::vec3(tm * glm::vec4(center(), 1.0f));
+    const glm::mat3 absTM = glm::mat3(glm::abs(glm::vec3(tm[0])), glm::abs(glm::vec3(tm[1])), glm::abs(glm::vec3(tm[2])));
+    const glm::vec3 e = absTM * extents();
+
+    return AABB(c - e, c + e);
+  }
+
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+struct Frustum {
+  enum {
+    PlaneCount = 6
+  };
+
+  // Planes (xyz normal pointing inside, w distance) extracted from a view-projection matrix
+  static Frustum FromMatrix(const glm::mat4& m) {
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0; // Left
+    frustum.planes[1] = row3 - row0; // Right
+    frustum.planes[2] = row3 + row1; // Bottom
+    frustum.planes[3] = row3 - row1; // Top
+    frustum.planes[4] = row3 + row2; // Near
+    frustum.planes[5] = row3 - row2; // Far
+
+    for (auto& plane : frustum.planes) {
+      plane /= glm::length(glm::vec3(plane));
+    }
+
+    return frustum;
+  }
+
+  bool intersects(const AABB& box) const {
+    const glm::vec3 c = box.center();
+    const glm::vec3 e = box.extents();
+
+    for (auto& plane : planes) {
+      const float r = glm::dot(e, glm::abs(glm::vec3(plane)));
+      if (glm::dot(glm::vec3(plane), c) + plane.w < -r)
+        return false;
+    }
+
+    return true;
+  }
+
+  std::array<glm::vec4, PlaneCount> planes;
+};
@@ -10,6 +10,8 @@ class Camera {
     const glm::mat4& getProjection() const { return _projection; }
     const glm::mat4& getViewProjection() const { return _viewProjection; }
     const float   getFov() const { return _fov; }
+    const float   getNearPlane() const { return _nearPlane; }
+    const float   getFarPlane() const { return _farPlane; }
     const glm::vec2& getViewport() const { return _viewPort; }
 
     void setFov(float fov);
@@ -9,6 +9,8 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
+#define JPEG_QUALITY 90
+
 std::string FileUtils::_assetsFolder;
 
 void FileUtils::init(const std::string& assetsFolder) {
@@ -53,7 +55,7 @@ bool FileUtils::readImageFile(const char* filePath, ImageData& data) {
   int width, height, components;
 
   const bool flip = std::filesystem::path(filePath).extension().generic_string().compare(".png") == 0;
-  stbi_set_flip_vertically_on_load(flip);
+  stbi_set_flip_vertically_on_load_thread(flip); // Images are decoded on job threads
   unsigned char* pData = stbi_load(absolutePath.c_str(), &width, &height, &components, kRequiredComponents);
 
   if (pData == nullptr) {
@@ -93,15 +95,58 @@ bool FileUtils::readJsonFile(const char* filePath, Json::Value& root) {
   return true;
 }
 
-void FileUtils::saveImageToFile(const char* filePath, const ImageData& data) {  
-  const unsigned char* lastLine = data.data.data() + (data.width * 3 * (data.height - 1));
+bool FileUtils::readBinaryFile(const char* filePath, std::vector<uint8_t>& data) {
+  const auto absolutePath = getAbsolutePath(filePath);
+  std::ifstream inStream(absolutePath, std::ios::binary);
+
+  if (!inStream) {
+    return false;
+  }
+
+  inStream.seekg(0, inStream.end);
+  const size_t fileLength = inStream.tellg();
+  inStream.seekg(0, inStream.beg);
+
+  data.resize(fileLength);
+  inStream.read((char*)data.data(), fileLength);
+
+  return !inStream.fail();
+}
+
+bool FileUtils::writeBinaryFile(const char* filePath, const std::vector<uint8_t>& data) {
+  const auto absolutePath = getAbsolutePath(filePath);
+  std::ofstream outStream(absolutePath, std::ios::binary | std::ios::trunc);
 
-  if (!stbi_write_png(filePath, data.width, data.height, data.bytesPerPixel, lastLine, -3*data.width)) {
+  if (!outStream) {
+    LOG_WARN("[FileUtils] Failed to open file {0} for writing, {1}", absolutePath, strerror(errno));
+    return false;
+  }
+
+  outStream.write((const char*)data.data(), data.size());
+
+  return !outStream.fail();
+}
+
+bool FileUtils::saveImageToFile(const char* filePath, const ImageData& data) {
+  const auto extension = std::filesystem::path(filePath).extension().generic_string();
+  const int stride = data.width * data.bytesPerPixel;
+
+  int result = 0;
+  if (extension.compare(".jpg") == 0 || extension.compare(".jpeg") == 0) {
+    result = stbi_write_jpg(filePath, data.width, data.height, data.bytesPerPixel, data.data.data(), JPEG_QUALITY);
+  }
+  else {
+    result = stbi_write_png(filePath, data.width, data.height, data.bytesPerPixel, data.data.data(), stride);
+  }
+
+  if (!result) {
     LOG_ERROR("[FileUtils] Could not save image {0}", filePath);
-    return;
+    return false;
   }
 
   LOG_INFO("[FileUtils] Image {0} saved", filePath);
+
+  return true;
 }
 
 std::string FileUtils::removeExtension(const std::string& filename) {
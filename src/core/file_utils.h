@@ -22,8 +22,11 @@ public:
   static bool readTextFile(const char* filePath, std::vector<char>& data);
   static bool readImageFile(const char* filePath, ImageData& data);
   static bool readJsonFile(const char* filePath, Json::Value& root);
+  static bool readBinaryFile(const char* filePath, std::vector<uint8_t>& data);
+  static bool writeBinaryFile(const char* filePath, const std::vector<uint8_t>& data);
 
-  static void saveImageToFile(const char* filePath, const ImageData& data);
+  // PNG, or JPEG for .jpg/.jpeg paths. Rows top first.
+  static bool saveImageToFile(const char* filePath, const ImageData& data);
   
   static std::string removeExtension(const std::string& filename);
   static std::string getAbsolutePath(const char* filePath);
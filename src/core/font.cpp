@@ -3,9 +3,34 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
+
+#define SDF_PIXEL_SIZE 48
+#define SDF_SPREAD 8
+#define SDF_FIRST_CHAR 32
+#define SDF_LAST_CHAR 126
+
+#define CACHE_MAGIC 0x46445347 // "GSDF"
+#define CACHE_VERSION 1
 
 static FT_Library gFTLibrary = nullptr;
 
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t pixelSize;
+  uint32_t spread;
+  uint32_t glyphCount;
+};
+
+struct CacheGlyph {
+  uint32_t  codepoint;
+  glm::vec2 advance;
+  glm::vec2 bearing;
+  int32_t   width;
+  int32_t   height;
+};
+
 bool Font::init() {
   if (gFTLibrary != nullptr)
     return true;
@@ -14,6 +39,10 @@ bool Font::init() {
     return false;
   }
 
+  FT_Int spread = SDF_SPREAD;
+  FT_Property_Set(gFTLibrary, "sdf", "spread", &spread);
+  FT_Property_Set(gFTLibrary, "bsdf", "spread", &spread);
+
   return true;
 }
 
@@ -25,7 +54,142 @@ void Font::shutdown() {
 }
 
 FontAtlasRef Font::loadFont(const char* fontFile, int pixelSize) {
-  auto fontPath = FileUtils::getAbsolutePath(fontFile);
+  const auto fontPath = FileUtils::getAbsolutePath(fontFile);
+  const std::string cacheFile = std::string(fontFile) + ".sdf";
+
+  FT_Face face;
+  if (FT_New_Face(gFTLibrary, fontPath.c_str(), 0, &face)) {
+    LOG_ERROR("[Font] Failed to load font {}", fontPath);
+    return nullptr;
+  }
+
+  FT_Set_Pixel_Sizes(face, 0, SDF_PIXEL_SIZE);
+
+  // The face stays open for glyphs loaded on demand, until the atlas is released
+  std::shared_ptr<FT_FaceRec_> sharedFace(face, FT_Done_Face);
+
+  // The cache is rebuilt when the font is newer
+  std::error_code fontError, cacheError;
+  const auto fontTime = std::filesystem::last_write_time(fontPath, fontError);
+  const auto cacheTime = std::filesystem::last_write_time(FileUtils::getAbsolutePath(cacheFile.c_str()), cacheError);
+  const bool cacheValid = !fontError && !cacheError && cacheTime >= fontTime;
+
+  std::vector<FontGlyph> glyphs;
+  if (!cacheValid || !readCache(cacheFile.c_str(), glyphs)) {
+    glyphs.clear();
+    for (uint32_t c = SDF_FIRST_CHAR; c <= SDF_LAST_CHAR; ++c) {
+      FontGlyph glyph;
+      if (!renderGlyph(face, c, glyph)) {
+        LOG_WARN("[Font] Error rendering font character {}, skipping", (char)c);
+        continue;
+      }
+
+      glyphs.push_back(std::move(glyph));
+    }
+
+    writeCache(cacheFile.c_str(), glyphs);
+    LOG_INFO("[Font] Generated distance field glyphs for {}", fontFile);
+  }
+
+  auto loader = [sharedFace](uint32_t codepoint, FontGlyph& glyph) {
+    return renderGlyph(sharedFace.get(), codepoint, glyph);
+  };
+
+  return FontAtlas::Create(loader, glyphs, (float)pixelSize / (float)SDF_PIXEL_SIZE);
+}
+
+/*static*/ bool Font::renderGlyph(FT_FaceRec_* face, uint32_t codepoint, FontGlyph& glyph) {
+  // FT_Load_Char falls back to .notdef for characters the face does not have
+  const FT_UInt glyphIndex = FT_Get_Char_Index(face, codepoint);
+  if (glyphIndex == 0 || FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT))
+    return false;
+
+  // Blank glyphs (spaces) only have an advance, the SDF renderer rejects empty outlines
+  const bool blank = face->glyph->format == FT_GLYPH_FORMAT_OUTLINE && face->glyph->outline.n_points == 0;
+  if (!blank && FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF))
+    return false;
+
+  // Bitmap and bearing include the spread around the outline
+  const FT_GlyphSlot slot = face->glyph;
+  glyph.codepoint = codepoint;
+  glyph.advance = glm::vec2(slot->advance.x / 64.0f, slot->advance.y / 64.0f);
+  glyph.bearing = blank ? glm::vec2(0.0f) : glm::vec2(slot->bitmap_left, slot->bitmap_top);
+  glyph.size = blank ? glm::ivec2(0) : glm::ivec2(slot->bitmap.width, slot->bitmap.rows);
+  glyph.bitmap.resize(glyph.size.x * glyph.size.y);
+
+  for (int row = 0; row < glyph.size.y; ++row) {
+    memcpy(&glyph.bitmap[row * glyph.size.x], slot->bitmap.buffer + row * slot->bitmap.pitch, glyph.size.x);
+  }
+
+  return true;
+}
+
+/*static*/ bool Font::readCache(const char* cacheFile, std::vector<FontGlyph>& glyphs) {
+  std::vector<uint8_t> data;
+  if (!FileUtils::readBinaryFile(cacheFile, data))
+    return false;
+
+  size_t offset = 0;
+  auto read = [&data, &offset](void* out, size_t size) {
+    if (offset + size > data.size())
+      return false;
+
+    memcpy(out, data.data() + offset, size);
+    offset += size;
+    return true;
+  };
+
+  CacheHeader header;
+  if (!read(&header, sizeof(header)) || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION
+    || header.pixelSize != SDF_PIXEL_SIZE || header.spread != SDF_SPREAD) {
+    return false;
+  }
+
+  // Sizes are checked against the file before allocating, a corrupt cache is rebuilt
+  if (header.glyphCount > SDF_LAST_CHAR - SDF_FIRST_CHAR + 1)
+    return false;
+
+  glyphs.resize(header.glyphCount);
+  for (auto& glyph : glyphs) {
+    CacheGlyph cached;
+    if (!read(&cached, sizeof(cached)) || cached.width < 0 || cached.height < 0)
+      return false;
 
-  return FontAtlas::Create(gFTLibrary, fontPath.c_str(), pixelSize);
+    const uint64_t bitmapSize = (uint64_t)cached.width * (uint64_t)cached.height;
+    if (bitmapSize > data.size() - offset)
+      return false;
+
+    glyph.codepoint = cached.codepoint;
+    glyph.advance = cached.advance;
+    glyph.bearing = cached.bearing;
+    glyph.size = glm::ivec2(cached.width, cached.height);
+    glyph.bitmap.resize(bitmapSize);
+
+    if (!read(glyph.bitmap.data(), glyph.bitmap.size()))
+      return false;
+  }
+
+  return true;
+}
+
+/*static*/ void Font::writeCache(const char* cacheFile, const std::vector<FontGlyph>& glyphs) {
+  std::vector<uint8_t> data;
+  auto write = [&data](const void* in, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)in;
+    data.insert(data.end(), bytes, bytes + size);
+  };
+
+  const CacheHeader header = { CACHE_MAGIC, CACHE_VERSION, SDF_PIXEL_SIZE, SDF_SPREAD, (uint32_t)glyphs.size() };
+  write(&header, sizeof(header));
+
+  for (const auto& glyph : glyphs) {
+    const CacheGlyph cached = { glyph.codepoint, glyph.advance, glyph.bearing, glyph.size.x, glyph.size.y };
+    write(&cached, sizeof(cached));
+    write(glyph.bitmap.data(), glyph.bitmap.size());
+  }
+
+  // A missing cache only costs regenerating next time
+  if (!FileUtils::writeBinaryFile(cacheFile, data)) {
+    LOG_WARN("[Font] Could not write glyph cache {}", cacheFile);
+  }
 }
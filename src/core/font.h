@@ -2,9 +2,18 @@
 
 #include "graphics/font_atlas.h"
 
+struct FT_FaceRec_;
+
 class Font {
 public:
   static bool init();
   static void shutdown();
+  // pixelSize is the size text is laid out at with scale 1. Glyphs are rendered as distance fields, the
+  // printable ASCII ones are cached next to the font file and the rest are rendered when first drawn.
   static FontAtlasRef loadFont(const char* fontFile, int pixelSize);
+
+private:
+  static bool renderGlyph(FT_FaceRec_* face, uint32_t codepoint, FontGlyph& glyph);
+  static bool readCache(const char* cacheFile, std::vector<FontGlyph>& glyphs);
+  static void writeCache(const char* cacheFile, const std::vector<FontGlyph>& glyphs);
 };
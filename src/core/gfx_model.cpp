@@ -6,16 +6,24 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-/*static*/ GfxModelRef GfxModel::Create() {
-  GfxModelRef model(new GfxModel());
+GfxModel::~GfxModel() {
+  for (auto mesh : _meshes) {
+    Mesh::Destroy(mesh);
+  }
+}
 
-  return model;
+/*static*/ GfxModelRef GfxModel::Create() {
+  return ResourcePool<GfxModel>::Get().create();
 }
 
 /*static*/ GfxModelRef GfxModel::Create(MeshRef mesh, MaterialRef material) {
-  GfxModelRef model(new GfxModel());
+  GfxModelRef model = ResourcePool<GfxModel>::Get().create();
   model->addMesh(mesh);
   model->setMaterial(material);
 
   return model;
 }
+
+/*static*/ void GfxModel::Destroy(GfxModelRef model) {
+  ResourcePool<GfxModel>::Get().destroy(model);
+}
@@ -9,21 +9,27 @@ struct aiNode;
 struct aiMesh;
 
 class GfxModel;
-typedef std::shared_ptr<GfxModel> GfxModelRef;
+typedef Handle<GfxModel> GfxModelRef;
 
+// Owns its meshes, they are destroyed with the model. The material is only referenced.
 class GfxModel {
 public:
+  ~GfxModel();
+
   void addMesh(MeshRef mesh) { _meshes.push_back(mesh); }
   void setMaterial(MaterialRef material) { _material = material; }
 
   uint32_t getMeshCount() const { return _meshes.size(); }
-  MeshRef  getMesh(uint32_t idx) const { return _meshes[idx]; }
-  MaterialRef getMaterial() const { return _material; }
+  const MeshRef& getMesh(uint32_t idx) const { return _meshes[idx]; }
+  const MaterialRef& getMaterial() const { return _material; }
 
   static GfxModelRef Create();
   static GfxModelRef Create(MeshRef mesh, MaterialRef material);
+  static void Destroy(GfxModelRef model);
 
 private:
+  friend class ResourcePool<GfxModel>;
+
   GfxModel() = default;
   GfxModel(const GfxModel& model) = delete;
 
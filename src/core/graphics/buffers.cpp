@@ -11,6 +11,8 @@ static uint16_t BufferItemTypeSize(BufferItemType type){
     case BufferItemType::Float4:   return sizeof(float) * 4;
     case BufferItemType::Int:      return sizeof(int);
     case BufferItemType::Mat4:     return sizeof(float) * 16;
+    case BufferItemType::UShort4Norm: return sizeof(uint16_t) * 4;
+    case BufferItemType::UByte4Norm:  return sizeof(uint8_t) * 4;
   }
 
   return 0;
@@ -24,11 +26,22 @@ static GLenum BufferItemTypeToOpenGLBaseType(BufferItemType type) {
     case BufferItemType::Float4:   return GL_FLOAT;
     case BufferItemType::Int:      return GL_INT;
     case BufferItemType::Mat4:     return GL_FLOAT;
+    case BufferItemType::UShort4Norm: return GL_UNSIGNED_SHORT;
+    case BufferItemType::UByte4Norm:  return GL_UNSIGNED_BYTE;
   }
 
   return 0;
 }
 
+static uint32_t gBoundVertexArray = 0;
+
+static void BindVertexArray(uint32_t id) {
+  if (gBoundVertexArray != id) {
+    glBindVertexArray(id);
+    gBoundVertexArray = id;
+  }
+}
+
 static uint32_t Align(uint32_t pos, uint32_t alignment) {
   while(pos % alignment != 0) {
     pos +=1;
@@ -92,10 +105,29 @@ VBO::VBO(uint32_t size, const BufferLayout& layout)
   setFlag(Flag_Dynamic);
 }
 
+VBO::VBO(uint32_t size, const BufferLayout& layout, uint32_t storageFlags)
+  : _id(0)
+  , _size(size)
+  , _flags(0) {
+
+  glGenBuffers(1, &_id);
+  glBindBuffer(GL_ARRAY_BUFFER, _id);
+  glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, storageFlags);
+
+  _layout = layout;
+  setFlag(Flag_Storage);
+}
+
 VBO::~VBO() {
   glDeleteBuffers(1, &_id);
 }
 
+/*static*/ VBORef VBO::CreateStorage(uint32_t size, const BufferLayout& layout, uint32_t storageFlags) {
+  VBORef buffer(new VBO(size, layout, storageFlags));
+
+  return buffer;
+}
+
 /*static*/ VBORef VBO::Create(uint32_t size, const BufferLayout& layout) {
   VBORef buffer(new VBO(size, layout));
 
@@ -108,34 +140,56 @@ VBO::~VBO() {
   return buffer;
 }
 
-void VBO::uploadData(const void* data, uint32_t size) {
+void VBO::uploadData(const void* data, uint32_t size, uint32_t offset) {
   if (!hasFlag(Flag_Dynamic)) {
     LOG_WARN("[Renderer] VBO cannot upload data to static buffer");
     return;
   }
 
+  if (offset + size > _size) {
+    LOG_WARN("[Renderer] VBO upload out of bounds ({} + {} > {})", offset, size, _size);
+    return;
+  }
+
   glBindBuffer(GL_ARRAY_BUFFER, _id);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+  glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
 }
 
 // IBO
-IBO::IBO(const uint32_t* indices, uint32_t count)
+IBO::IBO(const uint32_t* indices, uint32_t count, bool dynamic)
   : _count(count) {
+  // Note: bound as GL_ARRAY_BUFFER so the element binding of the current VAO is left untouched
   glGenBuffers(1, &_id);
   glBindBuffer(GL_ARRAY_BUFFER, _id);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(uint32_t) * count, indices, GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(uint32_t) * count, indices, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 }
 
 IBO::~IBO() {
   glDeleteBuffers(1, &_id);
 }
 
+/*static*/ IBORef IBO::Create(uint32_t count) {
+  IBORef buffer(new IBO(nullptr, count, true));
+
+  return buffer;
+}
+
 /*static*/ IBORef IBO::Create(const uint32_t* indices, uint32_t count) {
-  IBORef buffer(new IBO(indices, count));
+  IBORef buffer(new IBO(indices, count, false));
 
   return buffer;
 }
 
+void IBO::uploadData(const uint32_t* indices, uint32_t count, uint32_t firstIndex) {
+  if (firstIndex + count > _count) {
+    LOG_WARN("[Renderer] IBO upload out of bounds ({} + {} > {})", firstIndex, count, _count);
+    return;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, _id);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(uint32_t) * firstIndex, sizeof(uint32_t) * count, indices);
+}
+
 // VAO
 VAO::VAO()
   : _attributeCount(0) {
@@ -143,6 +197,10 @@ VAO::VAO()
 }
 
 VAO::~VAO() {
+  if (gBoundVertexArray == _id) {
+    gBoundVertexArray = 0;
+  }
+
   glDeleteVertexArrays(1, &_id);
 }
 
@@ -153,21 +211,44 @@ VAO::~VAO() {
 }
 
 void VAO::bind() {
-  glBindVertexArray(_id);
+  BindVertexArray(_id);
 }
 
 void VAO::unbind() {
-  glBindVertexArray(0);
+  BindVertexArray(0);
+}
+
+/*static*/ void VAO::invalidateBindCache() {
+  gBoundVertexArray = ~0u;
+}
+
+void VAO::addVertexBuffer(VBORef buffer, int firstAttribute) {
+  if (firstAttribute >= 0) {
+    _attributeCount = firstAttribute;
+  }
+
+  BindVertexArray(_id);
+  setupAttributes(*buffer, _attributeCount, 0);
+  BindVertexArray(0);
+
+  _vertexBuffers.push_back(buffer);
+  _firstAttributes.push_back(_attributeCount);
+  _attributeCount += buffer->layout().itemCount();
+}
+
+void VAO::setVertexBufferOffset(size_t i, uint32_t offset) {
+  BindVertexArray(_id);
+  setupAttributes(*_vertexBuffers[i], _firstAttributes[i], offset);
 }
 
-void VAO::addVertexBuffer(VBORef buffer) {
-  glBindVertexArray(_id);
-  glBindBuffer(GL_ARRAY_BUFFER, buffer->id());
+void VAO::setupAttributes(const VBO& buffer, uint32_t firstAttribute, uint32_t baseOffset) {
+  glBindBuffer(GL_ARRAY_BUFFER, buffer.id());
 
-  const auto attribDivisor = buffer->hasFlag(VBO::Flag_Instance) ? 1 : 0;
-  const auto& layout = buffer->layout();
+  const auto attribDivisor = buffer.hasFlag(VBO::Flag_Instance) ? 1 : 0;
+  const auto& layout = buffer.layout();
   for (uint32_t i = 0; i < layout.itemCount(); ++i) {
     const auto& item = layout.itemAt(i);
+    const uint32_t idx = firstAttribute + i;
 
     switch (item.type){
     case BufferItemType::Float:
@@ -175,45 +256,37 @@ void VAO::addVertexBuffer(VBORef buffer) {
     case BufferItemType::Float3:
     case BufferItemType::Float4:
     case BufferItemType::Mat4:
+    case BufferItemType::UShort4Norm:
+    case BufferItemType::UByte4Norm:
       {
-        const uint32_t idx = _attributeCount;
+        const bool normalized = item.type == BufferItemType::UShort4Norm || item.type == BufferItemType::UByte4Norm;
         glVertexAttribPointer(
           idx,
           item.getComponentCount(),
           BufferItemTypeToOpenGLBaseType(item.type),
-          GL_FALSE,
+          normalized ? GL_TRUE : GL_FALSE,
           layout.stride(),
-          INT_TO_VOIDPTR(item.offset)
+          INT_TO_VOIDPTR(baseOffset + item.offset)
         );
         glEnableVertexAttribArray(idx);
         glVertexAttribDivisor(idx, attribDivisor);
-
-        _attributeCount++;
       }
       break;
     case BufferItemType::Int:
       {
-        const uint32_t idx = _attributeCount;
-
         glVertexAttribIPointer(
           idx,
           item.getComponentCount(),
           BufferItemTypeToOpenGLBaseType(item.type),
           layout.stride(),
-          INT_TO_VOIDPTR(item.offset)
+          INT_TO_VOIDPTR(baseOffset + item.offset)
         );
         glEnableVertexAttribArray(idx);
         glVertexAttribDivisor(idx, attribDivisor);
-
-        _attributeCount++;
       }
       break;
     }
   }
-
-  glBindVertexArray(0);
-
-  _vertexBuffers.push_back(buffer);
 }
 
 VBORef VAO::getVertexBuffer(size_t i) const {
@@ -221,13 +294,141 @@ VBORef VAO::getVertexBuffer(size_t i) const {
 }
 
 void VAO::setIndexBuffer(IBORef buffer) {
-  glBindVertexArray(_id);
+  BindVertexArray(_id);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->id());
-  glBindVertexArray(0);
+  BindVertexArray(0);
 
   _indexBuffer = buffer;
 }
 
+// TBO
+static GLenum TBOFormatToOpenGLFormat(TBOFormat format) {
+  switch (format) {
+    case TBOFormat::RGBA32F:  return GL_RGBA32F;
+    case TBOFormat::RGBA32UI: return GL_RGBA32UI;
+    case TBOFormat::RG32UI:   return GL_RG32UI;
+    case TBOFormat::R32UI:    return GL_R32UI;
+  }
+
+  return 0;
+}
+
+TBO::TBO(TBOFormat format, uint32_t size)
+  : _size(size)
+  , _format(format) {
+  glGenBuffers(1, &_id);
+  glBindBuffer(GL_TEXTURE_BUFFER, _id);
+  glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+  glGenTextures(1, &_textureId);
+  glBindTexture(GL_TEXTURE_BUFFER, _textureId);
+  glTexBuffer(GL_TEXTURE_BUFFER, TBOFormatToOpenGLFormat(format), _id);
+
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+TBO::~TBO() {
+  glDeleteTextures(1, &_textureId);
+  glDeleteBuffers(1, &_id);
+}
+
+/*static*/ TBORef TBO::Create(TBOFormat format, uint32_t size) {
+  TBORef buffer(new TBO(format, size));
+
+  return buffer;
+}
+
+void TBO::bind(uint32_t slot) {
+  glActiveTexture(GL_TEXTURE0 + slot);
+  glBindTexture(GL_TEXTURE_BUFFER, _textureId);
+}
+
+void TBO::uploadData(const void* data, uint32_t size) {
+  // Orphan the previous storage so the upload does not wait on draws still reading it
+  _size = std::max(_size, size);
+
+  glBindBuffer(GL_TEXTURE_BUFFER, _id);
+  glBufferData(GL_TEXTURE_BUFFER, _size, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TBO::updateData(const void* data, uint32_t size, uint32_t offset) {
+  if (offset + size > _size) {
+    LOG_WARN("[Renderer] TBO update out of bounds ({} + {} > {})", offset, size, _size);
+    return;
+  }
+
+  glBindBuffer(GL_TEXTURE_BUFFER, _id);
+  glBufferSubData(GL_TEXTURE_BUFFER, offset, size, data);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// IndirectBuffer
+IndirectBuffer::IndirectBuffer(uint32_t size)
+  : _size(size) {
+  glGenBuffers(1, &_id);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _id);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, size, nullptr, GL_STREAM_DRAW);
+}
+
+IndirectBuffer::~IndirectBuffer() {
+  glDeleteBuffers(1, &_id);
+}
+
+/*static*/ IndirectBufferRef IndirectBuffer::Create(uint32_t size) {
+  IndirectBufferRef buffer(new IndirectBuffer(size));
+
+  return buffer;
+}
+
+void IndirectBuffer::bind() {
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _id);
+}
+
+void IndirectBuffer::uploadData(const void* data, uint32_t size) {
+  _size = std::max(_size, size);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _id);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, _size, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, data);
+}
+
+// SSBO
+SSBO::SSBO(uint32_t size)
+  : _size(size) {
+  glGenBuffers(1, &_id);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, _id);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+SSBO::~SSBO() {
+  glDeleteBuffers(1, &_id);
+}
+
+/*static*/ SSBORef SSBO::Create(uint32_t size) {
+  SSBORef buffer(new SSBO(size));
+
+  return buffer;
+}
+
+void SSBO::bindBase(uint32_t index) {
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, _id);
+}
+
+void SSBO::uploadData(const void* data, uint32_t size, uint32_t offset) {
+  if (offset + size > _size) {
+    LOG_WARN("[Renderer] SSBO upload out of bounds ({} + {} > {})", offset, size, _size);
+    return;
+  }
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, _id);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
 // UBO
 UBO::UBO(uint32_t bindIndex, std::vector<UBO::Item> items) {
   _block = UBO::Item(UBO::newStruct(items));
@@ -438,14 +639,15 @@ bool UBO::pop() {
 // FBO
 FBO::FBO(const FBOSpec& spec)
   : _spec(spec) {
+  _colorAttachments[0] = _colorAttachments[1] = 0;
 
   glGenFramebuffers(1, &_id);
   glBindFramebuffer(GL_FRAMEBUFFER, _id);
 
   if (spec.type == FBOType::Default) {
     // Color RGB
-    glGenTextures(1, &_colorAttachment);
-    glBindTexture(GL_TEXTURE_2D, _colorAttachment);
+    glGenTextures(1, &_colorAttachments[0]);
+    glBindTexture(GL_TEXTURE_2D, _colorAttachments[0]);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, spec.width, spec.height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
 
@@ -454,7 +656,7 @@ FBO::FBO(const FBOSpec& spec)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorAttachment, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorAttachments[0], 0);
 
     // Depth and stencil
     glGenRenderbuffers(1, &_depthAttachment);
@@ -479,6 +681,48 @@ FBO::FBO(const FBOSpec& spec)
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
   }
+  else if (spec.type == FBOType::GBuffer) {
+    const GLenum internalFormats[2] = { GL_RGBA8, GL_RGBA16F };
+    const GLenum types[2] = { GL_UNSIGNED_BYTE, GL_HALF_FLOAT };
+
+    glGenTextures(2, _colorAttachments);
+    for (int i = 0; i < 2; ++i) {
+      glBindTexture(GL_TEXTURE_2D, _colorAttachments[i]);
+      glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], spec.width, spec.height, 0, GL_RGBA, types[i], nullptr);
+
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, _colorAttachments[i], 0);
+    }
+
+    glGenTextures(1, &_depthAttachment);
+    glBindTexture(GL_TEXTURE_2D, _depthAttachment);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, spec.width, spec.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depthAttachment, 0);
+
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+  }
+  else if (spec.type == FBOType::Depth) {
+    glGenTextures(1, &_depthAttachment);
+    glBindTexture(GL_TEXTURE_2D, _depthAttachment);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, spec.width, spec.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depthAttachment, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  }
 
   if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
     LOG_ERROR("[FBO] Framebuffer not complete");
@@ -491,10 +735,14 @@ FBO::~FBO() {
   glDeleteFramebuffers(1, &_id);
 
   if (_spec.type == FBOType::Default) {
-    glDeleteTextures(1, &_colorAttachment);
+    glDeleteTextures(1, &_colorAttachments[0]);
     glDeleteRenderbuffers(1, &_depthAttachment);
   }
-  else if (_spec.type == FBOType::Shadowmap) {
+  else if (_spec.type == FBOType::Shadowmap || _spec.type == FBOType::Depth) {
+    glDeleteTextures(1, &_depthAttachment);
+  }
+  else if (_spec.type == FBOType::GBuffer) {
+    glDeleteTextures(2, _colorAttachments);
     glDeleteTextures(1, &_depthAttachment);
   }
 }
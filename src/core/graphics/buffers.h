@@ -7,6 +7,8 @@ enum class BufferItemType {
   Float4,
   Int,
   Mat4,
+  UShort4Norm, // Unsigned, read as floats in [0, 1]
+  UByte4Norm,
 };
 
 struct BufferItem {
@@ -26,6 +28,8 @@ struct BufferItem {
       case BufferItemType::Float4:   return 4;
       case BufferItemType::Int:      return 1;
       case BufferItemType::Mat4:     return 16;
+      case BufferItemType::UShort4Norm: return 4;
+      case BufferItemType::UByte4Norm:  return 4;
     }
 
     return 0;
@@ -39,6 +43,8 @@ struct BufferItem {
       case BufferItemType::Float4:   return 16;
       case BufferItemType::Int:      return 4;
       case BufferItemType::Mat4:     return 16;
+      case BufferItemType::UShort4Norm: return 8;
+      case BufferItemType::UByte4Norm:  return 4;
     }
 
     return 0;
@@ -67,6 +73,7 @@ public:
   enum Flag {
     Flag_Dynamic = BIT(1),
     Flag_Instance = BIT(2),
+    Flag_Storage = BIT(3), // Immutable storage, written through mappings only
   };
 
 public:
@@ -74,14 +81,17 @@ public:
 
   static VBORef Create(uint32_t size, const BufferLayout& layout);
   static VBORef Create(const void* data, uint32_t size, const BufferLayout& layout);
+  // glBufferStorage with the given flags, needs GL 4.4
+  static VBORef CreateStorage(uint32_t size, const BufferLayout& layout, uint32_t storageFlags);
 
   uint32_t id() const { return _id; }
+  uint32_t size() const { return _size; }
   void setFlag(Flag flag) { _flags |= flag; }
 
   bool hasFlag(Flag flag) const { return (_flags & flag) != 0; }
   const BufferLayout& layout() const { return _layout; }
 
-  void uploadData(const void* data, uint32_t size);
+  void uploadData(const void* data, uint32_t size, uint32_t offset = 0);
 
 private:
   VBO() = delete;
@@ -89,6 +99,7 @@ private:
 
   VBO(uint32_t size, const BufferLayout& layout);
   VBO(const void* data, uint32_t size, const BufferLayout& layout);
+  VBO(uint32_t size, const BufferLayout& layout, uint32_t storageFlags);
 
 private:
   BufferLayout _layout;
@@ -104,16 +115,19 @@ class IBO {
 public:
   ~IBO();
 
+  static IBORef Create(uint32_t count);
   static IBORef Create(const uint32_t* indices, uint32_t count);
 
   uint32_t id() const { return _id; }
   uint32_t count() const { return _count; }
 
+  void uploadData(const uint32_t* indices, uint32_t count, uint32_t firstIndex = 0);
+
 private:
   IBO() = delete;
   IBO(const IBO&) = delete;
 
-  IBO(const uint32_t* indices, uint32_t count);
+  IBO(const uint32_t* indices, uint32_t count, bool dynamic);
 
 private:
   uint32_t _id;
@@ -132,22 +146,130 @@ public:
   void bind();
   void unbind();
 
-  void addVertexBuffer(VBORef buffer);
+  // firstAttribute < 0 continues after the attributes of the previously added buffers
+  void addVertexBuffer(VBORef buffer, int firstAttribute = -1);
+  // Points the attributes of buffer i at offset bytes into it, leaves the VAO bound
+  void setVertexBufferOffset(size_t i, uint32_t offset);
   VBORef getVertexBuffer(size_t i) const;
   void setIndexBuffer(IBORef buffer);
 
   const uint32_t indexCount() const { return _indexBuffer ? _indexBuffer->count() : 0; }
+
+  // Binds are skipped when the VAO is already bound, call after external code
+  // (e.g. ImGui backend) changes the vertex array binding behind our back
+  static void invalidateBindCache();
+
 private:
   VAO();
   VAO(const VAO&) = delete;
 
+  void setupAttributes(const VBO& buffer, uint32_t firstAttribute, uint32_t baseOffset);
+
 private:
   uint32_t _id;
   std::vector<VBORef> _vertexBuffers;
+  std::vector<uint32_t> _firstAttributes;
   IBORef _indexBuffer;
   uint32_t _attributeCount;
 };
 
+// Texture buffer ///
+
+enum class TBOFormat {
+  RGBA32F,
+  RGBA32UI,
+  RG32UI,
+  R32UI
+};
+
+class TBO;
+typedef std::shared_ptr<TBO> TBORef;
+
+class TBO {
+public:
+  ~TBO();
+
+  static TBORef Create(TBOFormat format, uint32_t size);
+
+  uint32_t id() const { return _id; }
+  uint32_t textureId() const { return _textureId; }
+
+  void bind(uint32_t slot);
+  void uploadData(const void* data, uint32_t size);
+  void updateData(const void* data, uint32_t size, uint32_t offset);
+
+private:
+  TBO() = delete;
+  TBO(const TBO&) = delete;
+  TBO(TBOFormat format, uint32_t size);
+
+private:
+  uint32_t  _id;
+  uint32_t  _textureId;
+  uint32_t  _size;
+  TBOFormat _format;
+};
+
+// Indirect draw buffer ///
+
+struct DrawElementsIndirectCommand {
+  uint32_t count;
+  uint32_t instanceCount;
+  uint32_t firstIndex;
+  int32_t  baseVertex;
+  uint32_t baseInstance;
+};
+
+class IndirectBuffer;
+typedef std::shared_ptr<IndirectBuffer> IndirectBufferRef;
+
+class IndirectBuffer {
+public:
+  ~IndirectBuffer();
+
+  static IndirectBufferRef Create(uint32_t size);
+
+  uint32_t id() const { return _id; }
+
+  void bind();
+  void uploadData(const void* data, uint32_t size);
+
+private:
+  IndirectBuffer() = delete;
+  IndirectBuffer(const IndirectBuffer&) = delete;
+  IndirectBuffer(uint32_t size);
+
+private:
+  uint32_t _id;
+  uint32_t _size;
+};
+
+// Shader storage buffer ///
+
+class SSBO;
+typedef std::shared_ptr<SSBO> SSBORef;
+
+class SSBO {
+public:
+  ~SSBO();
+
+  static SSBORef Create(uint32_t size);
+
+  uint32_t id() const { return _id; }
+
+  void bindBase(uint32_t index);
+  void uploadData(const void* data, uint32_t size, uint32_t offset = 0);
+
+private:
+  SSBO() = delete;
+  SSBO(const SSBO&) = delete;
+  SSBO(uint32_t size);
+
+private:
+  uint32_t _id;
+  uint32_t _size;
+};
+
 // Uniform buffer ///
 
 class UBO;
@@ -342,7 +464,9 @@ private:
 
 enum class FBOType {
   Default,
-  Shadowmap
+  Shadowmap,
+  Depth,
+  GBuffer   // 0: albedo + specular (RGBA8), 1: normal + shininess (RGBA16F), depth texture
 };
 
 struct FBOSpec {
@@ -361,11 +485,12 @@ public:
   static FBORef Create(const FBOSpec& spec);
 
   uint32_t id() const { return _id; }
-  uint32_t colorAttachment() const { return _colorAttachment; }
+  uint32_t colorAttachment(uint32_t index = 0) const { return _colorAttachments[index]; }
   uint32_t depthAttachment() const { return _depthAttachment; }
 
   const uint32_t width() const { return _spec.width; }
   const uint32_t height() const { return _spec.height; }
+  const FBOSpec& spec() const { return _spec; }
 
 private:
   FBO() = delete;
@@ -376,6 +501,6 @@ private:
   FBOSpec _spec;
 
   uint32_t _id;
-  uint32_t _colorAttachment;
+  uint32_t _colorAttachments[2];
   uint32_t _depthAttachment;
 };
@@ -0,0 +1,90 @@
+#include "command_recorder.h"
+
+static bool packetLess(const CommandPacket& a, const CommandPacket& b) {
+  return a.key < b.key || (a.key == b.key && a.item < b.item);
+}
+
+CommandRecorder::CommandRecorder()
+  : _jobSystem(nullptr)
+  , _lastThreadCount(0) {
+  _culled.fill(0);
+  _occluded.fill(0);
+  _objectLights.fill(0);
+}
+
+void CommandRecorder::init(JobSystem& jobSystem) {
+  _jobSystem = &jobSystem;
+
+  for (uint32_t i = 0; i <= jobSystem.getThreadCount(); ++i) {
+    _allocators.emplace_back(64 * 1024);
+  }
+
+  for (auto& packets : _packets) {
+    packets.reserve(512);
+  }
+}
+
+void CommandRecorder::record(const std::array<uint32_t, MaxPasses>& itemCounts, const RecordFn& recordFn) {
+  const uint32_t workerCount = _jobSystem->getActiveWorkers() + 1;
+
+  // Chunks small enough to spread every pass over the workers, but not so small that threads cost more than they save
+  _tasks.clear();
+  for (uint32_t pass = 0; pass < MaxPasses; ++pass) {
+    const uint32_t count = itemCounts[pass];
+    const uint32_t chunk = std::max((count + workerCount - 1) / workerCount, (uint32_t)MinItemsPerTask);
+
+    for (uint32_t begin = 0; begin < count; begin += chunk) {
+      _tasks.push_back({ pass, begin, std::min(begin + chunk, count), {} });
+    }
+  }
+
+  for (auto& allocator : _allocators) {
+    allocator.reset();
+  }
+
+  _jobSystem->parallelFor((uint32_t)_tasks.size(), 1, [this, &recordFn](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      runTask(_tasks[i], recordFn);
+    }
+  });
+
+  _lastThreadCount = 0;
+  for (const auto& allocator : _allocators) {
+    _lastThreadCount += allocator.used() > 0 ? 1 : 0;
+  }
+
+  // Tasks of a pass are contiguous and each one is already sorted, append and merge the runs
+  for (uint32_t pass = 0; pass < MaxPasses; ++pass) {
+    auto& packets = _packets[pass];
+    packets.clear();
+    _culled[pass] = 0;
+    _occluded[pass] = 0;
+    _objectLights[pass] = 0;
+
+    for (const auto& task : _tasks) {
+      if (task.pass != pass)
+        continue;
+
+      const size_t middle = packets.size();
+      packets.insert(packets.end(), task.output.packets, task.output.packets + task.output.count);
+      std::inplace_merge(packets.begin(), packets.begin() + middle, packets.end(), packetLess);
+
+      _culled[pass] += task.output.culled;
+      _occluded[pass] += task.output.occluded;
+      _objectLights[pass] += task.output.objectLights;
+    }
+  }
+}
+
+void CommandRecorder::runTask(Task& task, const RecordFn& recordFn) {
+  // Threads outside the job system share the last allocator, only one of them records at a time
+  const uint32_t thread = std::min(_jobSystem->getThreadIndex(), (uint32_t)_allocators.size() - 1);
+  auto& allocator = _allocators[thread];
+
+  task.output = {};
+  task.output.packets = allocator.allocate<CommandPacket>(task.end - task.begin);
+
+  recordFn(task.pass, task.begin, task.end, allocator, task.output);
+
+  std::sort(task.output.packets, task.output.packets + task.output.count, packetLess);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "core/job_system.h"
+#include "core/linear_allocator.h"
+
+// Sort key plus the index of the recorded item, payloads (object lights) live in the worker's allocator
+struct CommandPacket {
+  uint64_t        key;
+  const uint32_t* lights;
+  uint32_t        item;
+};
+
+// Records command packets for several passes as jobs. Pass items are split in chunks, each chunk is
+// culled and keyed into the linear allocator of the thread running it and sorted there, then the sorted
+// runs of every pass are merged on the calling thread for replay.
+class CommandRecorder {
+public:
+  enum {
+    MaxPasses = 4,
+    MinItemsPerTask = 128,
+  };
+
+  struct TaskOutput {
+    CommandPacket* packets;
+    uint32_t count;
+    uint32_t culled;
+    uint32_t occluded;
+    uint32_t objectLights;
+  };
+
+  // Fills output with the packets of items [begin, end) of the pass, packets has room for end - begin
+  typedef std::function<void(uint32_t pass, uint32_t begin, uint32_t end, LinearAllocator& allocator, TaskOutput& output)> RecordFn;
+
+public:
+  CommandRecorder();
+
+  void init(JobSystem& jobSystem);
+  void record(const std::array<uint32_t, MaxPasses>& itemCounts, const RecordFn& recordFn);
+
+  const std::vector<CommandPacket>& getPackets(uint32_t pass) const { return _packets[pass]; }
+  uint32_t getCulled(uint32_t pass) const { return _culled[pass]; }
+  uint32_t getOccluded(uint32_t pass) const { return _occluded[pass]; }
+  uint32_t getObjectLights(uint32_t pass) const { return _objectLights[pass]; }
+  uint32_t getLastThreadCount() const { return _lastThreadCount; }
+
+private:
+  struct Task {
+    uint32_t pass;
+    uint32_t begin;
+    uint32_t end;
+    TaskOutput output;
+  };
+
+  void runTask(Task& task, const RecordFn& recordFn);
+
+private:
+  JobSystem* _jobSystem;
+  std::vector<LinearAllocator> _allocators; // One per job thread, plus one for threads outside the job system
+  std::vector<Task> _tasks;
+  std::array<std::vector<CommandPacket>, MaxPasses> _packets;
+  std::array<uint32_t, MaxPasses> _culled;
+  std::array<uint32_t, MaxPasses> _occluded;
+  std::array<uint32_t, MaxPasses> _objectLights;
+  uint32_t _lastThreadCount;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "geometry_arena.h"
+
+class Material;
+
+enum DrawFlags {
+  DrawFlags_None = 0,
+  DrawFlags_Shadow = BIT(0),
+  DrawFlags_NoCulling = BIT(1),
+};
+
+// Consecutive indirect commands sharing material and geometry buffer, submitted with one multi-draw
+struct DrawBatch {
+  Material*       material; // nullptr on depth-only passes
+  GeometryBuffer* buffer;
+  uint32_t        firstCommand;
+  uint32_t        commandCount;
+  bool            depthPrepassed; // Main pass only, depth already written by the pre-pass
+};
+
+typedef std::vector<DrawBatch> DrawBatches;
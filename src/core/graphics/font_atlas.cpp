@@ -2,26 +2,14 @@
 
 #include <glad/glad.h>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
+FontAtlas::FontAtlas(GlyphLoader loader, float metricsScale)
+  : _loader(loader)
+  , _metricsScale(metricsScale)
+  , _shelvesEnd(0)
+  , _frame(0)
+  , _evictions(0) {
 
-FontAtlas::FontAtlas(FT_FaceRec_* face, int pixelSize) {
-  FT_Set_Pixel_Sizes(face, 0, pixelSize);
-
-  const int padding = 2;
-  const int charCount = _characters.max_size();
-
-  for(unsigned char i = 0; i < charCount; ++i) {
-    if(FT_Load_Char(face, i, FT_LOAD_RENDER)) {
-      LOG_WARN("[Renderer] Error loading font character {}, skipping", char(i));
-      continue;
-    }
-
-    _width += face->glyph->bitmap.width + padding;
-    _height = std::max(_height, (int)face->glyph->bitmap.rows);
-  }
-
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  _asciiGlyphs.fill(InvalidGlyph);
 
   glGenTextures(1, &_textureId);
   glBindTexture(GL_TEXTURE_2D, _textureId);
@@ -30,52 +18,267 @@ FontAtlas::FontAtlas(FT_FaceRec_* face, int pixelSize) {
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, _width, _height, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
 
-  int textureOffset = 0;
+  // Zeroed so padding and free space read as far outside any glyph
+  std::vector<uint8_t> clearData(AtlasSize * AtlasSize, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, AtlasSize, AtlasSize, 0, GL_RED, GL_UNSIGNED_BYTE, clearData.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+FontAtlas::~FontAtlas() {
+  glDeleteTextures(1, &_textureId);
+}
 
-  std::vector<unsigned char> emptyBuffer;
-  emptyBuffer.resize(_height, 0);
+uint32_t FontAtlas::findGlyph(uint32_t codepoint) {
+  uint32_t glyph = InvalidGlyph;
 
-  for(unsigned char i = 0; i < charCount; ++i) {
-    if(FT_Load_Char(face, i, FT_LOAD_RENDER))
-      continue;
+  if (codepoint < _asciiGlyphs.size() && _asciiGlyphs[codepoint] != InvalidGlyph) {
+    glyph = _asciiGlyphs[codepoint];
+  }
+  else {
+    auto it = _glyphIndices.find(codepoint);
+    if (it != _glyphIndices.end()) {
+      glyph = it->second;
+    }
+    else {
+      // Glyphs missing from the font are remembered, the loader is not called every frame for them.
+      // Glyphs that do not fit are not, there may be room in a later frame.
+      FontGlyph loaded;
+      if (_loader(codepoint, loaded)) {
+        glyph = addGlyph(loaded);
+      }
+      else {
+        _glyphIndices[codepoint] = InvalidGlyph;
+      }
+    }
+  }
+
+  if (glyph != InvalidGlyph) {
+    _glyphs[glyph].lastUsedFrame = _frame;
+  }
 
-    // Add to texture atlas
-    glTexSubImage2D(GL_TEXTURE_2D, 0, textureOffset, 0, 1, face->glyph->bitmap.rows, GL_RED, GL_UNSIGNED_BYTE, emptyBuffer.data());
-    glTexSubImage2D(GL_TEXTURE_2D, 0, textureOffset, 0, face->glyph->bitmap.width, face->glyph->bitmap.rows, GL_RED, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, textureOffset, 0, 1, face->glyph->bitmap.rows, GL_RED, GL_UNSIGNED_BYTE, emptyBuffer.data());
+  return glyph;
+}
+
+void FontAtlas::endFrame(LinearAllocator& allocator, LinearArray<Upload>& uploads) {
+  for (const auto& pending : _pendingUploads) {
+    uint8_t* pixels = allocator.allocate<uint8_t>(pending.pixels.size());
+    memcpy(pixels, pending.pixels.data(), pending.pixels.size());
+    uploads.push_back({ pending.rect, pixels });
+  }
 
-    // Store character info
-    // Note: advance is the horizontal distance (in 1/64th pixels) from the origin to the origin of the next glyph
-    _characters[i].advance = glm::ivec2(face->glyph->advance.x >> 6, face->glyph->advance.y >> 6);
-    _characters[i].size = glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows);
-    _characters[i].bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+  _pendingUploads.clear();
+  _frame++;
+}
 
-    const int nextTextureOffset = textureOffset + face->glyph->bitmap.width + padding;
-    _characters[i].atlasOffsets[0] = (float)textureOffset / (float)_width;
-    _characters[i].atlasOffsets[1] = (float)(nextTextureOffset) / (float)_width;
+void FontAtlas::applyUploads(const Upload* uploads, uint32_t count) const {
+  if (count == 0)
+    return;
 
-    textureOffset = nextTextureOffset;
+  glBindTexture(GL_TEXTURE_2D, _textureId);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto& rect = uploads[i].rect;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.z, rect.w, GL_RED, GL_UNSIGNED_BYTE, uploads[i].pixels);
   }
 
   glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
-FontAtlas::~FontAtlas() {
-  glDeleteTextures(1, &_textureId);
+/*static*/ FontAtlasRef FontAtlas::Create(GlyphLoader loader, const std::vector<FontGlyph>& glyphs, float metricsScale) {
+  auto atlas = FontAtlasRef(new FontAtlas(loader, metricsScale));
+
+  for (const auto& glyph : glyphs) {
+    if (atlas->addGlyph(glyph) == InvalidGlyph) {
+      LOG_WARN("[FontAtlas] No room to preload glyph {}", glyph.codepoint);
+    }
+  }
+
+  // Created on the GL thread, the preloaded glyphs go in right away
+  LinearAllocator allocator;
+  LinearArray<Upload> uploads(allocator);
+  atlas->endFrame(allocator, uploads);
+  atlas->applyUploads(uploads.data(), uploads.size());
+
+  return atlas;
 }
 
-/*static*/ FontAtlasRef FontAtlas::Create(FT_LibraryRec_* library, const char* fontFile, int pixelSize) {
-  FT_Face face;
-  if (FT_New_Face(library, fontFile, 0, &face)) {
-    LOG_ERROR("[FontAtlas] Failed to load font {}", fontFile);
-    return nullptr;
+uint32_t FontAtlas::addGlyph(const FontGlyph& source) {
+  // Blank glyphs (spaces) only keep their metrics, they take no room in the texture
+  const bool blank = source.size.x == 0 || source.size.y == 0;
+  const int width = blank ? 0 : source.size.x + Padding;
+  const int height = blank ? 0 : source.size.y + Padding;
+
+  uint32_t shelf = NoShelf;
+  int x = 0;
+  if (!blank && !allocate(width, height, shelf, x) && !evictFor(width, height, shelf, x))
+    return InvalidGlyph;
+
+  uint32_t index;
+  if (!_freeGlyphs.empty()) {
+    index = _freeGlyphs.back();
+    _freeGlyphs.pop_back();
+  }
+  else {
+    index = (uint32_t)_glyphs.size();
+    _glyphs.emplace_back();
   }
 
-  auto fontAtlas = FontAtlasRef(new FontAtlas(face, pixelSize));
+  const int y = blank ? 0 : _shelves[shelf].y;
 
-  FT_Done_Face(face);
+  Glyph& glyph = _glyphs[index];
+  glyph.codepoint = source.codepoint;
+  glyph.lastUsedFrame = _frame;
+  glyph.shelf = shelf;
+  glyph.x = x;
+  glyph.width = width;
+  glyph.info.advance = source.advance * _metricsScale;
+  glyph.info.bearing = source.bearing * _metricsScale;
+  glyph.info.size = glm::vec2(source.size) * _metricsScale;
+  glyph.info.atlasRect = glm::vec4(x, y, x + source.size.x, y + source.size.y) / (float)AtlasSize;
+
+  // The padding is uploaded with the glyph, the slot may hold an evicted one
+  if (!blank) {
+    PendingUpload upload;
+    upload.rect = glm::ivec4(x, y, width, height);
+    upload.pixels.resize(width * height, 0);
+    for (int row = 0; row < source.size.y; ++row) {
+      memcpy(&upload.pixels[row * width], &source.bitmap[row * source.size.x], source.size.x);
+    }
+    _pendingUploads.push_back(std::move(upload));
+  }
+
+  _glyphIndices[source.codepoint] = index;
+  if (source.codepoint < _asciiGlyphs.size()) {
+    _asciiGlyphs[source.codepoint] = index;
+  }
 
-  return fontAtlas;
+  return index;
+}
+
+bool FontAtlas::allocate(int width, int height, uint32_t& shelf, int& x) {
+  if (width > (int)AtlasSize || height > (int)AtlasSize)
+    return false;
+
+  // Best fitting shelf no more than half again as tall as the glyph
+  uint32_t best = InvalidGlyph;
+  for (uint32_t i = 0; i < _shelves.size(); ++i) {
+    const Shelf& candidate = _shelves[i];
+    if (candidate.height < height || candidate.height > height + height / 2)
+      continue;
+
+    if (best == InvalidGlyph || candidate.height < _shelves[best].height) {
+      const bool fits = candidate.end + width <= (int)AtlasSize
+        || std::any_of(candidate.freeSpans.begin(), candidate.freeSpans.end(), [width](const glm::ivec2& span) { return span.y >= width; });
+      if (fits) {
+        best = i;
+      }
+    }
+  }
+
+  if (best != InvalidGlyph) {
+    shelf = best;
+    return allocateInShelf(_shelves[best], width, x);
+  }
+
+  // New shelf below the last one
+  const int shelfHeight = ((height + ShelfGranularity - 1) / ShelfGranularity) * ShelfGranularity;
+  if (_shelvesEnd + shelfHeight > (int)AtlasSize)
+    return false;
+
+  _shelves.push_back({ _shelvesEnd, shelfHeight, 0, {} });
+  _shelvesEnd += shelfHeight;
+
+  shelf = (uint32_t)_shelves.size() - 1;
+  return allocateInShelf(_shelves.back(), width, x);
+}
+
+bool FontAtlas::allocateInShelf(Shelf& shelf, int width, int& x) {
+  // Spans freed by evictions first
+  for (size_t i = 0; i < shelf.freeSpans.size(); ++i) {
+    glm::ivec2& span = shelf.freeSpans[i];
+    if (span.y < width)
+      continue;
+
+    x = span.x;
+    span.x += width;
+    span.y -= width;
+    if (span.y == 0) {
+      shelf.freeSpans.erase(shelf.freeSpans.begin() + i);
+    }
+
+    return true;
+  }
+
+  if (shelf.end + width > (int)AtlasSize)
+    return false;
+
+  x = shelf.end;
+  shelf.end += width;
+
+  return true;
+}
+
+bool FontAtlas::evictFor(int width, int height, uint32_t& shelf, int& x) {
+  // Oldest first, glyphs used this frame may be referenced by text already submitted
+  std::vector<uint32_t> candidates;
+  for (const auto& entry : _glyphIndices) {
+    if (entry.second == InvalidGlyph)
+      continue;
+
+    const Glyph& glyph = _glyphs[entry.second];
+    if (glyph.shelf != NoShelf && glyph.lastUsedFrame < _frame && _shelves[glyph.shelf].height >= height) {
+      candidates.push_back(entry.second);
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+    return _glyphs[a].lastUsedFrame < _glyphs[b].lastUsedFrame;
+  });
+
+  for (uint32_t candidate : candidates) {
+    const uint32_t candidateShelf = _glyphs[candidate].shelf;
+    releaseGlyph(candidate);
+
+    if (allocateInShelf(_shelves[candidateShelf], width, x)) {
+      shelf = candidateShelf;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void FontAtlas::releaseGlyph(uint32_t index) {
+  Glyph& glyph = _glyphs[index];
+  Shelf& shelf = _shelves[glyph.shelf];
+
+  _glyphIndices.erase(glyph.codepoint);
+  if (glyph.codepoint < _asciiGlyphs.size()) {
+    _asciiGlyphs[glyph.codepoint] = InvalidGlyph;
+  }
+  _freeGlyphs.push_back(index);
+  _evictions++;
+
+  // Sorted spans, merged with their neighbours and folded back into the end when they reach it
+  glm::ivec2 span(glyph.x, glyph.width);
+  auto it = std::lower_bound(shelf.freeSpans.begin(), shelf.freeSpans.end(), span, [](const glm::ivec2& a, const glm::ivec2& b) {
+    return a.x < b.x;
+  });
+  it = shelf.freeSpans.insert(it, span);
+
+  if (it + 1 != shelf.freeSpans.end() && it->x + it->y == (it + 1)->x) {
+    it->y += (it + 1)->y;
+    shelf.freeSpans.erase(it + 1);
+  }
+  if (it != shelf.freeSpans.begin() && (it - 1)->x + (it - 1)->y == it->x) {
+    (it - 1)->y += it->y;
+    it = shelf.freeSpans.erase(it) - 1;
+  }
+  if (it->x + it->y == shelf.end) {
+    shelf.end = it->x;
+    shelf.freeSpans.erase(it);
+  }
 }
@@ -1,41 +1,126 @@
 #pragma once
 
+#include "core/linear_allocator.h"
+
 class FontAtlas;
 typedef std::shared_ptr<FontAtlas> FontAtlasRef;
 
-struct FT_LibraryRec_;
-struct FT_FaceRec_;
+// Signed distance field of one character, metrics in pixels of the size it was rendered at
+struct FontGlyph {
+  uint32_t   codepoint;
+  glm::vec2  advance;
+  glm::vec2  bearing;
+  glm::ivec2 size;
+  std::vector<uint8_t> bitmap; // size.x * size.y, top row first
+};
 
+// Distance field glyphs packed in shelves of a square single-channel texture, sampled with linear
+// filtering so one atlas serves every text scale.
+//
+// Glyphs are loaded on first use from any codepoint. When the atlas is full the least recently used
+// glyphs are evicted, never the ones used in the current frame. Lookups and loads happen on the update
+// thread, the texture changes are handed to the frame in endFrame() and applied by the render side in
+// frame order, so frames in flight keep seeing the glyphs they were built with.
 class FontAtlas {
 public:
+  typedef std::function<bool(uint32_t codepoint, FontGlyph& glyph)> GlyphLoader;
+
+  enum : uint32_t {
+    AtlasSize = 1024,
+    Padding = 1,          // Zeroed texels right and below every glyph
+    ShelfGranularity = 8, // Shelf heights are rounded up to this
+    InvalidGlyph = ~0u,
+  };
+
+  // Metrics in pixels of the size text is laid out at with scale 1
   struct CharacterInfo {
-    glm::ivec2 advance;
-    glm::ivec2 bearing;
-    glm::ivec2 size;
-    glm::vec2  atlasOffsets;
+    glm::vec2 advance;
+    glm::vec2 bearing;
+    glm::vec2 size;
+    glm::vec4 atlasRect; // u0, v0 (top), u1, v1 (bottom)
+  };
+
+  // Texture region to overwrite, pixels live in the frame allocator
+  struct Upload {
+    glm::ivec4     rect; // x, y, width, height
+    const uint8_t* pixels;
   };
 
 public:
   ~FontAtlas();
 
-  int getHeight() const { return _height; }
-  int getWidth() const { return _width; }
+  // Update thread. Loads the glyph on first use and marks it used this frame, InvalidGlyph when the
+  // font has no such glyph or it does not fit.
+  uint32_t findGlyph(uint32_t codepoint);
+  const CharacterInfo& getGlyphInfo(uint32_t glyph) const { return _glyphs[glyph].info; }
+  // Keeps a glyph found in an earlier frame from being evicted in this one
+  void touchGlyph(uint32_t glyph) { _glyphs[glyph].lastUsedFrame = _frame; }
+
+  // Glyph ids found before a change of this count may have been evicted
+  uint32_t getEvictionCount() const { return _evictions; }
+  uint32_t getGlyphCount() const { return (uint32_t)(_glyphs.size() - _freeGlyphs.size()); }
+
+  // Update thread, moves the texture changes of the frame into its allocator
+  void endFrame(LinearAllocator& allocator, LinearArray<Upload>& uploads);
 
-  const CharacterInfo* getCharacterInfo(uint8_t c) const {
-    return (c < _characters.max_size()) ? &_characters[c] : nullptr;
-  }
+  // Render thread
+  void applyUploads(const Upload* uploads, uint32_t count) const;
   uint32_t id() const { return _textureId; }
 
-  static FontAtlasRef Create(FT_LibraryRec_* library, const char* fontFile, int pixelSize);
+  // metricsScale converts the glyph metrics to layout pixels, glyphs are preloaded
+  static FontAtlasRef Create(GlyphLoader loader, const std::vector<FontGlyph>& glyphs, float metricsScale);
 
 private:
+  struct Glyph {
+    CharacterInfo info;
+    uint32_t codepoint;
+    uint64_t lastUsedFrame;
+    uint32_t shelf; // NoShelf for blank glyphs
+    int      x;
+    int      width; // Allocated, padding included
+  };
+
+  enum : uint32_t {
+    NoShelf = ~0u,
+  };
+
+  struct Shelf {
+    int y;
+    int height;
+    int end; // Right of the last allocation
+    std::vector<glm::ivec2> freeSpans; // x, width, left of end
+  };
+
+  struct PendingUpload {
+    glm::ivec4 rect;
+    std::vector<uint8_t> pixels;
+  };
+
   FontAtlas() = delete;
   FontAtlas(const FontAtlas&) = delete;
-  FontAtlas(FT_FaceRec_* face, int pixelSize);
+  FontAtlas(GlyphLoader loader, float metricsScale);
+
+  uint32_t addGlyph(const FontGlyph& glyph);
+  bool allocate(int width, int height, uint32_t& shelf, int& x);
+  bool allocateInShelf(Shelf& shelf, int width, int& x);
+  bool evictFor(int width, int height, uint32_t& shelf, int& x);
+  void releaseGlyph(uint32_t glyph);
 
 private:
-  std::array<CharacterInfo, 128> _characters;
+  GlyphLoader _loader;
+  float       _metricsScale;
+
+  std::vector<Glyph>    _glyphs;
+  std::vector<uint32_t> _freeGlyphs;
+  std::unordered_map<uint32_t, uint32_t> _glyphIndices; // Codepoint to glyph, InvalidGlyph for failed loads
+  std::array<uint32_t, 128> _asciiGlyphs;
+
+  std::vector<Shelf> _shelves;
+  int _shelvesEnd; // Bottom of the last shelf
+
+  std::vector<PendingUpload> _pendingUploads;
+
+  uint64_t _frame;
+  uint32_t _evictions;
   uint32_t _textureId = 0;
-  int _width = 0;
-  int _height = 0;
 };
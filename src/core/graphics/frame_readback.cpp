@@ -0,0 +1,116 @@
+#include "frame_readback.h"
+
+#include <glad/glad.h>
+
+FrameReadback::FrameReadback()
+  : _next(0)
+  , _pending(0)
+  , _dropped(0) {
+  for (auto& slot : _slots) {
+    glGenBuffers(1, &slot.buffer);
+    slot.size = 0;
+    slot.fence = nullptr;
+    slot.width = 0;
+    slot.height = 0;
+    slot.tag = 0;
+  }
+}
+
+FrameReadback::~FrameReadback() {
+  for (auto& slot : _slots) {
+    if (slot.fence != nullptr) {
+      glDeleteSync((GLsync)slot.fence);
+    }
+    glDeleteBuffers(1, &slot.buffer);
+  }
+}
+
+/*static*/ FrameReadbackRef FrameReadback::Create() {
+  FrameReadbackRef readback(new FrameReadback());
+
+  return readback;
+}
+
+bool FrameReadback::request(uint32_t width, uint32_t height, uint64_t tag) {
+  if (_pending == SlotCount)
+    return false;
+
+  Slot& slot = _slots[_next];
+  const uint32_t size = width * height * 3;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  if (size > slot.size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    slot.size = size;
+  }
+
+  // Rows of odd widths are not 4 byte aligned
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.width = width;
+  slot.height = height;
+  slot.tag = tag;
+
+  _next = (_next + 1) % SlotCount;
+  _pending++;
+
+  return true;
+}
+
+void FrameReadback::update(const ConsumeFn& consume, bool wait) {
+  while (_pending > 0) {
+    Slot& slot = _slots[(_next + SlotCount - _pending) % SlotCount];
+
+    const GLuint64 timeout = wait ? 1000000000ull : 0;
+    const GLenum result = glClientWaitSync((GLsync)slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (result == GL_TIMEOUT_EXPIRED)
+      break;
+
+    bool consumed = true;
+    if (result == GL_WAIT_FAILED) {
+      // The fence will never signal, the frame is lost but the slot must not stay in flight
+      LOG_ERROR("[FrameReadback] Fence wait failed, dropping frame {}", slot.tag);
+      _dropped++;
+    }
+    else {
+      const uint32_t size = slot.width * slot.height * 3;
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+      if (pixels != nullptr) {
+        consumed = consume({ (const uint8_t*)pixels, slot.width, slot.height, slot.tag });
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      }
+      else {
+        LOG_ERROR("[FrameReadback] Could not map readback, dropping frame {}", slot.tag);
+        _dropped++;
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Consumer is full, try again next update
+    if (!consumed)
+      break;
+
+    glDeleteSync((GLsync)slot.fence);
+    slot.fence = nullptr;
+    _pending--;
+  }
+}
+
+/*static*/ void FrameReadback::CopyToImage(const Frame& frame, ImageData& image) {
+  const uint32_t stride = frame.width * 3;
+  image.width = frame.width;
+  image.height = frame.height;
+  image.bytesPerPixel = 3; // RGB
+  image.data.resize(stride * frame.height);
+
+  for (uint32_t row = 0; row < frame.height; ++row) {
+    memcpy(&image.data[row * stride], frame.pixels + (frame.height - 1 - row) * stride, stride);
+  }
+}
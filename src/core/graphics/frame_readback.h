@@ -0,0 +1,63 @@
+#pragma once
+
+#include "core/file_utils.h"
+
+class FrameReadback;
+typedef std::shared_ptr<FrameReadback> FrameReadbackRef;
+
+// Copies the read framebuffer into pixel pack buffers and maps them once the GPU is done with them,
+// usually a frame or two later, so reading back never stalls the pipeline. Pixels are tightly packed
+// RGB rows, bottom row first.
+class FrameReadback {
+public:
+  enum {
+    SlotCount = 2,
+  };
+
+  struct Frame {
+    const uint8_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    uint64_t tag;
+  };
+
+  // Returns false to keep the frame mapped for the next update
+  typedef std::function<bool(const Frame&)> ConsumeFn;
+
+public:
+  ~FrameReadback();
+
+  static FrameReadbackRef Create();
+
+  // false when every slot is still in flight
+  bool request(uint32_t width, uint32_t height, uint64_t tag);
+  // Hands finished readbacks to consume in request order, wait blocks until all of them are finished
+  void update(const ConsumeFn& consume, bool wait = false);
+
+  bool isIdle() const { return _pending == 0; }
+  // Readbacks lost to a failed fence wait or mapping
+  uint32_t getDroppedCount() const { return _dropped; }
+
+  // RGB image with the rows flipped to top first
+  static void CopyToImage(const Frame& frame, ImageData& image);
+
+private:
+  struct Slot {
+    uint32_t buffer;
+    uint32_t size;
+    void*    fence; // GLsync
+    uint32_t width;
+    uint32_t height;
+    uint64_t tag;
+  };
+
+private:
+  FrameReadback();
+  FrameReadback(FrameReadback&) = delete;
+
+private:
+  std::array<Slot, SlotCount> _slots;
+  uint32_t _next;
+  uint32_t _pending;
+  uint32_t _dropped;
+};
@@ -0,0 +1,135 @@
+#include "frame_recorder.h"
+
+#include <SDL.h>
+
+#define RECORDER_BUFFER_COUNT 4
+#define RECORDER_VIDEO_FPS 60
+
+FrameRecorder::FrameRecorder()
+  : _format(Format::Y4M)
+  , _interval(0)
+  , _frame(0)
+  , _requested(0)
+  , _fpsStart(0)
+  , _fpsStartCount(0)
+  , _capturedFps(0.0f)
+  , _waitMs(0.0f) {
+}
+
+FrameRecorder::~FrameRecorder() {
+  shutdown();
+}
+
+void FrameRecorder::init() {
+  _readback = FrameReadback::Create();
+  _writer.start(RECORDER_BUFFER_COUNT);
+}
+
+void FrameRecorder::shutdown() {
+  if (!_readback)
+    return;
+
+  stop();
+  _writer.stop();
+  _readback = nullptr;
+}
+
+void FrameRecorder::start(uint32_t interval, Format format) {
+  stop();
+
+  if (interval == 0)
+    return;
+
+  char name[128];
+  sprintf(name, "_captures/recording_%ld", (long)time(NULL));
+
+  _name = name;
+  _format = format;
+  _interval = interval;
+  _frame = 0;
+  _requested = 0;
+  _fpsStart = SDL_GetPerformanceCounter();
+  _fpsStartCount = _writer.getWrittenCount();
+  _capturedFps = 0.0f;
+  _waitMs = 0.0f;
+
+  LOG_INFO("[FrameRecorder] Recording every {} frame(s) to {} ({})", interval, _name, GetFormatName(format));
+}
+
+void FrameRecorder::stop() {
+  if (!isRecording())
+    return;
+
+  while (!_readback->isIdle()) {
+    collect(true);
+  }
+  if (_format == Format::Y4M) {
+    _writer.closeVideo();
+  }
+
+  _interval = 0;
+
+  LOG_INFO("[FrameRecorder] Stopped, {} frame(s) recorded", _requested);
+}
+
+void FrameRecorder::captureFrame(uint32_t width, uint32_t height) {
+  if (!isRecording())
+    return;
+
+  collect(false);
+
+  const uint64_t now = SDL_GetPerformanceCounter();
+  const double elapsed = (double)(now - _fpsStart) / (double)SDL_GetPerformanceFrequency();
+  if (elapsed >= 1.0) {
+    const uint32_t count = _writer.getWrittenCount();
+    _capturedFps = (float)((count - _fpsStartCount) / elapsed);
+    _fpsStart = now;
+    _fpsStartCount = count;
+  }
+
+  if (_frame++ % _interval != 0)
+    return;
+
+  if (!_readback->request(width, height, _requested)) {
+    // Both readbacks in flight, the writer is behind: wait for it rather than drop the frame. A wait
+    // gives up after the fence timeout, so it is repeated until a slot frees up.
+    const uint64_t waitStart = SDL_GetPerformanceCounter();
+    do {
+      collect(true);
+    } while (!_readback->request(width, height, _requested));
+    _waitMs += (float)((SDL_GetPerformanceCounter() - waitStart) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+  }
+
+  _requested++;
+}
+
+void FrameRecorder::collect(bool wait) {
+  _readback->update([this, wait](const FrameReadback::Frame& frame) {
+    ImageData* image = _writer.acquire(wait);
+    if (image == nullptr)
+      return false;
+
+    FrameReadback::CopyToImage(frame, *image);
+
+    if (_format == Format::Y4M) {
+      _writer.writeVideoFrame(image, _name + ".y4m", RECORDER_VIDEO_FPS, _interval);
+    }
+    else {
+      char filename[32];
+      sprintf(filename, "/frame_%06llu.%s", (unsigned long long)frame.tag, _format == Format::PNG ? "png" : "jpg");
+      _writer.write(image, _name + filename);
+    }
+
+    return true;
+  }, wait);
+}
+
+/*static*/ const char* FrameRecorder::GetFormatName(Format format) {
+  switch (format) {
+  case Format::Y4M:  return "Y4M";
+  case Format::PNG:  return "PNG";
+  case Format::JPEG: return "JPEG";
+  }
+
+  return "";
+}
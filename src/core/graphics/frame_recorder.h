@@ -0,0 +1,57 @@
+#pragma once
+
+#include "frame_readback.h"
+#include "core/image_writer.h"
+
+// Records every Nth rendered frame into a Y4M video or an image sequence under _captures/. Frames are read
+// back asynchronously and converted and written on an ImageWriter thread. Its buffers are pooled: when the
+// disk falls behind, the render thread waits for it instead of dropping frames.
+class FrameRecorder {
+public:
+  enum class Format {
+    Y4M = 0,
+    PNG,
+    JPEG,
+  };
+
+public:
+  FrameRecorder();
+  ~FrameRecorder();
+
+  void init();
+  void shutdown();
+
+  void start(uint32_t interval, Format format);
+  // Writes the frames already captured
+  void stop();
+
+  bool isRecording() const { return _interval > 0; }
+
+  // GL thread, after the frame is rendered to the backbuffer
+  void captureFrame(uint32_t width, uint32_t height);
+
+  uint32_t getCapturedCount() const { return _writer.getWrittenCount(); }
+  uint32_t getDroppedCount() const { return _readback ? _readback->getDroppedCount() : 0; }
+  float getCapturedFps() const { return _capturedFps; }
+  // Render thread time spent waiting for the writer
+  float getWaitMs() const { return _waitMs; }
+
+  static const char* GetFormatName(Format format);
+
+private:
+  void collect(bool wait);
+
+private:
+  FrameReadbackRef _readback;
+  ImageWriter _writer;
+  Format      _format;
+  std::string _name;
+  uint32_t    _interval;
+  uint32_t    _frame;
+  uint32_t    _requested;
+
+  uint64_t _fpsStart; // SDL performance counter
+  uint32_t _fpsStartCount;
+  float    _capturedFps;
+  float    _waitMs;
+};
@@ -0,0 +1,242 @@
+#include "geometry_arena.h"
+#include "mesh.h"
+
+#include <glad/glad.h>
+
+#define GEOMETRY_BUFFER_VERTICES (256 * 1024)
+#define GEOMETRY_BUFFER_INDICES  (1024 * 1024)
+
+static std::array<std::vector<GeometryBufferRef>, (size_t)VertexFormat::Count> gBuffers;
+static VBORef gDrawIdBuffer;
+static VBORef gInstanceListBuffer;
+
+// RangeAllocator
+RangeAllocator::RangeAllocator(uint32_t capacity)
+  : _capacity(capacity)
+  , _used(0) {
+  if (capacity > 0) {
+    _freeBlocks.insert({ 0, capacity });
+  }
+}
+
+uint32_t RangeAllocator::allocate(uint32_t size) {
+  if (size == 0)
+    return InvalidOffset;
+
+  for (auto iter = _freeBlocks.begin(); iter != _freeBlocks.end(); ++iter) {
+    if (iter->second < size)
+      continue;
+
+    const uint32_t offset = iter->first;
+    const uint32_t remaining = iter->second - size;
+
+    _freeBlocks.erase(iter);
+    if (remaining > 0) {
+      _freeBlocks.insert({ offset + size, remaining });
+    }
+
+    _used += size;
+
+    return offset;
+  }
+
+  return InvalidOffset;
+}
+
+void RangeAllocator::release(uint32_t offset, uint32_t size) {
+  if (size == 0 || offset == InvalidOffset)
+    return;
+
+  _used -= size;
+
+  auto next = _freeBlocks.lower_bound(offset);
+
+  if (next != _freeBlocks.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      _freeBlocks.erase(prev);
+    }
+  }
+
+  if (next != _freeBlocks.end() && offset + size == next->first) {
+    size += next->second;
+    _freeBlocks.erase(next);
+  }
+
+  _freeBlocks.insert({ offset, size });
+}
+
+// GeometryBuffer
+GeometryBuffer::GeometryBuffer(VertexFormat format, uint32_t vertexCapacity, uint32_t indexCapacity)
+  : _format(format)
+  , _vertices(vertexCapacity)
+  , _indices(indexCapacity) {
+
+  _vbo = VBO::Create(GeometryArena::vertexStride(format) * vertexCapacity, GeometryArena::vertexLayout(format));
+  _ibo = IBO::Create(indexCapacity);
+
+  _vao = VAO::Create();
+  _vao->addVertexBuffer(_vbo);
+  _vao->addVertexBuffer(GeometryArena::drawIdBuffer(), GeometryArena::DrawIdAttribute);
+  _vao->setIndexBuffer(_ibo);
+
+  if (auto instanceList = GeometryArena::instanceListBuffer()) {
+    _instanceListVao = VAO::Create();
+    _instanceListVao->addVertexBuffer(_vbo);
+    _instanceListVao->addVertexBuffer(instanceList, GeometryArena::DrawIdAttribute);
+    _instanceListVao->setIndexBuffer(_ibo);
+  }
+}
+
+/*static*/ GeometryBufferRef GeometryBuffer::Create(VertexFormat format, uint32_t vertexCapacity, uint32_t indexCapacity) {
+  GeometryBufferRef buffer(new GeometryBuffer(format, vertexCapacity, indexCapacity));
+
+  return buffer;
+}
+
+void GeometryBuffer::bind(DrawIdSource source) {
+  if (source == DrawIdSource::InstanceList && _instanceListVao) {
+    _instanceListVao->bind();
+  }
+  else {
+    _vao->bind();
+  }
+}
+
+bool GeometryBuffer::allocate(uint32_t vertexCount, uint32_t indexCount, GeometryRange& range) {
+  const uint32_t baseVertex = _vertices.allocate(vertexCount);
+  if (baseVertex == RangeAllocator::InvalidOffset)
+    return false;
+
+  const uint32_t firstIndex = _indices.allocate(indexCount);
+  if (firstIndex == RangeAllocator::InvalidOffset) {
+    _vertices.release(baseVertex, vertexCount);
+    return false;
+  }
+
+  range.baseVertex = baseVertex;
+  range.vertexCount = vertexCount;
+  range.firstIndex = firstIndex;
+  range.indexCount = indexCount;
+
+  return true;
+}
+
+void GeometryBuffer::release(const GeometryRange& range) {
+  _vertices.release(range.baseVertex, range.vertexCount);
+  _indices.release(range.firstIndex, range.indexCount);
+}
+
+void GeometryBuffer::upload(const GeometryRange& range, const void* vertices, const uint32_t* indices) {
+  const uint32_t stride = GeometryArena::vertexStride(_format);
+
+  _vbo->uploadData(vertices, stride * range.vertexCount, stride * range.baseVertex);
+  _ibo->uploadData(indices, range.indexCount, range.firstIndex);
+}
+
+// GeometryArena
+/*static*/ uint32_t GeometryArena::vertexStride(VertexFormat format) {
+  switch (format) {
+    case VertexFormat::Standard: return sizeof(Vertex);
+    case VertexFormat::Position: return sizeof(glm::vec3);
+    default: return 0;
+  }
+}
+
+/*static*/ BufferLayout GeometryArena::vertexLayout(VertexFormat format) {
+  switch (format) {
+    case VertexFormat::Standard:
+      return BufferLayout({
+        { BufferItemType::Float3, "position" },
+        { BufferItemType::Float3, "normal" },
+        { BufferItemType::Float2, "texCoords" },
+        { BufferItemType::Float3, "tangent" }
+      });
+    case VertexFormat::Position:
+      return BufferLayout({
+        { BufferItemType::Float3, "position" }
+      });
+    default:
+      return BufferLayout();
+  }
+}
+
+/*static*/ GeometryRange GeometryArena::allocate(VertexFormat format, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+  GeometryRange range;
+
+  if (vertexCount == 0 || indexCount == 0)
+    return range;
+
+  auto& buffers = gBuffers[(size_t)format];
+
+  GeometryBufferRef target;
+  for (auto& buffer : buffers) {
+    if (buffer->allocate(vertexCount, indexCount, range)) {
+      target = buffer;
+      break;
+    }
+  }
+
+  if (!target) {
+    const uint32_t vertexCapacity = std::max(vertexCount, (uint32_t)GEOMETRY_BUFFER_VERTICES);
+    const uint32_t indexCapacity = std::max(indexCount, (uint32_t)GEOMETRY_BUFFER_INDICES);
+
+    LOG_INFO("[GeometryArena] Creating buffer {} for format {} ({} vertices, {} indices)", buffers.size(), (int)format, vertexCapacity, indexCapacity);
+
+    target = GeometryBuffer::Create(format, vertexCapacity, indexCapacity);
+    target->allocate(vertexCount, indexCount, range);
+    buffers.push_back(target);
+  }
+
+  target->upload(range, vertices, indices);
+  range.buffer = target;
+
+  return range;
+}
+
+/*static*/ void GeometryArena::release(GeometryRange& range) {
+  if (range.buffer) {
+    range.buffer->release(range);
+    range = GeometryRange();
+  }
+}
+
+/*static*/ const std::vector<GeometryBufferRef>& GeometryArena::buffers(VertexFormat format) {
+  return gBuffers[(size_t)format];
+}
+
+/*static*/ VBORef GeometryArena::drawIdBuffer() {
+  if (!gDrawIdBuffer) {
+    std::vector<int> drawIds(MaxDrawIds);
+    std::iota(drawIds.begin(), drawIds.end(), 0);
+
+    gDrawIdBuffer = VBO::Create(drawIds.data(), sizeof(int) * drawIds.size(), BufferLayout({
+      { BufferItemType::Int, "drawId" }
+    }));
+    gDrawIdBuffer->setFlag(VBO::Flag_Instance);
+  }
+
+  return gDrawIdBuffer;
+}
+
+/*static*/ VBORef GeometryArena::instanceListBuffer() {
+  if (!gInstanceListBuffer && GLAD_GL_VERSION_4_3) {
+    gInstanceListBuffer = VBO::Create(sizeof(uint32_t) * MaxInstanceListIds, BufferLayout({
+      { BufferItemType::Int, "drawId" }
+    }));
+    gInstanceListBuffer->setFlag(VBO::Flag_Instance);
+  }
+
+  return gInstanceListBuffer;
+}
+
+/*static*/ void GeometryArena::shutdown() {
+  for (auto& buffers : gBuffers) {
+    buffers.clear();
+  }
+
+  gDrawIdBuffer.reset();
+  gInstanceListBuffer.reset();
+}
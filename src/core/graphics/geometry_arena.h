@@ -0,0 +1,116 @@
+#pragma once
+
+#include "buffers.h"
+
+// First-fit free list over [0, capacity), adjacent free blocks are coalesced on release
+class RangeAllocator {
+public:
+  static constexpr uint32_t InvalidOffset = ~0u;
+
+  RangeAllocator(uint32_t capacity);
+
+  uint32_t allocate(uint32_t size);
+  void     release(uint32_t offset, uint32_t size);
+
+  uint32_t capacity() const { return _capacity; }
+  uint32_t used() const { return _used; }
+
+private:
+  typedef std::map<uint32_t, uint32_t> FreeBlocks; // offset -> size
+
+  FreeBlocks _freeBlocks;
+  uint32_t   _capacity;
+  uint32_t   _used;
+};
+
+enum class VertexFormat : uint8_t {
+  Standard = 0, // Vertex: position, normal, texCoords, tangent
+  Position,     // glm::vec3
+  Count
+};
+
+// Where the per-instance draw id (attr_draw_id) is sourced from
+enum class DrawIdSource : uint8_t {
+  Sequential = 0, // 0..N, a command's baseInstance is its draw index
+  InstanceList    // Draw ids written by GPU culling, see GeometryArena::instanceListBuffer
+};
+
+class GeometryBuffer;
+typedef std::shared_ptr<GeometryBuffer> GeometryBufferRef;
+
+struct GeometryRange {
+  GeometryRange()
+    : baseVertex(0)
+    , vertexCount(0)
+    , firstIndex(0)
+    , indexCount(0) {
+  }
+
+  bool valid() const { return buffer != nullptr; }
+
+  GeometryBufferRef buffer;
+  uint32_t baseVertex;
+  uint32_t vertexCount;
+  uint32_t firstIndex;
+  uint32_t indexCount;
+};
+
+// Shared VAO/VBO/IBO for one vertex format, meshes sub-allocate vertex and index ranges from it
+class GeometryBuffer {
+public:
+  static GeometryBufferRef Create(VertexFormat format, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+  VertexFormat format() const { return _format; }
+  uint32_t id() const { return _vbo->id(); }
+  const VAORef& vao() const { return _vao; }
+
+  void bind(DrawIdSource source = DrawIdSource::Sequential);
+  bool allocate(uint32_t vertexCount, uint32_t indexCount, GeometryRange& range);
+  void release(const GeometryRange& range);
+  void upload(const GeometryRange& range, const void* vertices, const uint32_t* indices);
+
+  uint32_t vertexCapacity() const { return _vertices.capacity(); }
+  uint32_t verticesUsed() const { return _vertices.used(); }
+  uint32_t indexCapacity() const { return _indices.capacity(); }
+  uint32_t indicesUsed() const { return _indices.used(); }
+
+private:
+  GeometryBuffer() = delete;
+  GeometryBuffer(const GeometryBuffer&) = delete;
+  GeometryBuffer(VertexFormat format, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+private:
+  VertexFormat   _format;
+  VAORef         _vao;
+  VAORef         _instanceListVao;
+  VBORef         _vbo;
+  IBORef         _ibo;
+  RangeAllocator _vertices;
+  RangeAllocator _indices;
+};
+
+class GeometryArena {
+public:
+  enum {
+    DrawIdAttribute = 4,  // attr_draw_id in shaders/_draw.inc
+    MaxDrawIds = 64 * 1024,
+    MaxInstanceListIds = 256 * 1024,
+  };
+
+  static uint32_t vertexStride(VertexFormat format);
+  static BufferLayout vertexLayout(VertexFormat format);
+
+  // Uploads vertices and indices into a buffer of the given format, a new buffer is created when none has room
+  static GeometryRange allocate(VertexFormat format, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+  static void release(GeometryRange& range);
+
+  static const std::vector<GeometryBufferRef>& buffers(VertexFormat format);
+
+  // Per-instance stream holding 0..MaxDrawIds-1, on multi-draw paths a command's baseInstance selects its draw id
+  static VBORef drawIdBuffer();
+  // Per-instance stream filled by GPU culling, only created on contexts with compute support (GL 4.3)
+  static VBORef instanceListBuffer();
+
+  // Drops the arena references, buffers still in use are destroyed with their last mesh
+  static void shutdown();
+};
@@ -0,0 +1,257 @@
+#include "gpu_scene.h"
+
+#include <glad/glad.h>
+
+#define INVALID_COMMAND (~0u)
+#define CULL_GROUP_SIZE 64
+
+GPUScene::GPUScene()
+  : _objectCount(0)
+  , _dirtyBegin(~0u)
+  , _dirtyEnd(0)
+  , _commandsDirty(false)
+  , _supported(false) {
+}
+
+void GPUScene::init() {
+  // Compute shaders and storage buffers need GL 4.3 (Mesa llvmpipe provides it, macOS does not)
+  _supported = GLAD_GL_VERSION_4_3 != 0 && GeometryArena::instanceListBuffer() != nullptr;
+  if (!_supported) {
+    LOG_INFO("[GPUScene] Compute shaders not supported, render objects use the CPU path");
+    return;
+  }
+
+  ShaderCreateParams params;
+  params.name = "cull_objects";
+  params.computeShaderPath = "shaders/cull_objects.comp";
+  _cullShader = Shader::Create(params);
+
+  _transformsBuffer = TBO::Create(TBOFormat::RGBA32F, sizeof(glm::mat4) * MaxObjects);
+  _objectsBuffer = SSBO::Create(sizeof(ObjectData) * MaxObjects);
+  _commandTemplates = IndirectBuffer::Create(sizeof(DrawElementsIndirectCommand) * 256);
+  _commandsBuffer = IndirectBuffer::Create(sizeof(DrawElementsIndirectCommand) * 256);
+}
+
+void GPUScene::shutdown() {
+  Shader::Destroy(_cullShader);
+  _cullShader = nullptr;
+}
+
+RenderObjectId GPUScene::createObject(MeshRef mesh, MaterialRef material, const glm::mat4& worldTM, uint32_t drawFlags) {
+  if (!mesh || !material)
+    return INVALID_RENDER_OBJECT;
+
+  RenderObjectId id;
+  if (!_freeSlots.empty()) {
+    id = _freeSlots.back();
+    _freeSlots.pop_back();
+  }
+  else {
+    if (_objects.size() >= MaxObjects) {
+      LOG_WARN("[GPUScene] Object limit {} reached", (int)MaxObjects);
+      return INVALID_RENDER_OBJECT;
+    }
+
+    id = _objects.size();
+    _objects.emplace_back();
+    _objectData.emplace_back();
+    _transforms.emplace_back();
+  }
+
+  const AABB& bounds = mesh->getBounds();
+
+  _objects[id] = { mesh, material, drawFlags, true };
+  _objectData[id].boundsMin = glm::vec4(bounds.min, 0.0f);
+  _objectData[id].boundsMax = glm::vec4(bounds.max, 0.0f);
+  _objectData[id].flags = drawFlags;
+  _transforms[id] = worldTM;
+
+  _dirtyBegin = std::min(_dirtyBegin, id);
+  _dirtyEnd = std::max(_dirtyEnd, id + 1);
+  _commandsDirty = true;
+  _objectCount++;
+
+  return id;
+}
+
+void GPUScene::updateObject(RenderObjectId id, const glm::mat4& worldTM) {
+  if (id >= _objects.size() || !_objects[id].alive)
+    return;
+
+  _transforms[id] = worldTM;
+  _dirtyBegin = std::min(_dirtyBegin, id);
+  _dirtyEnd = std::max(_dirtyEnd, id + 1);
+}
+
+void GPUScene::destroyObject(RenderObjectId id) {
+  if (id >= _objects.size() || !_objects[id].alive)
+    return;
+
+  _objects[id] = Object();
+  _objects[id].alive = false;
+  _freeSlots.push_back(id);
+  _commandsDirty = true;
+  _objectCount--;
+}
+
+void GPUScene::forEachObject(const ObjectCallback& callback) const {
+  for (size_t i = 0; i < _objects.size(); ++i) {
+    auto& object = _objects[i];
+    if (object.alive) {
+      callback(object.mesh, object.material, _transforms[i], object.drawFlags);
+    }
+  }
+}
+
+void GPUScene::prepare() {
+  if (!_supported)
+    return;
+
+  if (_commandsDirty) {
+    rebuildCommands();
+    _commandsDirty = false;
+  }
+
+  if (_dirtyBegin < _dirtyEnd) {
+    _transformsBuffer->updateData(
+      &_transforms[_dirtyBegin],
+      sizeof(glm::mat4) * (_dirtyEnd - _dirtyBegin),
+      sizeof(glm::mat4) * _dirtyBegin
+    );
+
+    _dirtyBegin = ~0u;
+    _dirtyEnd = 0;
+  }
+}
+
+void GPUScene::cull(const Frustum& viewFrustum, const Frustum& shadowFrustum) {
+  if (!_supported || _commands.empty())
+    return;
+
+  // Reset instance counts from the templates, the compute pass appends visible objects
+  glBindBuffer(GL_COPY_READ_BUFFER, _commandTemplates->id());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, _commandsBuffer->id());
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(DrawElementsIndirectCommand) * _commands.size());
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _transformsBuffer->id());
+  _objectsBuffer->bindBase(1);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _commandsBuffer->id());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, GeometryArena::instanceListBuffer()->id());
+
+  const uint32_t slotCount = _objects.size();
+
+  _cullShader->use();
+  _cullShader->setUniformUInt("object_count", slotCount);
+  _cullShader->setUniformVec4Array("frustum_view", viewFrustum.planes.data(), Frustum::PlaneCount);
+  _cullShader->setUniformVec4Array("frustum_shadow", shadowFrustum.planes.data(), Frustum::PlaneCount);
+
+  glDispatchCompute((slotCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GPUScene::bindDrawData(uint32_t transformsSlot) {
+  _transformsBuffer->bind(transformsSlot);
+  _commandsBuffer->bind();
+}
+
+void GPUScene::rebuildCommands() {
+  _commands.clear();
+  _mainBatches.clear();
+  _shadowBatches.clear();
+
+  std::vector<uint32_t> order;
+  order.reserve(_objectCount);
+
+  for (uint32_t i = 0; i < _objects.size(); ++i) {
+    _objectData[i].mainCommand = INVALID_COMMAND;
+    _objectData[i].shadowCommand = INVALID_COMMAND;
+
+    if (_objects[i].alive) {
+      order.push_back(i);
+    }
+  }
+
+  auto geometryFor = [this](uint32_t idx, bool depthOnly) -> const GeometryRange& {
+    const auto& mesh = _objects[idx].mesh;
+
+    return depthOnly && mesh->hasPositionStream() ? mesh->getPositionGeometry() : mesh->getGeometry();
+  };
+
+  // One command per (material, mesh) pair, each object reserves one slot of its command instance list
+  uint32_t instanceOffset = 0;
+  auto appendCommands = [&](bool depthOnly, DrawBatches& batches) {
+    const Mesh* currentMesh = nullptr;
+    const Material* currentMaterial = nullptr;
+
+    for (uint32_t idx : order) {
+      const auto& object = _objects[idx];
+      const auto& geometry = geometryFor(idx, depthOnly);
+      Material* material = depthOnly ? nullptr : object.material.get();
+
+      if (!geometry.valid())
+        continue;
+
+      if (batches.empty() || object.mesh.get() != currentMesh || material != currentMaterial) {
+        if (batches.empty() || batches.back().material != material || batches.back().buffer != geometry.buffer.get()) {
+          batches.push_back({ material, geometry.buffer.get(), (uint32_t)_commands.size(), 0, false });
+        }
+
+        DrawElementsIndirectCommand command;
+        command.count = geometry.indexCount;
+        command.instanceCount = 0;
+        command.firstIndex = geometry.firstIndex;
+        command.baseVertex = geometry.baseVertex;
+        command.baseInstance = instanceOffset;
+
+        _commands.push_back(command);
+        batches.back().commandCount++;
+
+        currentMesh = object.mesh.get();
+        currentMaterial = material;
+      }
+
+      auto& objectData = _objectData[idx];
+      (depthOnly ? objectData.shadowCommand : objectData.mainCommand) = _commands.size() - 1;
+      instanceOffset++;
+    }
+  };
+
+  // Main pass
+  std::sort(order.begin(), order.end(), [this, &geometryFor](uint32_t a, uint32_t b) {
+    const Shader* shaderA = _objects[a].material->getShader().get();
+    const Shader* shaderB = _objects[b].material->getShader().get();
+    const Material* materialA = _objects[a].material.get();
+    const Material* materialB = _objects[b].material.get();
+    const GeometryBuffer* bufferA = geometryFor(a, false).buffer.get();
+    const GeometryBuffer* bufferB = geometryFor(b, false).buffer.get();
+    const Mesh* meshA = _objects[a].mesh.get();
+    const Mesh* meshB = _objects[b].mesh.get();
+
+    return std::tie(shaderA, materialA, bufferA, meshA) < std::tie(shaderB, materialB, bufferB, meshB);
+  });
+
+  appendCommands(false, _mainBatches);
+
+  // Shadow pass
+  order.erase(std::remove_if(order.begin(), order.end(), [this](uint32_t idx) {
+    return (_objects[idx].drawFlags & DrawFlags_Shadow) == 0;
+  }), order.end());
+
+  std::sort(order.begin(), order.end(), [this, &geometryFor](uint32_t a, uint32_t b) {
+    const GeometryBuffer* bufferA = geometryFor(a, true).buffer.get();
+    const GeometryBuffer* bufferB = geometryFor(b, true).buffer.get();
+    const Mesh* meshA = _objects[a].mesh.get();
+    const Mesh* meshB = _objects[b].mesh.get();
+
+    return std::tie(bufferA, meshA) < std::tie(bufferB, meshB);
+  });
+
+  appendCommands(true, _shadowBatches);
+
+  const uint32_t commandsSize = sizeof(DrawElementsIndirectCommand) * _commands.size();
+  _commandTemplates->uploadData(_commands.data(), commandsSize);
+  _commandsBuffer->uploadData(_commands.data(), commandsSize);
+  _objectsBuffer->uploadData(_objectData.data(), sizeof(ObjectData) * _objectData.size());
+
+  LOG_INFO("[GPUScene] Rebuilt {} commands for {} objects", _commands.size(), _objectCount);
+}
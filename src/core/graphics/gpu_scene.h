@@ -0,0 +1,87 @@
+#pragma once
+
+#include "core/bounds.h"
+#include "draw_batch.h"
+#include "material.h"
+#include "mesh.h"
+
+typedef uint32_t RenderObjectId;
+#define INVALID_RENDER_OBJECT (~0u)
+
+// Retained render objects whose bounds and transforms live in GPU buffers. A compute pass
+// frustum culls them every frame and writes the instance lists and instance counts of
+// the indirect commands consumed by the main and shadow passes (requires GL 4.3).
+class GPUScene {
+public:
+  enum {
+    MaxObjects = 64 * 1024,
+  };
+
+  typedef std::function<void(const MeshRef&, const MaterialRef&, const glm::mat4&, uint32_t)> ObjectCallback;
+
+public:
+  GPUScene();
+
+  void init();
+  void shutdown();
+  bool isSupported() const { return _supported; }
+
+  RenderObjectId createObject(MeshRef mesh, MaterialRef material, const glm::mat4& worldTM, uint32_t drawFlags);
+  void updateObject(RenderObjectId id, const glm::mat4& worldTM);
+  void destroyObject(RenderObjectId id);
+
+  uint32_t getObjectCount() const { return _objectCount; }
+
+  // CPU path, visits every live object
+  void forEachObject(const ObjectCallback& callback) const;
+
+  // GPU path: upload pending changes, then run the culling compute pass
+  void prepare();
+  void cull(const Frustum& viewFrustum, const Frustum& shadowFrustum);
+  void bindDrawData(uint32_t transformsSlot);
+
+  const DrawBatches& getMainBatches() const { return _mainBatches; }
+  const DrawBatches& getShadowBatches() const { return _shadowBatches; }
+
+private:
+  struct Object {
+    MeshRef     mesh;
+    MaterialRef material;
+    uint32_t    drawFlags;
+    bool        alive;
+  };
+
+  // Matches ObjectData in shaders/cull_objects.comp (std430)
+  struct ObjectData {
+    glm::vec4 boundsMin;
+    glm::vec4 boundsMax;
+    uint32_t  mainCommand;
+    uint32_t  shadowCommand;
+    uint32_t  flags;
+    uint32_t  padding;
+  };
+
+  void rebuildCommands();
+
+private:
+  std::vector<Object>     _objects;
+  std::vector<ObjectData> _objectData;
+  std::vector<glm::mat4>  _transforms;
+  std::vector<uint32_t>   _freeSlots;
+  uint32_t _objectCount;
+
+  std::vector<DrawElementsIndirectCommand> _commands;
+  DrawBatches _mainBatches;
+  DrawBatches _shadowBatches;
+
+  ShaderRef         _cullShader;
+  TBORef            _transformsBuffer;
+  SSBORef           _objectsBuffer;
+  IndirectBufferRef _commandTemplates;
+  IndirectBufferRef _commandsBuffer;
+
+  uint32_t _dirtyBegin;
+  uint32_t _dirtyEnd;
+  bool     _commandsDirty;
+  bool     _supported;
+};
@@ -0,0 +1,58 @@
+#include "gpu_timer.h"
+
+#include <glad/glad.h>
+
+GPUTimer::GPUTimer()
+  : _next(0)
+  , _pending(0)
+  , _elapsedMs(0.0f)
+  , _active(false) {
+  glGenQueries(QueryCount, _queries);
+}
+
+GPUTimer::~GPUTimer() {
+  glDeleteQueries(QueryCount, _queries);
+}
+
+/*static*/ GPUTimerRef GPUTimer::Create() {
+  GPUTimerRef timer(new GPUTimer());
+
+  return timer;
+}
+
+void GPUTimer::begin() {
+  collectResults();
+
+  // Every query still in flight, skip this sample rather than stall
+  if (_pending == QueryCount)
+    return;
+
+  glBeginQuery(GL_TIME_ELAPSED, _queries[_next]);
+  _active = true;
+}
+
+void GPUTimer::end() {
+  if (!_active)
+    return;
+
+  glEndQuery(GL_TIME_ELAPSED);
+  _next = (_next + 1) % QueryCount;
+  _pending++;
+  _active = false;
+}
+
+void GPUTimer::collectResults() {
+  while (_pending > 0) {
+    const uint32_t query = _queries[(_next + QueryCount - _pending) % QueryCount];
+
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      break;
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+    _elapsedMs = (float)((double)elapsed / 1000000.0);
+    _pending--;
+  }
+}
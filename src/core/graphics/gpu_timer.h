@@ -0,0 +1,35 @@
+#pragma once
+
+class GPUTimer;
+typedef std::shared_ptr<GPUTimer> GPUTimerRef;
+
+// GL_TIME_ELAPSED queries in a small ring, results are read back a few frames late so the CPU never waits
+class GPUTimer {
+public:
+  enum {
+    QueryCount = 4,
+  };
+
+public:
+  ~GPUTimer();
+
+  static GPUTimerRef Create();
+
+  void begin();
+  void end();
+
+  float getElapsedMs() const { return _elapsedMs; }
+
+private:
+  GPUTimer();
+  GPUTimer(GPUTimer&) = delete;
+
+  void collectResults();
+
+private:
+  uint32_t _queries[QueryCount];
+  uint32_t _next;
+  uint32_t _pending;
+  float    _elapsedMs;
+  bool     _active;
+};
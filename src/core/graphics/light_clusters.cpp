@@ -0,0 +1,189 @@
+#include "light_clusters.h"
+
+LightClusters::LightClusters()
+  : _jobSystem(nullptr)
+  , _params(0.0f)
+  , _lightCount(0) {
+}
+
+void LightClusters::init(JobSystem& jobSystem) {
+  _jobSystem = &jobSystem;
+  _lightsBuffer = TBO::Create(TBOFormat::RGBA32F, sizeof(glm::vec4) * 4 * 256);
+  _clustersBuffer = TBO::Create(TBOFormat::RG32UI, sizeof(ClusterEntry) * ClusterCount);
+  _indicesBuffer = TBO::Create(TBOFormat::R32UI, sizeof(uint32_t) * ClusterCount * 8);
+
+  _clusters.resize(ClusterCount);
+  _lightData.reserve(4 * 256);
+  _lightRanges.reserve(256);
+  _indices.reserve(ClusterCount * 8);
+
+  const uint32_t workerCount = std::clamp(jobSystem.getWorkerCount() + 1, 1u, (uint32_t)SlicesZ);
+  _workers.resize(workerCount);
+
+  LOG_INFO("[LightClusters] {}x{}x{} clusters, {} workers", (int)TilesX, (int)TilesY, (int)SlicesZ, workerCount);
+}
+
+void LightClusters::build(const Light* lights, uint32_t lightCount, const Camera& camera) {
+  _lightCount = std::min(lightCount, (uint32_t)MaxLights);
+
+  computeLightRanges(lights, camera);
+
+  // Workers own disjoint ranges of depth slices, so they never write the same cluster
+  uint32_t workerCount = std::min({ (uint32_t)_workers.size(), _jobSystem->getActiveWorkers() + 1, std::max(1u, _lightCount / MinLightsPerWorker) });
+  const uint32_t slicesPerWorker = (SlicesZ + workerCount - 1) / workerCount;
+  workerCount = (SlicesZ + slicesPerWorker - 1) / slicesPerWorker;
+
+  _jobSystem->parallelFor(workerCount, 1, [this, slicesPerWorker](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      const uint32_t sliceBegin = i * slicesPerWorker;
+      const uint32_t sliceEnd = std::min(sliceBegin + slicesPerWorker, (uint32_t)SlicesZ);
+      assignSlices(_workers[i], sliceBegin, sliceEnd);
+    }
+  });
+
+  // Concatenate worker lists, cluster offsets become global
+  _indices.clear();
+  for (uint32_t i = 0; i < workerCount; ++i) {
+    const uint32_t sliceBegin = i * slicesPerWorker;
+    const uint32_t sliceEnd = std::min(sliceBegin + slicesPerWorker, (uint32_t)SlicesZ);
+    const uint32_t base = _indices.size();
+
+    for (uint32_t c = sliceBegin * TilesX * TilesY; c < sliceEnd * TilesX * TilesY; ++c) {
+      _clusters[c].offset += base;
+    }
+
+    _indices.insert(_indices.end(), _workers[i].indices.begin(), _workers[i].indices.end());
+  }
+
+  _lightsBuffer->uploadData(_lightData.data(), sizeof(glm::vec4) * _lightData.size());
+  _clustersBuffer->uploadData(_clusters.data(), sizeof(ClusterEntry) * _clusters.size());
+  _indicesBuffer->uploadData(_indices.data(), sizeof(uint32_t) * _indices.size());
+}
+
+void LightClusters::bind(uint32_t lightsSlot, uint32_t clustersSlot, uint32_t indicesSlot) {
+  _lightsBuffer->bind(lightsSlot);
+  _clustersBuffer->bind(clustersSlot);
+  _indicesBuffer->bind(indicesSlot);
+}
+
+void LightClusters::computeLightRanges(const Light* lights, const Camera& camera) {
+  const float nearPlane = camera.getNearPlane();
+  const float farPlane = camera.getFarPlane();
+  const float logDepthRange = logf(farPlane / nearPlane);
+  const glm::mat4& view = camera.getView();
+  const glm::mat4& proj = camera.getProjection();
+  const glm::vec2& viewport = camera.getViewport();
+
+  // slice = log(depth) * scale + bias
+  _params.x = SlicesZ / logDepthRange;
+  _params.y = -SlicesZ * logf(nearPlane) / logDepthRange;
+  _params.z = TilesX / viewport.x;
+  _params.w = TilesY / viewport.y;
+
+  auto depthSlice = [this](float depth) {
+    return (uint16_t)std::clamp((int)(logf(depth) * _params.x + _params.y), 0, (int)SlicesZ - 1);
+  };
+
+  auto tile = [](float ndc, int tiles) {
+    return (uint16_t)std::clamp((int)((ndc * 0.5f + 0.5f) * tiles), 0, tiles - 1);
+  };
+
+  _lightData.clear();
+  _lightRadii.resize(_lightCount);
+  _lightRanges.resize(_lightCount);
+
+  for (uint32_t i = 0; i < _lightCount; ++i) {
+    const Light& light = lights[i];
+    const auto& props = light.properties;
+    const float radius = std::min(props.getInfluenceRadius(), farPlane);
+
+    _lightRadii[i] = radius;
+    _lightData.push_back(glm::vec4(light.position, radius));
+    _lightData.push_back(glm::vec4(props.color * props.ambientMultiplier, props.attenuationConstant));
+    _lightData.push_back(glm::vec4(props.color, props.attenuationLinear));
+    _lightData.push_back(glm::vec4(props.color * props.specularMultiplier, props.attenuationQuadratic));
+
+    auto& range = _lightRanges[i];
+    const glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+    const float depth = -center.z;
+
+    range.visible = (depth + radius >= nearPlane) && (depth - radius <= farPlane);
+    if (!range.visible)
+      continue;
+
+    range.min[2] = depthSlice(std::max(depth - radius, nearPlane));
+    range.max[2] = depthSlice(std::min(depth + radius, farPlane));
+
+    if (depth - radius <= nearPlane) {
+      // Sphere crosses the near plane, covers the whole screen
+      range.min[0] = 0;
+      range.min[1] = 0;
+      range.max[0] = TilesX - 1;
+      range.max[1] = TilesY - 1;
+      continue;
+    }
+
+    // Screen bounds of the sphere's view space box
+    glm::vec2 ndcMin(std::numeric_limits<float>::max());
+    glm::vec2 ndcMax(-std::numeric_limits<float>::max());
+
+    for (int c = 0; c < 8; ++c) {
+      const glm::vec3 corner = center + glm::vec3((c & 1) ? radius : -radius, (c & 2) ? radius : -radius, (c & 4) ? radius : -radius);
+      const glm::vec4 clip = proj * glm::vec4(corner, 1.0f);
+      const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+
+      ndcMin = glm::min(ndcMin, ndc);
+      ndcMax = glm::max(ndcMax, ndc);
+    }
+
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) {
+      range.visible = false;
+      continue;
+    }
+
+    range.min[0] = tile(ndcMin.x, TilesX);
+    range.max[0] = tile(ndcMax.x, TilesX);
+    range.min[1] = tile(ndcMin.y, TilesY);
+    range.max[1] = tile(ndcMax.y, TilesY);
+  }
+}
+
+void LightClusters::assignSlices(Worker& worker, uint32_t sliceBegin, uint32_t sliceEnd) {
+  const uint32_t firstCluster = sliceBegin * TilesX * TilesY;
+  const uint32_t clusterCount = (sliceEnd - sliceBegin) * TilesX * TilesY;
+
+  auto forEachCluster = [sliceBegin, sliceEnd](const LightRange& range, auto&& callback) {
+    const uint32_t zBegin = std::max((uint32_t)range.min[2], sliceBegin);
+    const uint32_t zEnd = std::min((uint32_t)range.max[2] + 1, sliceEnd);
+
+    for (uint32_t z = zBegin; z < zEnd; ++z) {
+      for (uint32_t y = range.min[1]; y <= range.max[1]; ++y) {
+        for (uint32_t x = range.min[0]; x <= range.max[0]; ++x) {
+          callback((z * TilesY + y) * TilesX + x);
+        }
+      }
+    }
+  };
+
+  // Count, prefix sum, then fill
+  worker.cursors.assign(clusterCount, 0);
+  for (uint32_t i = 0; i < _lightCount; ++i) {
+    if (_lightRanges[i].visible) {
+      forEachCluster(_lightRanges[i], [&](uint32_t cluster) { worker.cursors[cluster - firstCluster]++; });
+    }
+  }
+
+  uint32_t offset = 0;
+  for (uint32_t c = 0; c < clusterCount; ++c) {
+    _clusters[firstCluster + c] = { offset, worker.cursors[c] };
+    worker.cursors[c] = offset;
+    offset += _clusters[firstCluster + c].count;
+  }
+
+  worker.indices.resize(offset);
+  for (uint32_t i = 0; i < _lightCount; ++i) {
+    if (_lightRanges[i].visible) {
+      forEachCluster(_lightRanges[i], [&](uint32_t cluster) { worker.indices[worker.cursors[cluster - firstCluster]++] = i; });
+    }
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/camera.h"
+#include "core/job_system.h"
+#include "buffers.h"
+#include "lights.h"
+
+// Clustered forward lighting. The view frustum is split into TilesX x TilesY screen tiles and
+// SlicesZ exponential depth slices, each cluster gets the list of point lights overlapping it.
+// Matches the CLUSTER_* defines in shaders/_lights.inc.
+class LightClusters {
+public:
+  enum {
+    TilesX = 16,
+    TilesY = 9,
+    SlicesZ = 24,
+    ClusterCount = TilesX * TilesY * SlicesZ,
+    MaxLights = 4096,
+    MinLightsPerWorker = 32,
+  };
+
+public:
+  LightClusters();
+
+  void init(JobSystem& jobSystem);
+  void build(const Light* lights, uint32_t lightCount, const Camera& camera);
+  void bind(uint32_t lightsSlot, uint32_t clustersSlot, uint32_t indicesSlot);
+
+  // x: depth slice scale, y: depth slice bias, zw: tiles per pixel
+  const glm::vec4& getParams() const { return _params; }
+  uint32_t getLightCount() const { return _lightCount; }
+  uint32_t getIndexCount() const { return _indices.size(); }
+  const std::vector<float>& getLightRadii() const { return _lightRadii; }
+
+private:
+  struct LightRange {
+    uint16_t min[3];
+    uint16_t max[3];
+    bool     visible;
+  };
+
+  struct ClusterEntry {
+    uint32_t offset;
+    uint32_t count;
+  };
+
+  struct Worker {
+    std::vector<uint32_t> cursors;
+    std::vector<uint32_t> indices;
+  };
+
+  void computeLightRanges(const Light* lights, const Camera& camera);
+  void assignSlices(Worker& worker, uint32_t sliceBegin, uint32_t sliceEnd);
+
+private:
+  JobSystem* _jobSystem;
+
+  TBORef _lightsBuffer;
+  TBORef _clustersBuffer;
+  TBORef _indicesBuffer;
+
+  std::vector<glm::vec4>    _lightData;
+  std::vector<float>        _lightRadii;
+  std::vector<LightRange>   _lightRanges;
+  std::vector<ClusterEntry> _clusters;
+  std::vector<uint32_t>     _indices;
+  std::vector<Worker>       _workers;
+
+  glm::vec4 _params;
+  uint32_t  _lightCount;
+};
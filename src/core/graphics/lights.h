@@ -7,6 +7,8 @@ struct Light {
   };
 
   struct Properties {
+    static constexpr float InfluenceCutoff = 1.0f / 256.0f;
+
     Properties() {
       color = ColorRGB(1.0f);
       ambientMultiplier = 0.1f;
@@ -22,6 +24,26 @@ struct Light {
     float    attenuationConstant;
     float    attenuationLinear;
     float    attenuationQuadratic;
+
+    // Distance where attenuation takes the brightest channel below the cutoff intensity
+    float getInfluenceRadius(float cutoffIntensity = InfluenceCutoff) const {
+      const float intensity = std::max(color.r, std::max(color.g, color.b))
+        * std::max(1.0f, std::max(ambientMultiplier, specularMultiplier));
+
+      // Solve intensity / (c + l*d + q*d^2) = cutoff for d
+      const float c = attenuationConstant - intensity / cutoffIntensity;
+      const float l = attenuationLinear;
+      const float q = attenuationQuadratic;
+
+      if (c >= 0.0f)
+        return 0.0f;
+      if (q > 0.0f)
+        return (-l + sqrtf(l * l - 4.0f * q * c)) / (2.0f * q);
+      if (l > 0.0f)
+        return -c / l;
+
+      return std::numeric_limits<float>::max();
+    }
   };
 
   Light(Type type = Type::Directional)
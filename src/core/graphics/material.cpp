@@ -2,31 +2,41 @@
 
 #include <glad/glad.h>
 
+static uint32_t gNextSortId = 0;
+
 Material::Material(ShaderRef shader)
-  : _shader(shader) {
+  : _shader(shader)
+  , _sortId(gNextSortId++) {
     _slots.fill(MaterialSlot());
 }
 
 /*static*/ MaterialRef Material::Create(ShaderRef shader) {
-  MaterialRef material(new Material(shader));
-  return material;
+  return ResourcePool<Material>::Get().create(shader);
 }
 
 /*static*/ MaterialRef Material::Clone(MaterialRef material) {
-  MaterialRef cloned(new Material(material->getShader()));
+  MaterialRef cloned = ResourcePool<Material>::Get().create(material->getShader());
   cloned->_slots = material->_slots;
   cloned->_params = material->_params;
 
   return cloned;
 }
 
+/*static*/ void Material::Destroy(MaterialRef material) {
+  ResourcePool<Material>::Get().destroy(material);
+}
+
 void Material::apply() {
+  apply(*_shader);
+}
+
+void Material::apply(Shader& shader) {
   uint activeSlots = 0;
   for (int i = 0; i < _slots.size(); ++i) {
     auto& slot = _slots[i];
     if (slot.texture) {
       glActiveTexture(GL_TEXTURE0 + i);
-      _shader->setUniformInt(slot.name.c_str(), i);
+      shader.setUniformInt(slot.name.c_str(), i);
 
       glBindTexture(slot.texture->target(), slot.texture->id());
 
@@ -34,21 +44,21 @@ void Material::apply() {
     }
   }
 
-  _shader->setUniformUInt("material.active_slots", activeSlots);
+  shader.setUniformUInt("material.active_slots", activeSlots);
 
   for (auto iter = _params.begin(); iter != _params.end(); ++iter) {
     switch (iter->second.type)
     {
     case MaterialParamType_Float:
-      _shader->setUniformFloat(iter->first.c_str(), iter->second.value._f);
+      shader.setUniformFloat(iter->first.c_str(), iter->second.value._f);
       break;
 
     case MaterialParamType_Int:
-      _shader->setUniformInt(iter->first.c_str(), iter->second.value._i);
+      shader.setUniformInt(iter->first.c_str(), iter->second.value._i);
       break;
 
     case MaterialParamType_Vec3:
-      _shader->setUniformVec3(iter->first.c_str(), iter->second.value._vec3);
+      shader.setUniformVec3(iter->first.c_str(), iter->second.value._vec3);
       break;
 
     default:
@@ -4,7 +4,7 @@
 #include "texture.h"
 
 class Material;
-typedef std::shared_ptr<Material> MaterialRef;
+typedef Handle<Material> MaterialRef;
 
 enum MaterialParamType {
   MaterialParamType_Float = 0,
@@ -42,23 +42,31 @@ private:
 
 public:
   void apply();
+  void apply(Shader& shader);
 
   ShaderRef& getShader() { return _shader; }
+  const ShaderRef& getShader() const { return _shader; }
+  uint32_t getSortId() const { return _sortId; }
 
   void setTextureSlot(MaterialSlotId id, const char* name, TextureRef texture);
   void setParamFloat(const char* name, float value);
   void setParamInt(const char* name, int value);
   void setParamVec3(const char* name, const glm::vec3& value);
 
+  // Shader and textures are referenced, not owned
   static MaterialRef Create(ShaderRef shader);
   static MaterialRef Clone(MaterialRef material);
+  static void Destroy(MaterialRef material);
 
 private:
+  friend class ResourcePool<Material>;
+
   Material(ShaderRef shader);
   Material(Material& material) = delete;
 
 private:
   ShaderRef _shader;
+  uint32_t  _sortId;
   MaterialSlots  _slots;
   MaterialParams _params;
 };
@@ -2,6 +2,17 @@
 
 #include <glad/glad.h>
 
+// Helpers
+struct PositionHash {
+    size_t operator()(const glm::vec3& p) const {
+        uint32_t bits[3];
+        memcpy(bits, glm::value_ptr(p), sizeof(bits));
+
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+// Mesh
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
     _vertices = vertices;
     _indices = indices;
@@ -9,40 +20,85 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>&
     setup();
 }
 
+Mesh::~Mesh() {
+    GeometryArena::release(_geometry);
+    GeometryArena::release(_positionGeometry);
+}
+
 /*static*/ MeshRef Mesh::Create(const MeshCreateParams& params) {
-    MeshRef mesh(new Mesh(params.vertices, params.indices));
+    MeshRef mesh = ResourcePool<Mesh>::Get().create(params.vertices, params.indices);
+
+    if (params.buildPositionStream) {
+        mesh->setupPositionStream();
+    }
 
     return mesh;
 }
 
+/*static*/ void Mesh::Destroy(MeshRef mesh) {
+    ResourcePool<Mesh>::Get().destroy(mesh);
+}
+
 void Mesh::setup() {
-    auto vbo = VBO::Create(
-        _vertices.data(),
-        sizeof(Vertex) * _vertices.size(),
-        BufferLayout({
-            { BufferItemType::Float3, "position" },
-            { BufferItemType::Float3, "normal" },
-            { BufferItemType::Float2, "texCoords" },
-            { BufferItemType::Float3, "tangent" }
-        })
+    for (auto& vertex : _vertices) {
+        _bounds.expand(vertex.position);
+    }
+
+    // Non indexed meshes get a trivial index list so every draw goes through the shared index buffer
+    if (_indices.empty()) {
+        _indices.resize(_vertices.size());
+        std::iota(_indices.begin(), _indices.end(), 0);
+    }
+
+    _geometry = GeometryArena::allocate(
+        VertexFormat::Standard,
+        _vertices.data(), _vertices.size(),
+        _indices.data(), _indices.size()
     );
+}
+
+void Mesh::setupPositionStream() {
+    // Vertices that only differ in normal, uv or tangent share the same position,
+    // depth-only passes can weld them and fetch 12 bytes per vertex instead of 44
+    std::unordered_map<glm::vec3, unsigned int, PositionHash> remap;
+    std::vector<glm::vec3>    positions;
+    std::vector<unsigned int> indices;
 
-    _vao = VAO::Create();
-    _vao->addVertexBuffer(vbo);
+    remap.reserve(_vertices.size());
+    positions.reserve(_vertices.size());
+    indices.reserve(_indices.size());
 
-    if(_indices.size() > 0) {
-         auto ibo = IBO::Create(_indices.data(), _indices.size());
-        _vao->setIndexBuffer(ibo);
+    for (size_t i = 0; i < _indices.size(); ++i) {
+        const glm::vec3 position = _vertices[_indices[i]].position + glm::vec3(0.0f); // -0.0 -> 0.0
+
+        auto result = remap.insert({ position, (unsigned int)positions.size() });
+        if (result.second) {
+            positions.push_back(position);
+        }
+
+        indices.push_back(result.first->second);
     }
+
+    if (indices.empty())
+        return;
+
+    _positionGeometry = GeometryArena::allocate(
+        VertexFormat::Position,
+        positions.data(), positions.size(),
+        indices.data(), indices.size()
+    );
 }
 
 void Mesh::draw() {
-    _vao->bind();
+    if (!_geometry.valid())
+        return;
 
-    if (_vao->indexCount() > 0) {
-        glDrawElements(GL_TRIANGLES, _vao->indexCount(), GL_UNSIGNED_INT, 0);
-    }
-    else {
-        glDrawArrays(GL_TRIANGLES, 0, _vertices.size());
-    }
+    _geometry.buffer->bind();
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES,
+        _geometry.indexCount,
+        GL_UNSIGNED_INT,
+        INT_TO_VOIDPTR(sizeof(uint32_t) * _geometry.firstIndex),
+        _geometry.baseVertex
+    );
 }
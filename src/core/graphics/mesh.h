@@ -1,6 +1,8 @@
 #pragma once
 
-#include "buffers.h"
+#include "geometry_arena.h"
+#include "core/bounds.h"
+#include "core/resource_pool.h"
 
 struct Vertex {
   glm::vec3 position;
@@ -10,30 +12,49 @@ struct Vertex {
 };
 
 class Mesh;
-typedef std::shared_ptr<Mesh> MeshRef;
+typedef Handle<Mesh> MeshRef;
 
 struct MeshCreateParams {
+  MeshCreateParams()
+    : buildPositionStream(true) {
+  }
+
   std::vector<Vertex> vertices;
   std::vector<unsigned int> indices;
+  bool buildPositionStream; // Welded position-only stream for depth-only passes
 };
 
 class Mesh {
 public:
+  ~Mesh();
+
   void draw();
 
+  bool hasPositionStream() const { return _positionGeometry.valid(); }
+  const AABB& getBounds() const { return _bounds; }
+
+  const GeometryRange& getGeometry() const { return _geometry; }
+  const GeometryRange& getPositionGeometry() const { return _positionGeometry; }
+
   static MeshRef Create(const MeshCreateParams& params);
+  static void Destroy(MeshRef mesh);
 
 private:
+  friend class ResourcePool<Mesh>;
+
   Mesh() = delete;
   Mesh(const Mesh& mesh) = delete;
 
   Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
 
   void setup();
+  void setupPositionStream();
 
 private:
   std::vector<Vertex>       _vertices;
   std::vector<unsigned int> _indices;
 
-  VAORef _vao;
+  AABB          _bounds;
+  GeometryRange _geometry;
+  GeometryRange _positionGeometry;
 };
@@ -0,0 +1,165 @@
+#include "occlusion_culler.h"
+
+#include <glad/glad.h>
+
+#define DEPTH_EPSILON 1e-5f
+#define NEAR_CLIP_EPSILON 1e-4f
+
+OcclusionCuller::OcclusionCuller()
+  : _viewProjection(1.0f)
+  , _occluderCount(0) {
+}
+
+void OcclusionCuller::init() {
+  ShaderCreateParams params;
+  params.name = "depth_only";
+  params.vertexShaderPath = "shaders/depth_only.vert";
+  params.fragmentShaderPath = "shaders/shadowmap_depth.frag";
+  _shader = Shader::Create(params);
+}
+
+void OcclusionCuller::shutdown() {
+  Shader::Destroy(_shader);
+  _shader = nullptr;
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection, float aspectRatio) {
+  const uint32_t height = std::max(1, (int)(Width / aspectRatio));
+
+  if (!_fbo || _fbo->height() != height) {
+    FBOSpec spec;
+    spec.width = Width;
+    spec.height = height;
+    spec.type = FBOType::Depth;
+    _fbo = FBO::Create(spec);
+  }
+
+  _viewProjection = viewProjection;
+  _occluderCount = 0;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, _fbo->id());
+  glViewport(0, 0, _fbo->width(), _fbo->height());
+  glClear(GL_DEPTH_BUFFER_BIT);
+
+  _shader->use();
+}
+
+void OcclusionCuller::drawOccluder(const GeometryRange& geometry, const glm::mat4& modelTM) {
+  if (!geometry.valid())
+    return;
+
+  _shader->setUniformMatrix4("mtx_mvp", _viewProjection * modelTM);
+
+  geometry.buffer->bind();
+  glDrawElementsBaseVertex(
+    GL_TRIANGLES,
+    geometry.indexCount,
+    GL_UNSIGNED_INT,
+    INT_TO_VOIDPTR(sizeof(uint32_t) * geometry.firstIndex),
+    geometry.baseVertex
+  );
+
+  _occluderCount++;
+}
+
+void OcclusionCuller::end() {
+  if (_levels.empty() || _levels[0].width != _fbo->width() || _levels[0].height != _fbo->height()) {
+    _levels.clear();
+
+    uint32_t width = _fbo->width();
+    uint32_t height = _fbo->height();
+    while (true) {
+      _levels.push_back({ width, height, std::vector<float>(width * height) });
+      if (width == 1 && height == 1)
+        break;
+
+      width = std::max(1u, (width + 1) / 2);
+      height = std::max(1u, (height + 1) / 2);
+    }
+  }
+
+  // Synchronous readback, the buffer is small enough to keep the stall short
+  glReadPixels(0, 0, _fbo->width(), _fbo->height(), GL_DEPTH_COMPONENT, GL_FLOAT, _levels[0].depth.data());
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  buildPyramid();
+}
+
+void OcclusionCuller::buildPyramid() {
+  for (size_t i = 1; i < _levels.size(); ++i) {
+    const Level& src = _levels[i - 1];
+    Level& dst = _levels[i];
+
+    for (uint32_t y = 0; y < dst.height; ++y) {
+      const uint32_t y0 = std::min(y * 2, src.height - 1);
+      const uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+
+      for (uint32_t x = 0; x < dst.width; ++x) {
+        const uint32_t x0 = std::min(x * 2, src.width - 1);
+        const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+
+        dst.depth[y * dst.width + x] = std::max(
+          std::max(src.depth[y0 * src.width + x0], src.depth[y0 * src.width + x1]),
+          std::max(src.depth[y1 * src.width + x0], src.depth[y1 * src.width + x1])
+        );
+      }
+    }
+  }
+}
+
+bool OcclusionCuller::isVisible(const AABB& bounds) const {
+  if (_levels.empty() || _occluderCount == 0)
+    return true;
+
+  glm::vec3 ndcMin(std::numeric_limits<float>::max());
+  glm::vec3 ndcMax(-std::numeric_limits<float>::max());
+
+  for (int i = 0; i < 8; ++i) {
+    const glm::vec3 corner(
+      (i & 1) ? bounds.max.x : bounds.min.x,
+      (i & 2) ? bounds.max.y : bounds.min.y,
+      (i & 4) ? bounds.max.z : bounds.min.z
+    );
+
+    const glm::vec4 clip = _viewProjection * glm::vec4(corner, 1.0f);
+    if (clip.w <= NEAR_CLIP_EPSILON)
+      return true; // Crosses the near plane
+
+    const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    ndcMin = glm::min(ndcMin, ndc);
+    ndcMax = glm::max(ndcMax, ndc);
+  }
+
+  const float nearestDepth = ndcMin.z * 0.5f + 0.5f;
+  if (nearestDepth <= 0.0f)
+    return true;
+
+  // Screen rectangle in texels of the base level
+  const Level& base = _levels[0];
+  auto toTexel = [](float ndc, uint32_t size) {
+    const int texel = (int)floorf((ndc * 0.5f + 0.5f) * size);
+    return (uint32_t)std::clamp(texel, 0, (int)size - 1);
+  };
+
+  const uint32_t x0 = toTexel(ndcMin.x, base.width);
+  const uint32_t x1 = toTexel(ndcMax.x, base.width);
+  const uint32_t y0 = toTexel(ndcMin.y, base.height);
+  const uint32_t y1 = toTexel(ndcMax.y, base.height);
+
+  // Coarsest level where the rectangle spans at most 2x2 texels
+  uint32_t level = 0;
+  while (level + 1 < _levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+    level++;
+  }
+
+  const Level& hiz = _levels[level];
+  float farthestDepth = 0.0f;
+
+  for (uint32_t y = (y0 >> level); y <= std::min(y1 >> level, hiz.height - 1); ++y) {
+    for (uint32_t x = (x0 >> level); x <= std::min(x1 >> level, hiz.width - 1); ++x) {
+      farthestDepth = std::max(farthestDepth, hiz.depth[y * hiz.width + x]);
+    }
+  }
+
+  return nearestDepth <= farthestDepth + DEPTH_EPSILON;
+}
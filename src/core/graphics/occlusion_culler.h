@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core/bounds.h"
+#include "geometry_arena.h"
+#include "shader.h"
+
+// Hierarchical-Z occlusion test. The biggest occluders are rasterized into a small depth buffer,
+// read back and reduced on the CPU into a max-depth pyramid that world bounds are tested against.
+class OcclusionCuller {
+public:
+  enum {
+    Width = 256,
+    MaxOccluders = 16,
+  };
+
+public:
+  OcclusionCuller();
+
+  void init();
+  void shutdown();
+
+  void begin(const glm::mat4& viewProjection, float aspectRatio);
+  void drawOccluder(const GeometryRange& geometry, const glm::mat4& modelTM);
+  void end();
+
+  // Conservative, true unless the bounds are entirely behind the occluders
+  bool isVisible(const AABB& bounds) const;
+
+  uint32_t getOccluderCount() const { return _occluderCount; }
+
+private:
+  struct Level {
+    uint32_t width;
+    uint32_t height;
+    std::vector<float> depth;
+  };
+
+  void buildPyramid();
+
+private:
+  FBORef    _fbo;
+  ShaderRef _shader;
+  glm::mat4 _viewProjection;
+
+  std::vector<Level> _levels;
+  uint32_t _occluderCount;
+};
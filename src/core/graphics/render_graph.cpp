@@ -0,0 +1,258 @@
+#include "render_graph.h"
+
+#include <SDL.h>
+#include <glad/glad.h>
+
+static bool sameSpec(const FBOSpec& a, const FBOSpec& b) {
+  return a.width == b.width && a.height == b.height && a.type == b.type;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ResourceId id) {
+  _graph._passes[_pass].reads.push_back(id);
+  return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ResourceId id) {
+  _graph._passes[_pass].writes.push_back(id);
+  return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::setEnabled(bool enabled) {
+  _graph._passes[_pass].enabled = enabled;
+  return *this;
+}
+
+RenderGraph::RenderGraph()
+  : _backbufferWidth(0)
+  , _backbufferHeight(0)
+  , _frame(0) {
+}
+
+void RenderGraph::beginFrame(uint32_t backbufferWidth, uint32_t backbufferHeight) {
+  _backbufferWidth = backbufferWidth;
+  _backbufferHeight = backbufferHeight;
+  _frame++;
+
+  _passes.clear();
+  _resources.clear();
+  _resources.push_back({ "Backbuffer", { backbufferWidth, backbufferHeight, FBOType::Default }, nullptr, 0, 0 });
+}
+
+RenderGraph::ResourceId RenderGraph::createTarget(const char* name, const FBOSpec& spec) {
+  _resources.push_back({ name, spec, nullptr, 0, 0 });
+
+  return (ResourceId)(_resources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(const char* name, ExecuteFn execute) {
+  _passes.push_back({ name, execute, {}, {}, true, false });
+
+  return PassBuilder(*this, (uint32_t)(_passes.size() - 1));
+}
+
+void RenderGraph::execute() {
+  cullPasses();
+  sortPasses();
+
+  // Transient lifetimes in execution order
+  for (auto& resource : _resources) {
+    resource.firstUse = InvalidResource;
+    resource.lastUse = 0;
+  }
+  for (uint32_t i = 0; i < _order.size(); ++i) {
+    const auto& pass = _passes[_order[i]];
+    for (auto list : { &pass.reads, &pass.writes }) {
+      for (ResourceId id : *list) {
+        _resources[id].firstUse = std::min(_resources[id].firstUse, i);
+        _resources[id].lastUse = std::max(_resources[id].lastUse, i);
+      }
+    }
+  }
+
+  const double ticksToMs = 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+  _timings.clear();
+  for (uint32_t i = 0; i < _order.size(); ++i) {
+    auto& pass = _passes[_order[i]];
+
+    for (ResourceId id = Backbuffer + 1; id < _resources.size(); ++id) {
+      if (_resources[id].firstUse == i) {
+        _resources[id].fbo = acquireTarget(_resources[id].spec);
+      }
+    }
+
+    // Passes render into their first written target
+    const ResourceId target = pass.writes.empty() ? Backbuffer : pass.writes[0];
+    if (target == Backbuffer) {
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      glViewport(0, 0, _backbufferWidth, _backbufferHeight);
+    }
+    else {
+      const auto& fbo = _resources[target].fbo;
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo->id());
+      glViewport(0, 0, fbo->width(), fbo->height());
+    }
+
+    auto& timer = _gpuTimers[pass.name];
+    if (!timer) {
+      timer = GPUTimer::Create();
+    }
+
+    const uint64_t start = SDL_GetPerformanceCounter();
+    timer->begin();
+    pass.execute(*this);
+    timer->end();
+    const uint64_t end = SDL_GetPerformanceCounter();
+
+    _timings.push_back({ pass.name, (float)((end - start) * ticksToMs), timer->getElapsedMs(), false });
+
+    for (ResourceId id = Backbuffer + 1; id < _resources.size(); ++id) {
+      if (_resources[id].lastUse == i && _resources[id].fbo) {
+        releaseTarget(_resources[id].fbo);
+      }
+    }
+  }
+
+  for (const auto& pass : _passes) {
+    if (!pass.live) {
+      _timings.push_back({ pass.name, 0.0f, 0.0f, true });
+    }
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, _backbufferWidth, _backbufferHeight);
+
+  trimPool();
+}
+
+float RenderGraph::getGpuMs(const char* passName) const {
+  for (const auto& timing : _timings) {
+    if (timing.name == passName)
+      return timing.gpuMs;
+  }
+
+  return 0.0f;
+}
+
+void RenderGraph::cullPasses() {
+  // Enabled passes writing the backbuffer are the roots, producers of anything a live pass reads stay too
+  std::vector<uint32_t> pending;
+  for (uint32_t i = 0; i < _passes.size(); ++i) {
+    auto& pass = _passes[i];
+    pass.live = pass.enabled && std::find(pass.writes.begin(), pass.writes.end(), (ResourceId)Backbuffer) != pass.writes.end();
+    if (pass.live) {
+      pending.push_back(i);
+    }
+  }
+
+  while (!pending.empty()) {
+    const uint32_t index = pending.back();
+    pending.pop_back();
+
+    for (ResourceId id : _passes[index].reads) {
+      for (uint32_t i = 0; i < _passes.size(); ++i) {
+        auto& producer = _passes[i];
+        if (producer.live || !producer.enabled)
+          continue;
+
+        if (std::find(producer.writes.begin(), producer.writes.end(), id) != producer.writes.end()) {
+          producer.live = true;
+          pending.push_back(i);
+        }
+      }
+    }
+  }
+}
+
+void RenderGraph::sortPasses() {
+  // Readers run after every writer of the resource, writers of the same resource keep their declaration
+  // order. Among ready passes the earliest declared goes first.
+  const uint32_t count = (uint32_t)_passes.size();
+  std::vector<std::vector<uint32_t>> dependencies(count);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!_passes[i].live)
+      continue;
+
+    for (uint32_t j = 0; j < count; ++j) {
+      if (i == j || !_passes[j].live)
+        continue;
+
+      const auto& writes = _passes[j].writes;
+      bool dependency = false;
+      for (ResourceId id : _passes[i].reads) {
+        dependency |= std::find(writes.begin(), writes.end(), id) != writes.end();
+      }
+      if (j < i) {
+        for (ResourceId id : _passes[i].writes) {
+          dependency |= std::find(writes.begin(), writes.end(), id) != writes.end();
+        }
+      }
+
+      if (dependency) {
+        dependencies[i].push_back(j);
+      }
+    }
+  }
+
+  _order.clear();
+  std::vector<bool> scheduled(count, false);
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (!_passes[i].live || scheduled[i])
+        continue;
+
+      const bool ready = std::all_of(dependencies[i].begin(), dependencies[i].end(), [&scheduled](uint32_t j) { return scheduled[j]; });
+      if (ready) {
+        _order.push_back(i);
+        scheduled[i] = true;
+        progress = true;
+        break;
+      }
+    }
+  }
+
+  // A cycle leaves passes unscheduled, run them in declaration order rather than dropping them
+  for (uint32_t i = 0; i < count; ++i) {
+    if (_passes[i].live && !scheduled[i]) {
+      LOG_ERROR("[RenderGraph] Pass {} is part of a dependency cycle", _passes[i].name);
+      _order.push_back(i);
+    }
+  }
+}
+
+FBORef RenderGraph::acquireTarget(const FBOSpec& spec) {
+  for (auto& target : _pool) {
+    if (!target.inUse && sameSpec(target.fbo->spec(), spec)) {
+      target.inUse = true;
+      target.lastFrame = _frame;
+      return target.fbo;
+    }
+  }
+
+  _pool.push_back({ FBO::Create(spec), _frame, true });
+
+  return _pool.back().fbo;
+}
+
+void RenderGraph::releaseTarget(const FBORef& fbo) {
+  for (auto& target : _pool) {
+    if (target.fbo == fbo) {
+      target.inUse = false;
+    }
+  }
+}
+
+void RenderGraph::trimPool() {
+  _pool.erase(
+    std::remove_if(_pool.begin(), _pool.end(), [this](const PooledTarget& target) { return _frame - target.lastFrame > RetainFrames; }),
+    _pool.end()
+  );
+
+  // Resources only hold targets for the frame
+  for (auto& resource : _resources) {
+    resource.fbo.reset();
+  }
+}
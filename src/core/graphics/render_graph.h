@@ -0,0 +1,101 @@
+#pragma once
+
+#include "buffers.h"
+#include "gpu_timer.h"
+
+// Per-frame graph of render passes. Passes declare the targets they read and write, the graph culls
+// the passes nothing consumes, orders the rest by their dependencies and hands out transient targets
+// from a pool, so targets with the same spec and disjoint lifetimes share one FBO.
+class RenderGraph {
+public:
+  typedef uint32_t ResourceId;
+  typedef std::function<void(RenderGraph&)> ExecuteFn;
+
+  enum : ResourceId {
+    Backbuffer = 0,
+    InvalidResource = ~0u,
+  };
+
+  enum {
+    RetainFrames = 8, // Pooled targets unused for longer are released
+  };
+
+  struct PassTiming {
+    std::string name;
+    float cpuMs;
+    float gpuMs;
+    bool  culled;
+  };
+
+  class PassBuilder {
+  public:
+    PassBuilder& read(ResourceId id);
+    PassBuilder& write(ResourceId id);
+    PassBuilder& setEnabled(bool enabled);
+
+  private:
+    friend class RenderGraph;
+    PassBuilder(RenderGraph& graph, uint32_t pass) : _graph(graph), _pass(pass) {}
+
+    RenderGraph& _graph;
+    uint32_t     _pass;
+  };
+
+public:
+  RenderGraph();
+
+  void beginFrame(uint32_t backbufferWidth, uint32_t backbufferHeight);
+  ResourceId createTarget(const char* name, const FBOSpec& spec);
+  PassBuilder addPass(const char* name, ExecuteFn execute);
+  void execute();
+
+  // Only valid while a pass reading or writing the target executes
+  const FBORef& getTarget(ResourceId id) const { return _resources[id].fbo; }
+
+  const std::vector<PassTiming>& getTimings() const { return _timings; }
+  float getGpuMs(const char* passName) const;
+  uint32_t getPooledTargetCount() const { return (uint32_t)_pool.size(); }
+
+private:
+  struct Resource {
+    std::string name;
+    FBOSpec     spec;
+    FBORef      fbo;
+    uint32_t    firstUse;
+    uint32_t    lastUse;
+  };
+
+  struct Pass {
+    std::string name;
+    ExecuteFn   execute;
+    std::vector<ResourceId> reads;
+    std::vector<ResourceId> writes;
+    bool        enabled;
+    bool        live;
+  };
+
+  struct PooledTarget {
+    FBORef   fbo;
+    uint64_t lastFrame;
+    bool     inUse;
+  };
+
+  void cullPasses();
+  void sortPasses();
+  FBORef acquireTarget(const FBOSpec& spec);
+  void releaseTarget(const FBORef& fbo);
+  void trimPool();
+
+private:
+  std::vector<Resource> _resources;
+  std::vector<Pass>     _passes;
+  std::vector<uint32_t> _order;
+  std::vector<PooledTarget> _pool;
+
+  std::map<std::string, GPUTimerRef> _gpuTimers;
+  std::vector<PassTiming> _timings;
+
+  uint32_t _backbufferWidth;
+  uint32_t _backbufferHeight;
+  uint64_t _frame;
+};
@@ -27,6 +27,28 @@ static void checkLinkErrors(GLuint shader, const char* name) {
   }
 }
 
+static std::string expandIncludes(const char* source) {
+  static const char* kIncludes[][2] = {
+    { "//#common.inc", "shaders/_common.inc" },
+    { "//#draw.inc",   "shaders/_draw.inc" },
+    { "//#lights.inc", "shaders/_lights.inc" },
+  };
+
+  std::string result(source);
+
+  for (auto& include : kIncludes) {
+    if (result.find(include[0]) == std::string::npos)
+      continue;
+
+    std::vector<char> incBuffer;
+    if (FileUtils::readTextFile(include[1], incBuffer)) {
+      result = std::regex_replace(result, std::regex(include[0]), incBuffer.data());
+    }
+  }
+
+  return result;
+}
+
 // Shader
 
 Shader::Shader(const char* name)
@@ -63,6 +85,10 @@ void Shader::setUniformVec3(const char* name, const glm::vec3& value){
   glUniform3fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
 
+void Shader::setUniformVec4Array(const char* name, const glm::vec4* values, uint32_t count) {
+  glUniform4fv(getUniformLocation(name), count, glm::value_ptr(values[0]));
+}
+
 void Shader::setUniformMatrix4(const char* name, const glm::mat4x4& value) {
   glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 }
@@ -99,6 +125,21 @@ void Shader::buildFromSources(const char* vsSources, const char* fsSources) {
   glDeleteShader(fragment);
 }
 
+void Shader::buildFromComputeSource(const char* csSources) {
+  unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+  glShaderSource(compute, 1, &csSources, NULL);
+  glCompileShader(compute);
+  checkCompileErrors(compute, "Compute");
+
+  _id = glCreateProgram();
+  glAttachShader(_id, compute);
+
+  glLinkProgram(_id);
+  checkLinkErrors(_id, _name.c_str());
+
+  glDeleteShader(compute);
+}
+
 int Shader::getUniformLocation(const char* name) {
   auto iter = _uniformsCache.find(name);
 
@@ -124,20 +165,27 @@ int Shader::getUniformBlockIndex(const char* name) {
 }
 
 /*static*/ ShaderRef Shader::Create(const ShaderCreateParams& params) {
-  ShaderRef shader(new Shader(params.name));
-
-  std::vector<char> incBuffer;
-  FileUtils::readTextFile("shaders/_common.inc", incBuffer);
+  ShaderRef shader = ResourcePool<Shader>::Get().create(params.name);
+
+  if (params.computeShaderPath != nullptr) {
+    std::vector<char> csBuffer;
+    if (FileUtils::readTextFile(params.computeShaderPath, csBuffer)) {
+      shader->buildFromComputeSource(expandIncludes(csBuffer.data()).c_str());
+    }
+    else {
+      LOG_ERROR("[Shader] Loading error '{}'", params.name);
+    }
+
+    return shader;
+  }
 
   std::vector<char> vsBuffer, fsBuffer;
   if (FileUtils::readTextFile(params.vertexShaderPath, vsBuffer)
     && FileUtils::readTextFile(params.fragmentShaderPath, fsBuffer)) {
 
-    auto regex = std::regex("//#common.inc");
-
     shader->buildFromSources(
-      std::regex_replace(vsBuffer.data(), regex, incBuffer.data()).c_str(),
-      std::regex_replace(fsBuffer.data(), regex, incBuffer.data()).c_str()
+      expandIncludes(vsBuffer.data()).c_str(),
+      expandIncludes(fsBuffer.data()).c_str()
     );
   }
   else {
@@ -146,3 +194,7 @@ int Shader::getUniformBlockIndex(const char* name) {
 
   return shader;
 }
+
+/*static*/ void Shader::Destroy(ShaderRef shader) {
+  ResourcePool<Shader>::Get().destroy(shader);
+}
@@ -1,19 +1,23 @@
 #pragma once
 
+#include "core/resource_pool.h"
+
 class Shader;
-typedef std::shared_ptr<Shader> ShaderRef;
+typedef Handle<Shader> ShaderRef;
 
 struct ShaderCreateParams {
   ShaderCreateParams()
     : name(nullptr)
     , vertexShaderPath(nullptr)
-    , fragmentShaderPath(nullptr) {
+    , fragmentShaderPath(nullptr)
+    , computeShaderPath(nullptr) {
 
     }
 
   const char* name;
   const char* vertexShaderPath;
   const char* fragmentShaderPath;
+  const char* computeShaderPath; // When set, vertex and fragment paths are ignored (requires GL 4.3)
 };
 
 class Shader {
@@ -21,6 +25,11 @@ public:
   ~Shader();
 
   const std::string& getName() const { return _name; }
+  uint32_t id() const { return _id; }
+
+  // Same vertex stage writing the G-buffer instead of shading, used by the deferred path
+  void setGBufferVariant(ShaderRef variant) { _gbufferVariant = variant; }
+  const ShaderRef& getGBufferVariant() const { return _gbufferVariant; }
 
   void use();
   void setUniformFloat(const char* name, float value);
@@ -28,18 +37,23 @@ public:
   void setUniformUInt(const char* name, uint value);
   void setUniformVec2(const char* name, const glm::vec2& value);
   void setUniformVec3(const char* name, const glm::vec3& value);
+  void setUniformVec4Array(const char* name, const glm::vec4* values, uint32_t count);
   void setUniformMatrix4(const char* name, const glm::mat4x4& value);
   void setUniformBlockBind(const char* name, int bindId);
 
   static ShaderRef Create(const ShaderCreateParams& params);
+  static void Destroy(ShaderRef shader);
 
 private:
+  friend class ResourcePool<Shader>;
+
   Shader() = delete;
   Shader(const Shader& shader) = delete;
 
   Shader(const char* name);
 
   void buildFromSources(const char* vsSources, const char* fsSources);
+  void buildFromComputeSource(const char* csSources);
   int getUniformLocation(const char* name);
   int getUniformBlockIndex(const char* name);
 
@@ -49,6 +63,7 @@ private:
 
   std::string _name;
   unsigned int _id;
+  ShaderRef _gbufferVariant;
 
   UniformLocations _uniformsCache;
   UniformBlockIndeces _blockIndices;
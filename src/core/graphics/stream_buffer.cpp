@@ -0,0 +1,104 @@
+#include "stream_buffer.h"
+
+#include <glad/glad.h>
+
+StreamBuffer::StreamBuffer(uint32_t segmentSize, const BufferLayout& layout)
+  : _persistent(nullptr)
+  , _mapped(false)
+  , _segmentSize(segmentSize)
+  , _segment(0)
+  , _head(0)
+  , _stalls(0) {
+
+  _fences.fill(nullptr);
+
+  const uint32_t size = segmentSize * SegmentCount;
+
+  if (GLAD_GL_VERSION_4_4) {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    _buffer = VBO::CreateStorage(size, layout, flags);
+    _persistent = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+  }
+
+  if (_persistent == nullptr) {
+    _buffer = VBO::Create(size, layout);
+  }
+
+  LOG_INFO("[StreamBuffer] {} KB, {}", size / 1024, _persistent ? "persistently mapped" : "mapped per write");
+}
+
+StreamBuffer::~StreamBuffer() {
+  for (auto fence : _fences) {
+    if (fence != nullptr) {
+      glDeleteSync((GLsync)fence);
+    }
+  }
+
+  if (_persistent != nullptr || _mapped) {
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer->id());
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+  }
+}
+
+/*static*/ StreamBufferRef StreamBuffer::Create(uint32_t segmentSize, const BufferLayout& layout) {
+  StreamBufferRef buffer(new StreamBuffer(segmentSize, layout));
+
+  return buffer;
+}
+
+void* StreamBuffer::map(uint32_t size, uint32_t& offset) {
+  if (size > _segmentSize)
+    return nullptr;
+
+  // Draws reading the current segment are all issued by now, fence it and move to the next one
+  if (_head + size > _segmentSize) {
+    if (_fences[_segment] != nullptr) {
+      glDeleteSync((GLsync)_fences[_segment]);
+    }
+    _fences[_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    _segment = (_segment + 1) % SegmentCount;
+    _head = 0;
+    waitSegment(_segment);
+  }
+
+  offset = _segment * _segmentSize + _head;
+  _head = (_head + size + Alignment - 1) & ~(Alignment - 1);
+
+  if (_persistent != nullptr)
+    return _persistent + offset;
+
+  // Fences already keep the GPU off this range
+  glBindBuffer(GL_ARRAY_BUFFER, _buffer->id());
+  void* data = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+  _mapped = data != nullptr;
+
+  return data;
+}
+
+void StreamBuffer::commit() {
+  // Coherent persistent writes need nothing else
+  if (!_mapped)
+    return;
+
+  glBindBuffer(GL_ARRAY_BUFFER, _buffer->id());
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  _mapped = false;
+}
+
+void StreamBuffer::waitSegment(uint32_t segment) {
+  GLsync fence = (GLsync)_fences[segment];
+  if (fence == nullptr)
+    return;
+
+  GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  if (result == GL_TIMEOUT_EXPIRED) {
+    _stalls++;
+    do {
+      result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    } while (result == GL_TIMEOUT_EXPIRED);
+  }
+
+  glDeleteSync(fence);
+  _fences[segment] = nullptr;
+}
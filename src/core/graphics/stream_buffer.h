@@ -0,0 +1,51 @@
+#pragma once
+
+#include "buffers.h"
+
+class StreamBuffer;
+typedef std::shared_ptr<StreamBuffer> StreamBufferRef;
+
+// Ring of vertex memory for geometry rebuilt every frame. Writes go straight into GPU-visible memory:
+// persistently mapped when the context has buffer storage (GL 4.4), mapped unsynchronized per write
+// otherwise. The ring is split in segments and each one is fenced when writes move past it, so a
+// segment is only written again once the GPU has read it, without the driver stalling or renaming.
+class StreamBuffer {
+public:
+  enum : uint32_t {
+    SegmentCount = 3,
+    Alignment = 64,
+  };
+
+public:
+  ~StreamBuffer();
+
+  static StreamBufferRef Create(uint32_t segmentSize, const BufferLayout& layout);
+
+  // Space for size bytes at offset in the buffer, writable until commit(). nullptr when size is larger
+  // than a segment or the range could not be mapped.
+  void* map(uint32_t size, uint32_t& offset);
+  void commit();
+
+  const VBORef& getBuffer() const { return _buffer; }
+  uint32_t getSegmentSize() const { return _segmentSize; }
+  bool isPersistent() const { return _persistent != nullptr; }
+  // Times a write had to wait for the GPU
+  uint32_t getStallCount() const { return _stalls; }
+
+private:
+  StreamBuffer() = delete;
+  StreamBuffer(const StreamBuffer&) = delete;
+  StreamBuffer(uint32_t segmentSize, const BufferLayout& layout);
+
+  void waitSegment(uint32_t segment);
+
+private:
+  VBORef   _buffer;
+  uint8_t* _persistent;
+  bool     _mapped;
+  uint32_t _segmentSize;
+  uint32_t _segment;
+  uint32_t _head; // In the current segment
+  std::array<void*, SegmentCount> _fences; // GLsync
+  uint32_t _stalls;
+};
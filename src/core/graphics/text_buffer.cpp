@@ -2,34 +2,43 @@
 
 #include <glad/glad.h>
 
-static constexpr uint32_t kVerticesPerChar = 6;
-
 TextBuffer::TextBuffer(uint32_t capacity) {
-    _maxSize =  sizeof(TextVertex) * kVerticesPerChar * capacity;
-    _maxVertices = kVerticesPerChar * capacity;
+  _maxGlyphs = capacity;
 
-    setup();
+  setup();
 }
 
 TextBufferRef TextBuffer::Create(uint32_t capacity) {
   return TextBufferRef(new TextBuffer(capacity));
 }
 
-uint32_t TextBuffer::draw(const std::vector<TextVertex>& vertices) {
+uint32_t TextBuffer::draw(const GlyphInstance* glyphs, uint32_t glyphCount) {
   uint32_t drawcalls = 0;
 
   _vao->bind();
 
-  const int vertexCount = (int)vertices.size();
-  int currentVertex = 0;
+  uint32_t currentGlyph = 0;
+
+  while (currentGlyph < glyphCount) {
+    const uint32_t count = std::min(glyphCount - currentGlyph, _maxGlyphs);
+
+    const uint32_t size = sizeof(GlyphInstance) * count;
 
-  while(currentVertex < vertexCount) {
-    int count = std::min(vertexCount-currentVertex, (int)_maxVertices);
+    uint32_t offset = 0;
+    void* dest = _instances->map(size, offset);
+    if (dest == nullptr) {
+      LOG_WARN("[TextBuffer] Could not map {} glyphs, skipping them", count);
+      currentGlyph += count;
+      continue;
+    }
 
-    _vao->getVertexBuffer(0)->uploadData((const void*)&vertices[currentVertex], sizeof(TextVertex)*count);
-    glDrawArrays(GL_TRIANGLES, 0, count);
+    memcpy(dest, &glyphs[currentGlyph], size);
+    _instances->commit();
 
-    currentVertex += count;
+    _vao->setVertexBufferOffset(1, offset);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+
+    currentGlyph += count;
     drawcalls++;
   }
 
@@ -37,15 +46,30 @@ uint32_t TextBuffer::draw(const std::vector<TextVertex>& vertices) {
 }
 
 void TextBuffer::setup() {
-  auto vbo = VBO::Create(
-    _maxSize,
+  // Corners of the unit quad as a triangle strip, (0, 0) is bottom-left
+  const float corners[] = {
+    0.0f, 0.0f,
+    1.0f, 0.0f,
+    0.0f, 1.0f,
+    1.0f, 1.0f
+  };
+
+  auto quad = VBO::Create(corners, sizeof(corners), BufferLayout({
+    { BufferItemType::Float2, "corner" }
+  }));
+
+  _instances = StreamBuffer::Create(
+    sizeof(GlyphInstance) * _maxGlyphs,
     BufferLayout({
       { BufferItemType::Float3, "position" },
-      { BufferItemType::Float2, "texCoords"},
-      { BufferItemType::Float3, "color" }
+      { BufferItemType::Float2, "size" },
+      { BufferItemType::UShort4Norm, "atlasRect" },
+      { BufferItemType::UByte4Norm, "color" }
     })
   );
+  _instances->getBuffer()->setFlag(VBO::Flag_Instance);
 
   _vao = VAO::Create();
-  _vao->addVertexBuffer(vbo);
+  _vao->addVertexBuffer(quad);
+  _vao->addVertexBuffer(_instances->getBuffer());
 }
@@ -1,21 +1,30 @@
 #pragma once
 
-#include "buffers.h"
+#include "stream_buffer.h"
 
-struct TextVertex {
-  glm::vec3 position;
-  glm::vec2 texCoords;
-  glm::vec3 color;
+// One per character, the vertex shader expands it from a static quad
+struct GlyphInstance {
+  glm::vec3 position;  // Bottom-left corner in screen pixels, z is depth
+  glm::vec2 size;      // Pixels
+  uint16_t  atlasRect[4]; // u0, v0 (top), u1, v1 (bottom), normalized
+  uint8_t   color[4];
+
+  static uint16_t PackUnorm16(float value) { return (uint16_t)(glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f); }
+  static uint8_t PackUnorm8(float value) { return (uint8_t)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); }
 };
+static_assert(sizeof(GlyphInstance) == 32, "Glyph instance layout must match the text buffer");
 
 class TextBuffer;
 typedef std::shared_ptr<TextBuffer> TextBufferRef;
 
+// Instances are written into a StreamBuffer, capacity is the glyphs per draw call
 class TextBuffer {
 public:
   static TextBufferRef Create(uint32_t capacity);
 
-  uint32_t draw(const std::vector<TextVertex>& vertices);
+  uint32_t draw(const GlyphInstance* glyphs, uint32_t glyphCount);
+
+  const StreamBuffer& getStream() const { return *_instances; }
 
 private:
   TextBuffer() = delete;
@@ -25,7 +34,7 @@ private:
   void setup();
 
 private:
-  VAORef   _vao;
-  uint32_t _maxVertices;
-  uint32_t _maxSize;
+  VAORef          _vao;
+  StreamBufferRef _instances;
+  uint32_t        _maxGlyphs;
 };
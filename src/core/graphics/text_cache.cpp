@@ -0,0 +1,120 @@
+#include "text_cache.h"
+
+TextCache::TextCache()
+  : _frame(0)
+  , _layouts(0) {
+}
+
+const TextRun& TextCache::getRun(FontAtlas& font, const std::string& text, float scale) {
+  auto inserted = _entries.try_emplace({ text, font.id(), scale });
+  Entry& entry = inserted.first->second;
+  entry.lastUsedFrame = _frame;
+
+  if (inserted.second || entry.run.atlasEvictions != font.getEvictionCount()) {
+    layout(font, text, scale, entry.run);
+    _layouts++;
+  }
+  else {
+    for (uint32_t glyph : entry.run.atlasGlyphs) {
+      font.touchGlyph(glyph);
+    }
+  }
+
+  return entry.run;
+}
+
+void TextCache::endFrame() {
+  _frame++;
+  _layouts = 0;
+
+  if (_frame % EvictFrames != 0)
+    return;
+
+  for (auto it = _entries.begin(); it != _entries.end();) {
+    if (_frame - it->second.lastUsedFrame > EvictFrames) {
+      it = _entries.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+size_t TextCache::KeyHash::operator()(const Key& key) const {
+  uint32_t scaleBits;
+  memcpy(&scaleBits, &key.scale, sizeof(scaleBits));
+
+  return std::hash<std::string>()(key.text) ^ (size_t)((((uint64_t)key.fontId << 32) | scaleBits) * 0x9E3779B97F4A7C15ull);
+}
+
+/*static*/ void TextCache::layout(FontAtlas& font, const std::string& text, float scale, TextRun& run) {
+  float xOffset = 0.0f;
+
+  GlyphInstance glyph;
+  memset(glyph.color, 0, sizeof(glyph.color));
+
+  run.glyphs.clear();
+  run.atlasGlyphs.clear();
+  run.glyphs.reserve(text.size());
+
+  for (size_t offset = 0; offset < text.size();) {
+    const uint32_t codepoint = decodeUtf8(text, offset);
+
+    uint32_t atlasGlyph = font.findGlyph(codepoint);
+    if (atlasGlyph == FontAtlas::InvalidGlyph) {
+      atlasGlyph = font.findGlyph('?');
+      if (atlasGlyph == FontAtlas::InvalidGlyph)
+        continue;
+    }
+
+    const auto& charInfo = font.getGlyphInfo(atlasGlyph);
+    glyph.position = glm::vec3(xOffset + charInfo.bearing.x * scale, (charInfo.bearing.y - charInfo.size.y) * scale, 0.0f);
+    glyph.size = charInfo.size * scale;
+    for (int k = 0; k < 4; ++k) {
+      glyph.atlasRect[k] = GlyphInstance::PackUnorm16(charInfo.atlasRect[k]);
+    }
+
+    run.glyphs.push_back(glyph);
+    run.atlasGlyphs.push_back(atlasGlyph);
+
+    xOffset += (charInfo.advance.x * scale);
+  }
+
+  // Glyphs found later in the same layout may evict ones found earlier only from older frames, never
+  // from this one, so the count is read once everything is in
+  run.atlasEvictions = font.getEvictionCount();
+  run.width = xOffset;
+}
+
+/*static*/ uint32_t TextCache::decodeUtf8(const std::string& text, size_t& offset) {
+  const uint8_t lead = (uint8_t)text[offset++];
+  if (lead < 0x80)
+    return lead;
+
+  int length;
+  uint32_t codepoint;
+  if ((lead & 0xE0) == 0xC0) {
+    length = 1;
+    codepoint = lead & 0x1F;
+  }
+  else if ((lead & 0xF0) == 0xE0) {
+    length = 2;
+    codepoint = lead & 0x0F;
+  }
+  else if ((lead & 0xF8) == 0xF0) {
+    length = 3;
+    codepoint = lead & 0x07;
+  }
+  else {
+    return 0xFFFD;
+  }
+
+  for (int i = 0; i < length; ++i) {
+    if (offset >= text.size() || ((uint8_t)text[offset] & 0xC0) != 0x80)
+      return 0xFFFD;
+
+    codepoint = (codepoint << 6) | ((uint8_t)text[offset++] & 0x3F);
+  }
+
+  return codepoint;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "font_atlas.h"
+#include "text_buffer.h"
+
+// Glyphs of a string laid out once. Positions are relative to the start of the baseline and the color
+// is left for the draw to fill in.
+struct TextRun {
+  std::vector<GlyphInstance> glyphs;
+  std::vector<uint32_t>      atlasGlyphs;    // Kept alive in the atlas while the run is drawn
+  uint32_t                   atlasEvictions; // Atlas eviction count at layout, rects may be stale after
+  float width;
+};
+
+// Text runs keyed by UTF-8 string, font and scale. Runs stay valid until endFrame(), the ones not drawn
+// for EvictFrames frames are released there. Runs are laid out again when the atlas evicted glyphs.
+class TextCache {
+public:
+  enum : uint32_t {
+    EvictFrames = 120,
+  };
+
+public:
+  TextCache();
+
+  const TextRun& getRun(FontAtlas& font, const std::string& text, float scale);
+  void endFrame();
+
+  uint32_t getRunCount() const { return (uint32_t)_entries.size(); }
+  // Runs laid out since the last endFrame()
+  uint32_t getLayoutCount() const { return _layouts; }
+
+private:
+  struct Key {
+    std::string text;
+    uint32_t    fontId;
+    float       scale;
+
+    bool operator==(const Key& other) const { return fontId == other.fontId && scale == other.scale && text == other.text; }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  struct Entry {
+    TextRun  run;
+    uint64_t lastUsedFrame;
+  };
+
+  static void layout(FontAtlas& font, const std::string& text, float scale, TextRun& run);
+  // Codepoint at offset, which is moved past it. Malformed sequences give U+FFFD.
+  static uint32_t decodeUtf8(const std::string& text, size_t& offset);
+
+private:
+  std::unordered_map<Key, Entry, KeyHash> _entries;
+  uint64_t _frame;
+  uint32_t _layouts;
+};
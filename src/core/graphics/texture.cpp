@@ -64,7 +64,12 @@ void Texture::load3DImage(const std::vector<ImageData>& images) {
 
 
 /*static*/ TextureRef Texture::Create(const TextureCreateParams& params) {
-  TextureRef texture(new Texture());
+  TextureRef texture = ResourcePool<Texture>::Get().create();
+
+  if (params.image != nullptr) {
+    texture->load2DImage(*params.image, params.wrapmode);
+    return texture;
+  }
 
   ImageData image;
   if (FileUtils::readImageFile(params.filePath, image)) {
@@ -75,7 +80,7 @@ void Texture::load3DImage(const std::vector<ImageData>& images) {
 }
 
 /*static*/ TextureRef Texture::CreateCubemap(const Texture3DCreateParams& params) {
-  TextureRef texture(new Texture());
+  TextureRef texture = ResourcePool<Texture>::Get().create();
 
   const int kRequiredTextures = 6;
   const int fileCount = std::min((int)params.filePaths.size(), kRequiredTextures);
@@ -99,3 +104,7 @@ void Texture::load3DImage(const std::vector<ImageData>& images) {
 
   return texture;
 }
+
+/*static*/ void Texture::Destroy(TextureRef texture) {
+  ResourcePool<Texture>::Get().destroy(texture);
+}
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "core/resource_pool.h"
+
 struct ImageData;
 
 class Texture;
-typedef std::shared_ptr<Texture> TextureRef;
+typedef Handle<Texture> TextureRef;
 
 enum class TextureWrapMode {
   Repeat = 0,
@@ -15,11 +17,13 @@ enum class TextureWrapMode {
 struct TextureCreateParams {
   TextureCreateParams()
     : filePath(nullptr)
+    , image(nullptr)
     , wrapmode(TextureWrapMode::Repeat) {
     }
 
-  const char*     filePath;
-  TextureWrapMode wrapmode;
+  const char*      filePath;
+  const ImageData* image;     // Already decoded, filePath is ignored
+  TextureWrapMode  wrapmode;
 };
 
 struct Texture3DCreateParams {
@@ -47,8 +51,11 @@ public:
 
   static TextureRef Create(const TextureCreateParams& params);
   static TextureRef CreateCubemap(const Texture3DCreateParams& params);
+  static void Destroy(TextureRef texture);
 
 private:
+  friend class ResourcePool<Texture>;
+
   Texture();
   Texture(const Texture& texture) = delete;
 
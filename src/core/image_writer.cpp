@@ -0,0 +1,214 @@
+#include "image_writer.h"
+
+ImageWriter::ImageWriter()
+  : _videoWidth(0)
+  , _videoHeight(0)
+  , _written(0)
+  , _stopping(false) {
+}
+
+ImageWriter::~ImageWriter() {
+  stop();
+}
+
+void ImageWriter::start(uint32_t bufferCount) {
+  if (_thread.joinable())
+    return;
+
+  _images.clear();
+  _freeImages.clear();
+  for (uint32_t i = 0; i < bufferCount; ++i) {
+    _images.push_back(std::make_unique<ImageData>());
+    _freeImages.push_back(_images.back().get());
+  }
+
+  _stopping = false;
+  _thread = std::thread(&ImageWriter::run, this);
+}
+
+void ImageWriter::stop() {
+  if (!_thread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _condition.notify_all();
+  _thread.join();
+}
+
+ImageData* ImageWriter::acquire(bool wait) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (wait) {
+    _condition.wait(lock, [this]() { return !_freeImages.empty(); });
+  }
+
+  if (_freeImages.empty())
+    return nullptr;
+
+  ImageData* image = _freeImages.back();
+  _freeImages.pop_back();
+
+  return image;
+}
+
+void ImageWriter::write(ImageData* image, const std::string& filePath) {
+  push({ JobType::Image, image, filePath, 0, 0 });
+}
+
+void ImageWriter::writeVideoFrame(ImageData* image, const std::string& filePath, uint32_t fpsNum, uint32_t fpsDen) {
+  push({ JobType::VideoFrame, image, filePath, fpsNum, fpsDen });
+}
+
+void ImageWriter::closeVideo() {
+  push({ JobType::CloseVideo, nullptr, std::string(), 0, 0 });
+}
+
+void ImageWriter::push(Job&& job) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobs.push_back(std::move(job));
+  }
+  _condition.notify_all();
+}
+
+uint32_t ImageWriter::getQueuedCount() {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  return _jobs.size();
+}
+
+void ImageWriter::run() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]() { return !_jobs.empty() || _stopping; });
+
+      if (_jobs.empty())
+        break;
+
+      job = std::move(_jobs.front());
+      _jobs.pop_front();
+    }
+
+    if (job.type == JobType::CloseVideo) {
+      if (_video.is_open()) {
+        _video.close();
+        LOG_INFO("[ImageWriter] Video {} saved", _videoPath);
+      }
+      continue;
+    }
+
+    bool saved = false;
+    if (job.type == JobType::VideoFrame) {
+      saved = appendVideoFrame(job);
+    }
+    else {
+      const auto absolutePath = FileUtils::getAbsolutePath(job.filePath.c_str());
+      std::error_code error;
+      std::filesystem::create_directories(std::filesystem::path(absolutePath).parent_path(), error);
+
+      saved = FileUtils::saveImageToFile(absolutePath.c_str(), *job.image);
+    }
+
+    if (saved) {
+      _written++;
+    }
+
+    release(job.image);
+  }
+
+  if (_video.is_open()) {
+    _video.close();
+  }
+}
+
+bool ImageWriter::appendVideoFrame(const Job& job) {
+  const ImageData& image = *job.image;
+
+  if (!_video.is_open() || _videoPath != job.filePath) {
+    const auto absolutePath = FileUtils::getAbsolutePath(job.filePath.c_str());
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(absolutePath).parent_path(), error);
+
+    _video.close();
+    _video.open(absolutePath, std::ios::binary | std::ios::trunc);
+    if (!_video) {
+      LOG_ERROR("[ImageWriter] Could not open video {0}, {1}", absolutePath, strerror(errno));
+      return false;
+    }
+
+    _videoPath = job.filePath;
+    _videoWidth = image.width;
+    _videoHeight = image.height;
+    _video << "YUV4MPEG2 W" << image.width << " H" << image.height << " F" << job.fpsNum << ":" << job.fpsDen << " Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+  }
+
+  // Y4M has no way to change size mid-stream
+  if (image.width != _videoWidth || image.height != _videoHeight) {
+    LOG_WARN("[ImageWriter] Skipped {}x{} frame in {}x{} video {}", image.width, image.height, _videoWidth, _videoHeight, _videoPath);
+    return false;
+  }
+
+  ConvertToYUV420(image, _yuv);
+  _video << "FRAME\n";
+  _video.write((const char*)_yuv.data(), _yuv.size());
+
+  return !_video.fail();
+}
+
+// Full range BT.601 in 8 bit fixed point, chroma averaged over 2x2 pixels
+/*static*/ void ImageWriter::ConvertToYUV420(const ImageData& image, std::vector<uint8_t>& yuv) {
+  const int width = image.width;
+  const int height = image.height;
+  const int chromaWidth = (width + 1) / 2;
+  const int chromaHeight = (height + 1) / 2;
+  const int bpp = image.bytesPerPixel;
+  const uint8_t* rgb = image.data.data();
+
+  yuv.resize(width * height + chromaWidth * chromaHeight * 2);
+  uint8_t* planeY = yuv.data();
+  uint8_t* planeU = planeY + width * height;
+  uint8_t* planeV = planeU + chromaWidth * chromaHeight;
+
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* src = rgb + y * width * bpp;
+    uint8_t* dst = planeY + y * width;
+    for (int x = 0; x < width; ++x, src += bpp) {
+      dst[x] = (uint8_t)((77 * src[0] + 150 * src[1] + 29 * src[2] + 128) >> 8);
+    }
+  }
+
+  for (int cy = 0; cy < chromaHeight; ++cy) {
+    const int y0 = cy * 2;
+    const int y1 = std::min(y0 + 1, height - 1);
+    for (int cx = 0; cx < chromaWidth; ++cx) {
+      const int x0 = cx * 2;
+      const int x1 = std::min(x0 + 1, width - 1);
+      const uint8_t* p[4] = {
+        rgb + (y0 * width + x0) * bpp, rgb + (y0 * width + x1) * bpp,
+        rgb + (y1 * width + x0) * bpp, rgb + (y1 * width + x1) * bpp
+      };
+
+      const int r = p[0][0] + p[1][0] + p[2][0] + p[3][0];
+      const int g = p[0][1] + p[1][1] + p[2][1] + p[3][1];
+      const int b = p[0][2] + p[1][2] + p[2][2] + p[3][2];
+
+      // Sums of 4 pixels, 128 << 10 recenters and keeps the shifted value positive
+      const int u = (-43 * r - 85 * g + 128 * b + (128 << 10) + 512) >> 10;
+      const int v = (128 * r - 107 * g - 21 * b + (128 << 10) + 512) >> 10;
+      planeU[cy * chromaWidth + cx] = (uint8_t)std::min(u, 255);
+      planeV[cy * chromaWidth + cx] = (uint8_t)std::min(v, 255);
+    }
+  }
+}
+
+void ImageWriter::release(ImageData* image) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _freeImages.push_back(image);
+  }
+  _condition.notify_all();
+}
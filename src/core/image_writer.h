@@ -0,0 +1,72 @@
+#pragma once
+
+#include "file_utils.h"
+
+#include <atomic>
+#include <fstream>
+
+// Encodes and saves images, or appends them to a Y4M video, on a worker thread. Images live in a fixed
+// pool: acquire() a buffer, fill it and hand it to write(), it goes back to the pool once saved. The
+// queue can never outgrow the pool, when the disk falls behind acquire() fails (or waits) instead.
+class ImageWriter {
+public:
+  ImageWriter();
+  ~ImageWriter();
+
+  void start(uint32_t bufferCount);
+  // Saves everything queued, then stops the worker
+  void stop();
+
+  // nullptr when every buffer is queued, unless wait
+  ImageData* acquire(bool wait = false);
+  // PNG or JPEG after the extension, filePath is relative to the assets folder
+  void write(ImageData* image, const std::string& filePath);
+  // Appends to the Y4M video at filePath (4:2:0, fpsNum/fpsDen), the file is opened by its first frame
+  // and every frame must have that size
+  void writeVideoFrame(ImageData* image, const std::string& filePath, uint32_t fpsNum, uint32_t fpsDen);
+  // Closes the video once the frames queued before are written
+  void closeVideo();
+
+  uint32_t getQueuedCount();
+  uint32_t getWrittenCount() const { return _written; }
+
+private:
+  enum class JobType {
+    Image,
+    VideoFrame,
+    CloseVideo
+  };
+
+  struct Job {
+    JobType     type;
+    ImageData*  image;
+    std::string filePath;
+    uint32_t    fpsNum;
+    uint32_t    fpsDen;
+  };
+
+  void run();
+  void push(Job&& job);
+  void release(ImageData* image);
+  bool appendVideoFrame(const Job& job);
+
+  static void ConvertToYUV420(const ImageData& image, std::vector<uint8_t>& yuv);
+
+private:
+  std::vector<std::unique_ptr<ImageData>> _images;
+  std::vector<ImageData*> _freeImages;
+  std::deque<Job> _jobs;
+
+  // Worker thread side
+  std::ofstream _video;
+  std::string _videoPath;
+  int _videoWidth;
+  int _videoHeight;
+  std::vector<uint8_t> _yuv;
+
+  std::thread _thread;
+  std::mutex  _mutex;
+  std::condition_variable _condition;
+  std::atomic<uint32_t> _written;
+  bool        _stopping;
+};
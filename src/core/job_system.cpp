@@ -0,0 +1,296 @@
+#include "job_system.h"
+
+#define JOB_SYSTEM_SPIN_COUNT 64
+
+static thread_local uint32_t tThreadIndex = ~0u;
+
+// WorkQueue
+
+JobSystem::WorkQueue::WorkQueue()
+  : _top(0)
+  , _bottom(0) {
+}
+
+bool JobSystem::WorkQueue::push(Job* job) {
+  const int64_t bottom = _bottom.load(std::memory_order_relaxed);
+  const int64_t top = _top.load(std::memory_order_acquire);
+  if (bottom - top >= (int64_t)MaxJobsPerThread)
+    return false;
+
+  _entries[bottom & (MaxJobsPerThread - 1)].store(job, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  _bottom.store(bottom + 1, std::memory_order_relaxed);
+
+  return true;
+}
+
+JobSystem::Job* JobSystem::WorkQueue::pop() {
+  const int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+  _bottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t top = _top.load(std::memory_order_relaxed);
+
+  if (top > bottom) {
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Job* job = _entries[bottom & (MaxJobsPerThread - 1)].load(std::memory_order_relaxed);
+  if (top == bottom) {
+    // Last job, race the thieves for it
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  return job;
+}
+
+JobSystem::Job* JobSystem::WorkQueue::steal() {
+  int64_t top = _top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const int64_t bottom = _bottom.load(std::memory_order_acquire);
+
+  if (top >= bottom)
+    return nullptr;
+
+  Job* job = _entries[top & (MaxJobsPerThread - 1)].load(std::memory_order_relaxed);
+  if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    return nullptr;
+
+  return job;
+}
+
+// JobSystem
+
+JobSystem::JobSystem()
+  : _threadCount(0)
+  , _workerCount(0)
+  , _activeWorkers(0)
+  , _queuedJobs(0)
+  , _sleeping(0)
+  , _stopping(false) {
+}
+
+JobSystem::~JobSystem() {
+  shutdown();
+}
+
+void JobSystem::init(uint32_t workerCount) {
+  if (workerCount == 0) {
+    workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  }
+
+  _workerCount = workerCount;
+  _threadCount = 1 + workerCount + MaxAttachedThreads;
+  _activeWorkers = workerCount;
+
+  _threads.reset(new ThreadData[_threadCount]);
+  for (uint32_t i = 0; i < _threadCount; ++i) {
+    auto& thread = _threads[i];
+    thread.jobs.reset(new Job[MaxJobsPerThread]);
+    thread.nextJob = 0;
+    thread.attached = i <= workerCount;
+
+    for (uint32_t j = 0; j < MaxJobsPerThread; ++j) {
+      thread.jobs[j].finished.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  tThreadIndex = 0;
+
+  _workers.reserve(workerCount);
+  for (uint32_t i = 1; i <= workerCount; ++i) {
+    _workers.emplace_back(&JobSystem::workerMain, this, i);
+  }
+
+  LOG_INFO("[JobSystem] {} workers", workerCount);
+}
+
+void JobSystem::shutdown() {
+  if (_workers.empty())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_sleepMutex);
+    _stopping = true;
+  }
+  _wake.notify_all();
+
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+  _workers.clear();
+}
+
+void JobSystem::attachThread() {
+  for (uint32_t i = _workerCount + 1; i < _threadCount; ++i) {
+    bool attached = false;
+    if (_threads[i].attached.compare_exchange_strong(attached, true)) {
+      tThreadIndex = i;
+      return;
+    }
+  }
+
+  LOG_WARN("[JobSystem] No free thread slot, jobs submitted from this thread run inline");
+}
+
+void JobSystem::detachThread() {
+  if (tThreadIndex <= _workerCount || tThreadIndex >= _threadCount)
+    return;
+
+  // Jobs pushed by this thread may still be queued, help until its deque is empty
+  auto& thread = _threads[tThreadIndex];
+  while (Job* job = thread.queue.pop()) {
+    _queuedJobs.fetch_sub(1);
+    execute(*job);
+  }
+
+  thread.attached = false;
+  tThreadIndex = ~0u;
+}
+
+uint32_t JobSystem::getThreadIndex() const {
+  return tThreadIndex;
+}
+
+void JobSystem::setActiveWorkers(uint32_t count) {
+  _activeWorkers = std::min(count, _workerCount);
+  wakeWorkers(true);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+  while (!counter.isDone()) {
+    if (Job* job = findJob()) {
+      execute(*job);
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+JobSystem::Job* JobSystem::allocateJob() {
+  if (tThreadIndex >= _threadCount)
+    return nullptr;
+
+  auto& thread = _threads[tThreadIndex];
+  Job* job = &thread.jobs[thread.nextJob++ & (MaxJobsPerThread - 1)];
+
+  // The ring wrapped around onto a job still in flight
+  while (!job->finished.load(std::memory_order_acquire)) {
+    if (Job* other = findJob()) {
+      execute(*other);
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+
+  job->finished.store(false, std::memory_order_relaxed);
+  return job;
+}
+
+void JobSystem::submit(Job* job) {
+  auto& thread = _threads[tThreadIndex];
+
+  _queuedJobs.fetch_add(1);
+  while (!thread.queue.push(job)) {
+    if (Job* other = findJob()) {
+      execute(*other);
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::wakeWorkers(bool all) {
+  if (_sleeping.load() == 0)
+    return;
+
+  // Taking the lock orders this with a worker about to sleep, so the wake-up is not lost
+  std::lock_guard<std::mutex> lock(_sleepMutex);
+  if (all || _activeWorkers.load(std::memory_order_relaxed) < _workerCount) {
+    _wake.notify_all();
+  }
+  else {
+    _wake.notify_one();
+  }
+}
+
+JobSystem::Job* JobSystem::findJob() {
+  const uint32_t self = tThreadIndex;
+
+  if (self < _threadCount) {
+    if (Job* job = _threads[self].queue.pop()) {
+      _queuedJobs.fetch_sub(1);
+      return job;
+    }
+  }
+
+  if (_queuedJobs.load(std::memory_order_relaxed) == 0)
+    return nullptr;
+
+  // Start after our own slot so thieves spread over the victims
+  const uint32_t start = self < _threadCount ? self + 1 : 0;
+  for (uint32_t i = 0; i < _threadCount; ++i) {
+    const uint32_t victim = (start + i) % _threadCount;
+    if (victim == self)
+      continue;
+
+    if (Job* job = _threads[victim].queue.steal()) {
+      _queuedJobs.fetch_sub(1);
+      return job;
+    }
+  }
+
+  return nullptr;
+}
+
+void JobSystem::execute(Job& job) {
+  if (job.dependency != nullptr) {
+    wait(const_cast<JobCounter&>(*job.dependency));
+  }
+
+  job.function(job);
+
+  JobCounter* counter = job.counter;
+  job.finished.store(true, std::memory_order_release);
+
+  if (counter != nullptr) {
+    counter->_value.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+void JobSystem::workerMain(uint32_t index) {
+  tThreadIndex = index;
+
+  while (true) {
+    if (index <= _activeWorkers.load(std::memory_order_relaxed)) {
+      Job* job = nullptr;
+      for (uint32_t spin = 0; spin < JOB_SYSTEM_SPIN_COUNT && job == nullptr; ++spin) {
+        job = findJob();
+        if (job == nullptr) {
+          std::this_thread::yield();
+        }
+      }
+
+      if (job != nullptr) {
+        execute(*job);
+        continue;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(_sleepMutex);
+    _sleeping.fetch_add(1);
+    _wake.wait(lock, [this, index]() {
+      return _stopping.load() || (_queuedJobs.load() > 0 && index <= _activeWorkers.load());
+    });
+    _sleeping.fetch_sub(1);
+
+    if (_stopping)
+      break;
+  }
+}
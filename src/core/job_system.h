@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+
+// Number of unfinished jobs signaling it. Waiting on a counter runs other jobs meanwhile.
+class JobCounter {
+public:
+  JobCounter()
+    : _value(0) {
+  }
+  JobCounter(const JobCounter&) = delete;
+
+  bool isDone() const { return _value.load(std::memory_order_acquire) == 0; }
+
+private:
+  friend class JobSystem;
+
+  std::atomic<uint32_t> _value;
+};
+
+// Fixed pool of worker threads executing small jobs. Every thread owns a work-stealing deque: jobs are
+// pushed and popped (LIFO) at the bottom by the owner and stolen (FIFO) from the top by the others.
+// Jobs live in per-thread ring pools, so running one never touches the heap.
+//
+// The thread creating the JobSystem takes part in the work while it waits. Other threads submitting jobs
+// (the render thread) must call attachThread() first.
+class JobSystem {
+public:
+  enum {
+    MaxJobsPerThread = 4096,
+    MaxAttachedThreads = 2,
+    JobDataSize = 48,
+  };
+
+public:
+  JobSystem();
+  ~JobSystem();
+
+  // workerCount 0 uses one worker per hardware thread besides the calling one
+  void init(uint32_t workerCount = 0);
+  void shutdown();
+
+  void attachThread();
+  void detachThread();
+
+  // Runs fn() on any thread. counter is signaled once it finishes, dependency must be done before it starts.
+  template<typename F>
+  void run(F&& fn, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr);
+
+  void wait(JobCounter& counter);
+
+  // Calls fn(begin, end) over [0, count) in batches of at least minBatchSize items and returns when all are done
+  template<typename F>
+  void parallelFor(uint32_t count, uint32_t minBatchSize, const F& fn);
+
+  // Threads able to run jobs, for sizing per-thread scratch data indexed by getThreadIndex()
+  uint32_t getThreadCount() const { return _threadCount; }
+  uint32_t getThreadIndex() const;
+
+  // Workers taking jobs, the rest sleep. Used to measure scaling.
+  void setActiveWorkers(uint32_t count);
+  uint32_t getActiveWorkers() const { return _activeWorkers.load(std::memory_order_relaxed); }
+  uint32_t getWorkerCount() const { return _workerCount; }
+
+private:
+  struct Job {
+    void (*function)(Job& job);
+    JobCounter*       counter;
+    const JobCounter* dependency;
+    std::atomic<bool> finished;
+    alignas(16) uint8_t data[JobDataSize];
+  };
+
+  // Chase-Lev deque of fixed capacity
+  class WorkQueue {
+  public:
+    WorkQueue();
+
+    bool push(Job* job);
+    Job* pop();
+    Job* steal();
+
+  private:
+    std::atomic<int64_t> _top;
+    std::atomic<int64_t> _bottom;
+    std::array<std::atomic<Job*>, MaxJobsPerThread> _entries;
+  };
+
+  struct ThreadData {
+    WorkQueue queue;
+    std::unique_ptr<Job[]> jobs;
+    uint32_t nextJob;
+    std::atomic<bool> attached;
+  };
+
+  template<typename F>
+  static void invoke(Job& job) {
+    F& fn = *reinterpret_cast<F*>(job.data);
+    fn();
+    fn.~F();
+  }
+
+  Job* allocateJob();
+  void submit(Job* job);
+  void wakeWorkers(bool all);
+
+  Job* findJob();
+  void execute(Job& job);
+  void workerMain(uint32_t index);
+
+private:
+  std::unique_ptr<ThreadData[]> _threads; // Creating thread, workers, attachable slots
+  std::vector<std::thread> _workers;
+  uint32_t _threadCount;
+  uint32_t _workerCount;
+
+  std::atomic<uint32_t> _activeWorkers;
+  std::atomic<uint32_t> _queuedJobs;
+  std::atomic<uint32_t> _sleeping;
+  std::atomic<bool>     _stopping;
+  std::mutex _sleepMutex;
+  std::condition_variable _wake;
+};
+
+template<typename F>
+void JobSystem::run(F&& fn, JobCounter* counter, const JobCounter* dependency) {
+  typedef typename std::decay<F>::type Fn;
+  static_assert(sizeof(Fn) <= JobDataSize, "Job captures too much, capture pointers instead");
+
+  Job* job = allocateJob();
+  if (job == nullptr) {
+    // Not a job thread, nothing to push to
+    if (dependency != nullptr) {
+      wait(const_cast<JobCounter&>(*dependency));
+    }
+    fn();
+    return;
+  }
+
+  new (job->data) Fn(std::forward<F>(fn));
+  job->function = &JobSystem::invoke<Fn>;
+  job->counter = counter;
+  job->dependency = dependency;
+
+  if (counter != nullptr) {
+    counter->_value.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  submit(job);
+  wakeWorkers(false);
+}
+
+template<typename F>
+void JobSystem::parallelFor(uint32_t count, uint32_t minBatchSize, const F& fn) {
+  if (count == 0)
+    return;
+
+  // A few batches per thread so stealing can even out uneven items
+  const uint32_t threads = getActiveWorkers() + 1;
+  const uint32_t batchSize = std::max({ (count + threads * 4 - 1) / (threads * 4), minBatchSize, 1u });
+
+  if (batchSize >= count || getThreadIndex() >= _threadCount) {
+    fn(0u, count);
+    return;
+  }
+
+  JobCounter counter;
+  for (uint32_t begin = batchSize; begin < count; begin += batchSize) {
+    const uint32_t end = std::min(begin + batchSize, count);
+    Job* job = allocateJob();
+
+    const F* function = &fn;
+    auto batch = [function, begin, end]() { (*function)(begin, end); };
+    new (job->data) decltype(batch)(batch);
+    job->function = &JobSystem::invoke<decltype(batch)>;
+    job->counter = &counter;
+    job->dependency = nullptr;
+
+    counter._value.fetch_add(1, std::memory_order_relaxed);
+    submit(job);
+  }
+  wakeWorkers(true);
+
+  fn(0u, batchSize);
+  wait(counter);
+}
@@ -0,0 +1,49 @@
+#include "linear_allocator.h"
+
+#define LINEAR_ALLOCATOR_MIN_BLOCK (64 * 1024)
+
+LinearAllocator::LinearAllocator(size_t capacity)
+  : _offset(0)
+  , _used(0)
+  , _capacity(0) {
+  if (capacity > 0) {
+    addBlock(capacity);
+  }
+}
+
+void* LinearAllocator::allocate(size_t size, size_t alignment) {
+  if (!_blocks.empty()) {
+    auto& block = _blocks.back();
+    const uintptr_t base = (uintptr_t)block.data.get();
+    const size_t offset = (((base + _offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+
+    if (offset + size <= block.size) {
+      _used += size + (offset - _offset);
+      _offset = offset + size;
+      return block.data.get() + offset;
+    }
+  }
+
+  addBlock(std::max({ size + alignment, _capacity, (size_t)LINEAR_ALLOCATOR_MIN_BLOCK }));
+
+  return allocate(size, alignment);
+}
+
+void LinearAllocator::reset() {
+  // Several blocks means the frame outgrew the first one, keep a single block big enough for all of them
+  if (_blocks.size() > 1) {
+    const size_t capacity = _capacity;
+    _blocks.clear();
+    _capacity = 0;
+    addBlock(capacity);
+  }
+
+  _offset = 0;
+  _used = 0;
+}
+
+void LinearAllocator::addBlock(size_t size) {
+  _blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[size]), size });
+  _offset = 0;
+  _capacity += size;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+// Bump allocator for per-frame data, everything is released at once with reset(). Allocations never move,
+// when the current block is full a new one is chained and reset() folds them into a single block, so a
+// steady workload stops touching the heap after the first frames.
+class LinearAllocator {
+public:
+  LinearAllocator(size_t capacity = 0);
+  LinearAllocator(LinearAllocator&& other) = default;
+  LinearAllocator(const LinearAllocator&) = delete;
+  LinearAllocator& operator=(LinearAllocator&& other) = default;
+
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  template<typename T>
+  T* allocate(size_t count) {
+    return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  void reset();
+
+  size_t used() const { return _used; }
+  size_t capacity() const { return _capacity; }
+
+private:
+  struct Block {
+    std::unique_ptr<uint8_t[]> data;
+    size_t size;
+  };
+
+  void addBlock(size_t size);
+
+private:
+  std::vector<Block> _blocks;
+  size_t _offset;   // In the last block
+  size_t _used;
+  size_t _capacity;
+};
+
+// Growable array of trivially copyable items living in a LinearAllocator. Growing copies into a bigger
+// allocation and leaves the old one until the allocator resets, so pointers to items are only stable
+// while the array does not grow. Copies are shallow views of the same storage.
+template<typename T>
+class LinearArray {
+  static_assert(std::is_trivially_copyable<T>::value, "LinearArray items are copied with memcpy");
+
+public:
+  enum {
+    MinCapacity = 64
+  };
+
+  LinearArray()
+    : _allocator(nullptr)
+    , _data(nullptr)
+    , _size(0)
+    , _capacity(0)
+    , _capacityHint(MinCapacity) {
+  }
+
+  explicit LinearArray(LinearAllocator& allocator)
+    : LinearArray() {
+    _allocator = &allocator;
+  }
+
+  // Drops the storage, call after resetting the allocator. The first allocation is as big as the last one.
+  void reset() {
+    _capacityHint = std::max(_capacity, _capacityHint);
+    _data = nullptr;
+    _size = 0;
+    _capacity = 0;
+  }
+
+  void push_back(const T& item) {
+    if (_size == _capacity) {
+      grow();
+    }
+    _data[_size++] = item;
+  }
+
+  uint32_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+  T* data() { return _data; }
+  const T* data() const { return _data; }
+
+  T& operator[](uint32_t index) { return _data[index]; }
+  const T& operator[](uint32_t index) const { return _data[index]; }
+
+  T* begin() { return _data; }
+  T* end() { return _data + _size; }
+  const T* begin() const { return _data; }
+  const T* end() const { return _data + _size; }
+
+private:
+  void grow() {
+    const uint32_t capacity = _capacity > 0 ? _capacity * 2 : _capacityHint;
+    T* data = _allocator->allocate<T>(capacity);
+    if (_size > 0) {
+      memcpy(data, _data, sizeof(T) * _size);
+    }
+
+    _data = data;
+    _capacity = capacity;
+  }
+
+private:
+  LinearAllocator* _allocator;
+  T*       _data;
+  uint32_t _size;
+  uint32_t _capacity;
+  uint32_t _capacityHint;
+};
@@ -0,0 +1,80 @@
+#include "render_thread.h"
+#include "job_system.h"
+#include "renderer.h"
+#include "window.h"
+
+RenderThread::RenderThread(Window& window, Renderer& renderer, JobSystem& jobSystem)
+  : _window(window)
+  , _renderer(renderer)
+  , _jobSystem(jobSystem)
+  , _queued(0)
+  , _latency(0)
+  , _stopping(false) {
+}
+
+RenderThread::~RenderThread() {
+  stop();
+}
+
+void RenderThread::start(uint32_t latency) {
+  if (isRunning())
+    return;
+
+  _latency = std::max(latency, 1u);
+  _queued = 0;
+  _stopping = false;
+
+  _window.makeContextCurrent(false);
+  _thread = std::thread(&RenderThread::run, this);
+
+  LOG_INFO("[RenderThread] Started, {} frame(s) of latency", _latency);
+}
+
+void RenderThread::stop() {
+  if (!isRunning())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _condition.notify_all();
+  _thread.join();
+
+  _window.makeContextCurrent(true);
+}
+
+void RenderThread::submit() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _queued++;
+  _condition.notify_all();
+
+  _condition.wait(lock, [this]() { return _queued <= _latency; });
+}
+
+void RenderThread::run() {
+  _window.makeContextCurrent(true);
+  _jobSystem.attachThread();
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]() { return _queued > 0 || _stopping; });
+
+      if (_queued == 0)
+        break;
+    }
+
+    _renderer.renderFrame();
+    _window.update();
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _queued--;
+    }
+    _condition.notify_all();
+  }
+
+  _jobSystem.detachThread();
+  _window.makeContextCurrent(false);
+}
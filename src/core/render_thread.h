@@ -0,0 +1,37 @@
+#pragma once
+
+class JobSystem;
+class Renderer;
+class Window;
+
+// Renders and presents the frames closed by the update thread. While running it owns the GL context,
+// the update thread works up to `latency` frames ahead.
+class RenderThread {
+public:
+  RenderThread(Window& window, Renderer& renderer, JobSystem& jobSystem);
+  ~RenderThread();
+
+  void start(uint32_t latency);
+  // Renders the frames still queued and gives the GL context back to the calling thread
+  void stop();
+
+  bool isRunning() const { return _thread.joinable(); }
+
+  // Queues the frame closed by Renderer::endFrame, blocks while `latency` frames are already queued
+  void submit();
+
+private:
+  void run();
+
+private:
+  Window&   _window;
+  Renderer& _renderer;
+  JobSystem& _jobSystem;
+
+  std::thread _thread;
+  std::mutex  _mutex;
+  std::condition_variable _condition;
+  uint32_t    _queued;
+  uint32_t    _latency;
+  bool        _stopping;
+};
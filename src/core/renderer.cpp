@@ -1,6 +1,7 @@
 #include "renderer.h"
 #include "file_utils.h"
 #include "font.h"
+#include "simd_math.h"
 #include "graphics/debug_utils.h"
 
 #include "imgui/imgui_impl_sdl.h"
@@ -10,36 +11,117 @@
 #define UBO_CAMERA_IDX 0
 #define UBO_LIGHTS_IDX 1
 
-#define TEXT_BUFFER_CAPACITY 2048
-#define TEXT_VERTICES_CAPACITY 2048 * 6
+#define TEXT_BUFFER_CAPACITY 8192
+#define FRAME_ALLOCATOR_CAPACITY (512 * 1024)
+#define SCREENSHOT_BUFFER_COUNT 2
 
 #define SHADOW_MAP_HEIGHT 1024
 #define SHADOW_MAP_WIDTH  1024
 #define SHADOW_MAP_TEXTURE_SLOT 4
+#define DRAW_TRANSFORMS_TEXTURE_SLOT 5
+#define POINT_LIGHTS_TEXTURE_SLOT 6
+#define LIGHT_CLUSTERS_TEXTURE_SLOT 7
+#define LIGHT_INDICES_TEXTURE_SLOT 8
+#define DRAW_LIGHTS_TEXTURE_SLOT 9
+#define GBUFFER_TEXTURE_SLOT 0 // 3 slots, reuses the material slots
+
+#define INVALID_LIGHT (~0u)
+
+#define OCCLUDER_MIN_SCREEN_SIZE 0.1f
 
 Renderer::Renderer()
-  : _clearColor(0.0f)
+  : _screenshotPending(false)
+  , _captureRequested(false)
+  , _framePooledTargets(0)
+  , _frameCount(1)
+  , _submitIndex(0)
+  , _renderIndex(0)
+  , _publishedPooledTargets(0)
+  , _clearColor(0.0f)
   , _wireframeEnabled(false)
-  , _debugEnabled(false) {
+  , _debugEnabled(false)
+  , _multiDrawSupported(false)
+  , _multiDrawEnabled(false)
+  , _gpuCullingEnabled(false)
+  , _occlusionCullingEnabled(false)
+  , _depthPrepassEnabled(false)
+  , _lightAssignment(LightAssignment::Clustered)
+  , _renderPath(RenderPath::Forward)
+  , _recordInterval(0)
+  , _recordFormat(FrameRecorder::Format::Y4M) {
     _viewCamera = Camera(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f, 65.0f, 0.1f, 50.0f);
-    _mainPassList.reserve(256);
-    _shadowPassList.reserve(256);
+    _settings = { ColorRGB(0.0f), 0, 0, false, false, false, false, false, false, LightAssignment::Clustered, RenderPath::Forward, 0, FrameRecorder::Format::Y4M };
+    for (auto& frame : _frames) {
+      frame.allocator = LinearAllocator(FRAME_ALLOCATOR_CAPACITY);
+      frame.mainPassList = RenderList(frame.allocator);
+      frame.shadowPassList = RenderList(frame.allocator);
+      frame.lightsList = LightsList(frame.allocator);
+      frame.textDraws = LinearArray<TextDraw>(frame.allocator);
+      frame.glyphs = LinearArray<GlyphInstance>(frame.allocator);
+      frame.glyphUploads = LinearArray<FontAtlas::Upload>(frame.allocator);
+      frame.objectOps = LinearArray<ObjectOp>(frame.allocator);
+      frame.captureScreen = false;
+      frame.resourceFrame = 0;
+      frame.textRuns = 0;
+      frame.textLayouts = 0;
+      frame.atlasGlyphs = 0;
+    }
+    _drawTransforms.reserve(512);
+    _drawLights.reserve(512 * 2);
+    _drawCommands.reserve(512);
+}
+
+Renderer::~Renderer() {
+  Shader::Destroy(_textShader);
+  Shader::Destroy(_shadowmapShader);
+  Shader::Destroy(_depthPrepassShader);
+  Shader::Destroy(_screenQuadDepthShader);
+  Shader::Destroy(_deferredLightingShader);
+  Mesh::Destroy(_screenDebugQuad);
+
+  if (_screenshotReadback) {
+    saveScreenshots(true);
+    _screenshotReadback = nullptr;
+  }
+  _imageWriter.stop();
+  _frameRecorder.shutdown();
+  _gpuScene.shutdown();
+  _occlusionCuller.shutdown();
+
+  // Meshes give their ranges back to the arena when released
+  ResourcePools::shutdown();
+  GeometryArena::shutdown();
 }
 
-void Renderer::init(int width, int height) {
+void Renderer::init(int width, int height, JobSystem& jobSystem) {
   LOG_INFO("[Renderer] Initializing resources");
 
   setViewport(width, height);
 
   _font = Font::loadFont("fonts/meslo_lgs_bold.ttf", 20);
   _textBuffer = TextBuffer::Create(TEXT_BUFFER_CAPACITY);
-  _textVertices.reserve(TEXT_VERTICES_CAPACITY);
 
-  FBOSpec shadowmapSpec;
-  shadowmapSpec.height = SHADOW_MAP_HEIGHT;
-  shadowmapSpec.width = SHADOW_MAP_WIDTH;
-  shadowmapSpec.type = FBOType::Shadowmap;
-  _fboShadowmap = FBO::Create(shadowmapSpec);
+  _screenshotReadback = FrameReadback::Create();
+  _imageWriter.start(SCREENSHOT_BUFFER_COUNT);
+  _frameRecorder.init();
+
+  // glMultiDrawElementsIndirect and baseInstance need GL 4.3, older contexts issue one draw per command
+  _multiDrawSupported = GLAD_GL_VERSION_4_3 != 0;
+  _settings.multiDraw = _multiDrawSupported;
+  LOG_INFO("[Renderer] OpenGL {}.{}, multi-draw indirect {}", GLVersion.major, GLVersion.minor, _multiDrawSupported ? "supported" : "not supported");
+
+  _drawTransformsBuffer = TBO::Create(TBOFormat::RGBA32F, sizeof(glm::mat4) * 512);
+  _drawLightsBuffer = TBO::Create(TBOFormat::RGBA32UI, sizeof(glm::uvec4) * 2 * 512);
+  _drawCommandsBuffer = IndirectBuffer::Create(sizeof(DrawElementsIndirectCommand) * 512);
+
+  _gpuScene.init();
+  _settings.gpuCulling = _gpuScene.isSupported();
+
+  _occlusionCuller.init();
+  _lightClusters.init(jobSystem);
+  _commandRecorder.init(jobSystem);
+
+  _occluderCandidates.reserve(256);
 
   _uboCamera = UBO::Create(
       UBO_CAMERA_IDX,
@@ -63,16 +145,7 @@ void Renderer::init(int width, int height) {
         UBO::newVec(3)  // - specular
       }),
       UBO::newScalar(), // Number of point lights
-      UBO::newArray(MaxPointLights, UBO::newStruct({  // Point Lights Array
-          UBO::newVec(3), // - position
-          UBO::newVec(3), // - ambient
-          UBO::newVec(3), // - diffuse
-          UBO::newVec(3), // - specular
-          UBO::newScalar(), // - attenuation constant
-          UBO::newScalar(), // - attenuation linear
-          UBO::newScalar(), // - attenuation quadratic
-        })
-      )
+      UBO::newVec(4),   // Cluster params (point lights live in LightClusters buffers)
       }
   );
 
@@ -85,6 +158,7 @@ void Renderer::init(int width, int height) {
     { glm::vec3(-0.5f,  0.5f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec2(0.0f, 1.0f) },
     { glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec2(0.0f, 0.0f) },
   };
+  quadParams.buildPositionStream = false;
   _screenDebugQuad = Mesh::Create(quadParams);
 
   ShaderCreateParams params;
@@ -99,11 +173,21 @@ void Renderer::init(int width, int height) {
   params.fragmentShaderPath = "shaders/shadowmap_depth.frag";
   _shadowmapShader = Shader::Create(params);
 
+  params.name = "depth_prepass";
+  params.vertexShaderPath = "shaders/depth_prepass.vert";
+  params.fragmentShaderPath = "shaders/shadowmap_depth.frag";
+  _depthPrepassShader = Shader::Create(params);
+
   params.name = "screen_quad_depth";
   params.vertexShaderPath = "shaders/screen_quad_depth.vert";
   params.fragmentShaderPath = "shaders/screen_quad_depth.frag";
   _screenQuadDepthShader = Shader::Create(params);
 
+  params.name = "deferred_lighting";
+  params.vertexShaderPath = "shaders/deferred_lighting.vert";
+  params.fragmentShaderPath = "shaders/deferred_lighting.frag";
+  _deferredLightingShader = Shader::Create(params);
+
   _mainLight.position = glm::vec3(20.0f, 30.0f, 100.0f);
   _mainLight.properties.color = ColorRGB(0.6f);
   _mainLight.properties.ambientMultiplier = 0.2f;
@@ -120,95 +204,101 @@ void Renderer::init(int width, int height) {
 void Renderer::setViewport(int width, int height) {
   const float aspectRatio = (float)width / (float)height;
 
-  _viewportWidth = width;
-  _viewportHeight = height;
+  _settings.viewportWidth = width;
+  _settings.viewportHeight = height;
   _viewCamera.setViewport(width, height);
   _viewCamera.setAspectRatio(aspectRatio);
 }
 
 void Renderer::toggleWireframe() {
-  _wireframeEnabled = !_wireframeEnabled;
-  if (_wireframeEnabled) {
-    glDisable(GL_CULL_FACE);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-  }
-  else {
-    glEnable(GL_CULL_FACE);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  }
+  _settings.wireframe = !_settings.wireframe;
 }
 
 void Renderer::toggleDebug() {
-  _debugEnabled = !_debugEnabled;
+  _settings.debug = !_settings.debug;
 }
 
-void Renderer::drawText(const std::string& text, const glm::vec3& position, const ColorRGB& color, bool center, float scale) {
-  float xOffset = 0.0f;
-
-  glm::vec2 viewport = _viewCamera.getViewport();
-  glm::vec3 screenPos = _viewCamera.worldToScreenCoordinates(position);
+void Renderer::toggleMultiDraw() {
+  _settings.multiDraw = _multiDrawSupported && !_settings.multiDraw;
+}
 
-  const bool visible = fabsf(screenPos.z) <= 1.0f
-    && (screenPos.x > -20.0f && screenPos.x < viewport.x + 20.0f)
-    && (screenPos.y > -20.0f && screenPos.y < viewport.y + 20.0f);
+void Renderer::toggleGPUCulling() {
+  _settings.gpuCulling = _gpuScene.isSupported() && !_settings.gpuCulling;
+}
 
-  if (!visible) return;
+void Renderer::toggleOcclusionCulling() {
+  _settings.occlusionCulling = !_settings.occlusionCulling;
+}
 
-  if (center) {
-    float width = 0.0f;
+void Renderer::toggleDepthPrepass() {
+  _settings.depthPrepass = !_settings.depthPrepass;
+}
 
-    for (size_t i = 0; i < text.length(); ++i) {
-      const unsigned char c = text.at(i);
-      auto charInfo = _font->getCharacterInfo(c);
+void Renderer::drawText(const std::string& text, const glm::vec3& position, const ColorRGB& color, bool center, float scale) {
+  if (text.empty())
+    return;
 
-      width += charInfo ? charInfo->advance.x * scale : 0.0f;
-    }
+  // Layout comes from the cache, only the anchor changes from frame to frame
+  const TextRun& run = _textCache.getRun(*_font, text, scale);
+  _frames[_submitIndex].textDraws.push_back({ &run, position, color, center });
+}
 
-    screenPos.x -= (width * 0.5f);
+void Renderer::drawLight(const Light& light) {
+  auto& lightsList = _frames[_submitIndex].lightsList;
+  if (lightsList.size() < MaxPointLights) {
+    lightsList.push_back(light);
   }
+}
+
+void Renderer::drawMesh(const MeshRef& mesh, const MaterialRef& material, const glm::mat4& worldTM, uint32_t drawFlags) {
+  RenderItem item;
+  item.mesh = mesh.get();
+  item.material = material.get();
+  item.modelTM = worldTM;
+  item.flags = drawFlags;
+
+  auto& frame = _frames[_submitIndex];
+  addRenderItem(frame.mainPassList, frame.shadowPassList, item);
+}
 
-  for (size_t i = 0; i < text.size(); ++i) {
-    const unsigned char c = text.at(i);
-    auto charInfo = _font->getCharacterInfo(c);
+RenderObjectId Renderer::createRenderObject(MeshRef mesh, MaterialRef material, const glm::mat4& worldTM, uint32_t drawFlags) {
+  std::lock_guard<std::mutex> lock(_gpuSceneMutex);
+  return _gpuScene.createObject(mesh, material, worldTM, drawFlags);
+}
 
-    if (charInfo) {
-      const float xpos = xOffset + screenPos.x + (charInfo->bearing.x * scale);
-      const float ypos = screenPos.y - (charInfo->size.y - (charInfo->bearing.y * scale));
-      const float zpos = screenPos.z;
+void Renderer::updateRenderObject(RenderObjectId id, const glm::mat4& worldTM) {
+  _frames[_submitIndex].objectOps.push_back({ id, worldTM, false });
+}
 
-      const float w = charInfo->size.x * scale;
-      const float h = charInfo->size.y * scale;
-      const auto& offsets = charInfo->atlasOffsets;
+void Renderer::destroyRenderObject(RenderObjectId id) {
+  _frames[_submitIndex].objectOps.push_back({ id, glm::mat4(1.0f), true });
+}
 
-      _textVertices.push_back({ glm::vec3(xpos, ypos + h, zpos),     glm::vec2(offsets[0], 0.0f), color });
-      _textVertices.push_back({ glm::vec3(xpos, ypos, zpos),         glm::vec2(offsets[0], 1.0f), color });
-      _textVertices.push_back({ glm::vec3(xpos + w, ypos, zpos),     glm::vec2(offsets[1], 1.0f), color });
-      _textVertices.push_back({ glm::vec3(xpos, ypos + h, zpos),     glm::vec2(offsets[0], 0.0f), color });
-      _textVertices.push_back({ glm::vec3(xpos + w, ypos, zpos),     glm::vec2(offsets[1], 1.0f), color });
-      _textVertices.push_back({ glm::vec3(xpos + w, ypos + h, zpos), glm::vec2(offsets[1], 0.0f), color });
+/*static*/ void Renderer::addRenderItem(RenderList& mainList, RenderList& shadowList, const RenderItem& item) {
+  mainList.push_back(item);
 
-      xOffset += (charInfo->advance.x * scale);
-    }
+  if ((item.flags & DrawFlags_Shadow) != 0) {
+    shadowList.push_back(item);
   }
 }
 
-void Renderer::drawLight(const Light& light) {
-  if (_lightsList.size() < MaxPointLights) {
-    _lightsList.push_back(light);
-  }
+void Renderer::setFrameLatency(uint32_t latency) {
+  _frameCount = std::min(latency, (uint32_t)MaxFrameLatency) + 1;
+  _submitIndex = 0;
+  _renderIndex = 0;
 }
 
-void Renderer::drawMesh(MeshRef mesh, MaterialRef material, const glm::mat4& worldTM, uint32_t drawFlags) {
-  RenderItem item;
-  item.mesh = mesh;
-  item.material = material;
-  item.modelTM = worldTM;
+void Renderer::captureScreen() {
+  _captureRequested = true;
+}
 
-  _mainPassList.push_back(item);
+void Renderer::startRecording(uint32_t interval, FrameRecorder::Format format) {
+  _settings.recordInterval = std::max(interval, 1u);
+  _settings.recordFormat = format;
+}
 
-  if ((drawFlags & DrawFlags_Shadow) != 0) {
-    _shadowPassList.push_back(item);
-  }
+void Renderer::stopRecording() {
+  _settings.recordInterval = 0;
 }
 
 void Renderer::beginFrame() {
@@ -216,93 +306,379 @@ void Renderer::beginFrame() {
   ImGui_ImplSDL2_NewFrame();
   ImGui::NewFrame();
 
-  _mainPassList.clear();
-  _shadowPassList.clear();
-  _lightsList.clear();
-  _textVertices.clear();
+  {
+    std::lock_guard<std::mutex> lock(_publishMutex);
+    _frameStats = _publishedStats;
+    _framePassTimings = _publishedPassTimings;
+    _framePooledTargets = _publishedPooledTargets;
+  }
+
+  ResourcePools::beginFrame();
+
+  // The render side is done with this slot, its lists start over in the same memory
+  auto& frame = _frames[_submitIndex];
+  frame.resourceFrame = ResourcePools::getSubmitFrame();
+  frame.allocator.reset();
+  frame.mainPassList.reset();
+  frame.shadowPassList.reset();
+  frame.lightsList.reset();
+  frame.textDraws.reset();
+  frame.glyphs.reset();
+  frame.glyphUploads.reset();
+  frame.objectOps.reset();
 }
 
 void Renderer::endFrame() {
+  auto& frame = _frames[_submitIndex];
+  _submitIndex = (_submitIndex + 1) % _frameCount;
+
+  emitText(frame);
+
+  frame.camera = _viewCamera;
+  frame.mainLight = _mainLight;
+  frame.settings = _settings;
+  frame.captureScreen = _captureRequested;
+  _captureRequested = false;
+
+  // ImGui reuses its draw lists on the next NewFrame, the render side gets its own copies
+  ImGui::Render();
+  const ImDrawData* drawData = ImGui::GetDrawData();
+  for (int i = 0; i < drawData->CmdListsCount; ++i) {
+    frame.guiDrawLists.push_back(drawData->CmdLists[i]->CloneOutput());
+  }
+  frame.guiDisplayPos = glm::vec2(drawData->DisplayPos.x, drawData->DisplayPos.y);
+  frame.guiDisplaySize = glm::vec2(drawData->DisplaySize.x, drawData->DisplaySize.y);
+  frame.guiFramebufferScale = glm::vec2(drawData->FramebufferScale.x, drawData->FramebufferScale.y);
+}
+
+void Renderer::emitText(FrameData& frame) {
+  const uint32_t count = frame.textDraws.size();
+
+  if (count > 0) {
+    glm::vec3* anchors = frame.allocator.allocate<glm::vec3>(count);
+    glm::vec3* screenPositions = frame.allocator.allocate<glm::vec3>(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      anchors[i] = frame.textDraws[i].position;
+    }
+
+    const glm::vec2& viewport = _viewCamera.getViewport();
+    SimdMath::projectPoints(_viewCamera.getViewProjection(), glm::vec4(0.0f, 0.0f, viewport.x, viewport.y), anchors, screenPositions, count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      const TextDraw& draw = frame.textDraws[i];
+      glm::vec3 screenPos = screenPositions[i];
+
+      const bool visible = fabsf(screenPos.z) <= 1.0f
+        && (screenPos.x > -20.0f && screenPos.x < viewport.x + 20.0f)
+        && (screenPos.y > -20.0f && screenPos.y < viewport.y + 20.0f);
+
+      if (!visible)
+        continue;
+
+      if (draw.center) {
+        screenPos.x -= draw.run->width * 0.5f;
+      }
+
+      const uint8_t color[4] = {
+        GlyphInstance::PackUnorm8(draw.color.r), GlyphInstance::PackUnorm8(draw.color.g), GlyphInstance::PackUnorm8(draw.color.b), 255
+      };
+
+      for (const GlyphInstance& runGlyph : draw.run->glyphs) {
+        GlyphInstance glyph = runGlyph;
+        glyph.position += screenPos;
+        memcpy(glyph.color, color, sizeof(color));
+        frame.glyphs.push_back(glyph);
+      }
+    }
+  }
+
+  // Runs are only referenced until here
+  frame.textRuns = _textCache.getRunCount();
+  frame.textLayouts = _textCache.getLayoutCount();
+  frame.atlasGlyphs = _font->getGlyphCount();
+  _textCache.endFrame();
+  _font->endFrame(frame.allocator, frame.glyphUploads);
+}
+
+void Renderer::renderFrame() {
+  auto& frame = _frames[_renderIndex];
+  _renderIndex = (_renderIndex + 1) % _frameCount;
+
+  applySettings(frame.settings);
+  _renderCamera = frame.camera;
+  _renderMainLight = frame.mainLight;
+  // Views of the frame lists, retained objects are appended to them in the frame allocator
+  _mainPassList = frame.mainPassList;
+  _shadowPassList = frame.shadowPassList;
+  _lightsList = frame.lightsList;
+  _glyphs = frame.glyphs;
+
   _stats.reset();
+  _stats.glyphs = _glyphs.size();
+  _stats.textRuns = frame.textRuns;
+  _stats.textLayouts = frame.textLayouts;
+  _stats.atlasGlyphs = frame.atlasGlyphs;
+  _stats.atlasUploads = frame.glyphUploads.size();
+  _stats.streamStalls = _textBuffer->getStream().getStallCount();
+  _stats.streamPersistent = _textBuffer->getStream().isPersistent();
+
+  // Glyphs loaded while this frame was submitted, frames before it are done with the replaced ones
+  _font->applyUploads(frame.glyphUploads.data(), frame.glyphUploads.size());
 
   // Prepare UBOs
   _uboCamera->writeBegin();
-  _uboCamera->writeVec3(_viewCamera.getPosition());
-  _uboCamera->writeVec2(_viewCamera.getViewport());
-  _uboCamera->writeMat4(_viewCamera.getView());
-  _uboCamera->writeMat4(_viewCamera.getProjection());
-  _uboCamera->writeMat4(_viewCamera.getViewProjection());
-  _uboCamera->writeMat4(glm::mat4(glm::mat3(_viewCamera.getView())));
+  _uboCamera->writeVec3(_renderCamera.getPosition());
+  _uboCamera->writeVec2(_renderCamera.getViewport());
+  _uboCamera->writeMat4(_renderCamera.getView());
+  _uboCamera->writeMat4(_renderCamera.getProjection());
+  _uboCamera->writeMat4(_renderCamera.getViewProjection());
+  _uboCamera->writeMat4(glm::mat4(glm::mat3(_renderCamera.getView())));
   _uboCamera->writeEnd();
 
   _uboLights->writeBegin();
-  _uboLights->writeVec3(-glm::normalize(_mainLight.position));
-  _uboLights->writeVec3(_mainLight.properties.color * _mainLight.properties.ambientMultiplier);
-  _uboLights->writeVec3(_mainLight.properties.color);
-  _uboLights->writeVec3(_mainLight.properties.color * _mainLight.properties.specularMultiplier);
-
-  _uboLights->writeInt((int)_lightsList.size());
-  for (auto& light : _lightsList) {
-    _uboLights->writeVec3(light.position);
-    _uboLights->writeVec3(light.properties.color * light.properties.ambientMultiplier);
-    _uboLights->writeVec3(light.properties.color);
-    _uboLights->writeVec3(light.properties.color * light.properties.specularMultiplier);
-    _uboLights->writeFloat(light.properties.attenuationConstant);
-    _uboLights->writeFloat(light.properties.attenuationLinear);
-    _uboLights->writeFloat(light.properties.attenuationQuadratic);
-  }
+  _uboLights->writeVec3(-glm::normalize(_renderMainLight.position));
+  _uboLights->writeVec3(_renderMainLight.properties.color * _renderMainLight.properties.ambientMultiplier);
+  _uboLights->writeVec3(_renderMainLight.properties.color);
+  _uboLights->writeVec3(_renderMainLight.properties.color * _renderMainLight.properties.specularMultiplier);
+
+  _lightClusters.build(_lightsList.data(), _lightsList.size(), _renderCamera);
+  _lightClusters.bind(POINT_LIGHTS_TEXTURE_SLOT, LIGHT_CLUSTERS_TEXTURE_SLOT, LIGHT_INDICES_TEXTURE_SLOT);
+
+  _uboLights->writeInt((int)_lightClusters.getLightCount());
+  _uboLights->writeVec4(_lightClusters.getParams());
   _uboLights->writeEnd();
 
   uint32_t drawcalls = 0;
   uint32_t drawcallsShadows = 0;
+  uint32_t drawcallsPrepass = 0;
 
-  // Shadow pass
   // TODO: Fit light projection to camera view frustum
   auto lightProj = glm::ortho(-20.0f, 20.0f, -20.0f, 20.0f, -20.0f, 20.0f);
-  auto lightView = glm::lookAt(glm::normalize(_mainLight.position), glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
+  auto lightView = glm::lookAt(glm::normalize(_renderMainLight.position), glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
   auto lightViewProj = lightProj * lightView;
 
-  glBindFramebuffer(GL_FRAMEBUFFER, _fboShadowmap->id());
-  glViewport(0, 0, _fboShadowmap->width(), _fboShadowmap->height());
-  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-  glClear(GL_DEPTH_BUFFER_BIT);
+  const Frustum viewFrustum = Frustum::FromMatrix(_renderCamera.getViewProjection());
+  const Frustum shadowFrustum = Frustum::FromMatrix(lightViewProj);
 
-  _shadowmapShader->use();
-  _shadowmapShader->setUniformMatrix4("mtx_light_vp", lightViewProj);
+  // Retained objects are culled by a compute pass, or go through the per-frame lists otherwise
+  const bool gpuCulling = _gpuCullingEnabled && _multiDrawEnabled;
+  {
+    std::lock_guard<std::mutex> lock(_gpuSceneMutex);
+    for (const auto& op : frame.objectOps) {
+      if (op.destroy) {
+        _gpuScene.destroyObject(op.id);
+      }
+      else {
+        _gpuScene.updateObject(op.id, op.worldTM);
+      }
+    }
 
-  for (auto item : _shadowPassList) {
-    _shadowmapShader->setUniformMatrix4("mtx_model", item.modelTM);
-    item.mesh->draw();
+    if (gpuCulling) {
+      _gpuScene.prepare();
+      _gpuScene.cull(viewFrustum, shadowFrustum);
+    }
+    else {
+      _gpuScene.forEachObject([this](const MeshRef& mesh, const MaterialRef& material, const glm::mat4& worldTM, uint32_t drawFlags) {
+        addRenderItem(_mainPassList, _shadowPassList, { mesh.get(), material.get(), worldTM, drawFlags });
+      });
+    }
 
-    drawcallsShadows++;
+    _stats.renderObjects = _gpuScene.getObjectCount();
   }
 
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  // Hi-Z pyramid from the biggest occluders, tested by the main pass items
+  if (_occlusionCullingEnabled) {
+    renderOccluders(viewFrustum);
+  }
 
-  // Main pass
-  glViewport(0, 0, _viewportWidth, _viewportHeight);
-  glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-  glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_TEXTURE_SLOT);
-  glBindTexture(GL_TEXTURE_2D, _fboShadowmap->depthAttachment());
-
-  for (auto item : _mainPassList) {
-    auto shader = item.material->getShader();
-    shader->use();
-    shader->setUniformBlockBind("Camera", UBO_CAMERA_IDX);
-    shader->setUniformBlockBind("Lights", UBO_LIGHTS_IDX);
-    shader->setUniformInt("shadow_depth_map", SHADOW_MAP_TEXTURE_SLOT);
-    shader->setUniformMatrix4("mtx_model", item.modelTM);
-    shader->setUniformMatrix4("mtx_light_vp", lightViewProj);
-    item.material->apply();
-    item.mesh->draw();
+  // Culling, keys and object lights are recorded on worker threads, then flattened into per-draw data and
+  // indirect commands for all passes, uploaded once
+  std::array<uint32_t, CommandRecorder::MaxPasses> itemCounts = {};
+  itemCounts[(uint32_t)PassType::Shadow] = (uint32_t)_shadowPassList.size();
+  itemCounts[(uint32_t)PassType::DepthPrepass] = isDepthPrepassActive() ? (uint32_t)_mainPassList.size() : 0;
+  itemCounts[(uint32_t)PassType::Main] = (uint32_t)_mainPassList.size();
+
+  _commandRecorder.record(itemCounts, [&](uint32_t pass, uint32_t begin, uint32_t end, LinearAllocator& allocator, CommandRecorder::TaskOutput& output) {
+    const PassType passType = (PassType)pass;
+    recordCommands(passType, passType == PassType::Shadow ? shadowFrustum : viewFrustum, begin, end, allocator, output);
+  });
+
+  _drawTransforms.clear();
+  _drawLights.clear();
+  _drawCommands.clear();
+  buildDrawBatches(_shadowPassList, _commandRecorder.getPackets((uint32_t)PassType::Shadow), PassType::Shadow, _shadowPassBatches);
+  buildDrawBatches(_mainPassList, _commandRecorder.getPackets((uint32_t)PassType::DepthPrepass), PassType::DepthPrepass, _depthPrepassBatches);
+  buildDrawBatches(_mainPassList, _commandRecorder.getPackets((uint32_t)PassType::Main), PassType::Main, _mainPassBatches);
+
+  _stats.culledItems = _commandRecorder.getCulled((uint32_t)PassType::Shadow) + _commandRecorder.getCulled((uint32_t)PassType::Main);
+  _stats.occludedItems = _commandRecorder.getOccluded((uint32_t)PassType::Main);
+  _stats.objectLights = _commandRecorder.getObjectLights((uint32_t)PassType::Main);
+  _stats.recordThreads = _commandRecorder.getLastThreadCount();
+
+  _drawTransformsBuffer->uploadData(_drawTransforms.data(), sizeof(glm::mat4) * _drawTransforms.size());
+  if (_lightAssignment == LightAssignment::PerObject) {
+    _drawLightsBuffer->uploadData(_drawLights.data(), sizeof(glm::uvec4) * _drawLights.size());
+  }
+  if (_multiDrawEnabled) {
+    _drawCommandsBuffer->uploadData(_drawCommands.data(), sizeof(DrawElementsIndirectCommand) * _drawCommands.size());
+  }
+  bindDrawData();
+
+  // Passes are declared in submission order, the graph drops the ones nothing consumes
+  _renderGraph.beginFrame(_viewportWidth, _viewportHeight);
+
+  FBOSpec shadowmapSpec;
+  shadowmapSpec.height = SHADOW_MAP_HEIGHT;
+  shadowmapSpec.width = SHADOW_MAP_WIDTH;
+  shadowmapSpec.type = FBOType::Shadowmap;
+  const auto shadowMap = _renderGraph.createTarget("ShadowMap", shadowmapSpec);
+
+  FBOSpec gbufferSpec;
+  gbufferSpec.height = _viewportHeight;
+  gbufferSpec.width = _viewportWidth;
+  gbufferSpec.type = FBOType::GBuffer;
+  const auto gbuffer = _renderGraph.createTarget("GBuffer", gbufferSpec);
 
+  // Shadow pass
+  _renderGraph.addPass("Shadow", [&](RenderGraph& graph) {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    _shadowmapShader->use();
+    _shadowmapShader->setUniformMatrix4("mtx_light_vp", lightViewProj);
+    _shadowmapShader->setUniformInt("draw_transforms", DRAW_TRANSFORMS_TEXTURE_SLOT);
+
+    for (auto& batch : _shadowPassBatches) {
+      drawcallsShadows += submitDrawBatch(*_shadowmapShader, batch);
+    }
+
+    if (gpuCulling && !_gpuScene.getShadowBatches().empty()) {
+      _gpuScene.bindDrawData(DRAW_TRANSFORMS_TEXTURE_SLOT);
+      for (auto& batch : _gpuScene.getShadowBatches()) {
+        drawcallsShadows += submitCulledBatch(*_shadowmapShader, batch);
+      }
+      bindDrawData();
+    }
+  }).write(shadowMap);
+
+  _renderGraph.addPass("Clear", [&](RenderGraph& graph) {
+    glClearColor(_clearColor.r, _clearColor.g, _clearColor.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }).write(RenderGraph::Backbuffer);
+
+  // Depth pre-pass, the main pass then only shades visible fragments
+  _renderGraph.addPass("DepthPrepass", [&](RenderGraph& graph) {
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    _depthPrepassShader->use();
+    _depthPrepassShader->setUniformBlockBind("Camera", UBO_CAMERA_IDX);
+    _depthPrepassShader->setUniformInt("draw_transforms", DRAW_TRANSFORMS_TEXTURE_SLOT);
+
+    for (auto& batch : _depthPrepassBatches) {
+      drawcallsPrepass += submitDrawBatch(*_depthPrepassShader, batch);
+    }
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  }).write(RenderGraph::Backbuffer).setEnabled(isDepthPrepassActive());
+
+  // Deferred: G-buffer geometry pass and screen lighting pass, the remaining materials are drawn forward on top
+  _renderGraph.addPass("GBuffer", [&](RenderGraph& graph) {
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    Shader* currentShader = nullptr;
+    for (auto& batch : _mainPassBatches) {
+      if (!isDeferred(*batch.material))
+        continue;
+
+      auto& shader = *batch.material->getShader()->getGBufferVariant();
+      if (currentShader != &shader) {
+        bindMainPassShader(shader, lightViewProj, false);
+        currentShader = &shader;
+      }
+
+      batch.material->apply(shader);
+      drawcalls += submitDrawBatch(shader, batch);
+      _stats.deferredItems += batch.commandCount;
+    }
+
+    if (gpuCulling && !_gpuScene.getMainBatches().empty()) {
+      _gpuScene.bindDrawData(DRAW_TRANSFORMS_TEXTURE_SLOT);
+
+      currentShader = nullptr;
+      for (auto& batch : _gpuScene.getMainBatches()) {
+        if (!isDeferred(*batch.material))
+          continue;
+
+        auto& shader = *batch.material->getShader()->getGBufferVariant();
+        if (currentShader != &shader) {
+          bindMainPassShader(shader, lightViewProj, false);
+          currentShader = &shader;
+        }
+
+        batch.material->apply(shader);
+        drawcalls += submitCulledBatch(shader, batch);
+      }
+      bindDrawData();
+    }
+  }).write(gbuffer);
+
+  _renderGraph.addPass("DeferredLighting", [&](RenderGraph& graph) {
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_TEXTURE_SLOT);
+    glBindTexture(GL_TEXTURE_2D, graph.getTarget(shadowMap)->depthAttachment());
+
+    renderDeferredLighting(*graph.getTarget(gbuffer), lightViewProj);
     drawcalls++;
-  }
+  }).read(gbuffer).read(shadowMap).write(RenderGraph::Backbuffer).setEnabled(_renderPath == RenderPath::Deferred);
+
+  // Main pass
+  _renderGraph.addPass("Main", [&](RenderGraph& graph) {
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_TEXTURE_SLOT);
+    glBindTexture(GL_TEXTURE_2D, graph.getTarget(shadowMap)->depthAttachment());
+
+    Shader* currentShader = nullptr;
+    for (auto& batch : _mainPassBatches) {
+      if (isDeferred(*batch.material))
+        continue;
+
+      auto& shader = *batch.material->getShader();
+
+      if (currentShader != &shader) {
+        bindMainPassShader(shader, lightViewProj, _lightAssignment == LightAssignment::PerObject);
+        currentShader = &shader;
+      }
+
+      setDepthEqual(batch.depthPrepassed);
+      batch.material->apply();
+      drawcalls += submitDrawBatch(shader, batch);
+    }
+    setDepthEqual(false);
+
+    if (gpuCulling && !_gpuScene.getMainBatches().empty()) {
+      _gpuScene.bindDrawData(DRAW_TRANSFORMS_TEXTURE_SLOT);
+
+      currentShader = nullptr;
+      for (auto& batch : _gpuScene.getMainBatches()) {
+        if (isDeferred(*batch.material))
+          continue;
+
+        auto& shader = *batch.material->getShader();
+
+        // Light lists are indexed by render list draws, culled objects use the clusters
+        if (currentShader != &shader) {
+          bindMainPassShader(shader, lightViewProj, false);
+          currentShader = &shader;
+        }
+
+        batch.material->apply();
+        drawcalls += submitCulledBatch(shader, batch);
+      }
+      bindDrawData();
+    }
+  }).read(shadowMap).write(RenderGraph::Backbuffer);
 
   // Render text
-  if (_textVertices.size() > 0) {
+  _renderGraph.addPass("Text", [&](RenderGraph& graph) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -310,14 +686,14 @@ void Renderer::endFrame() {
     glBindTexture(GL_TEXTURE_2D, _font->id());
     _textShader->use();
     _textShader->setUniformInt("texture_font", 0);
-    drawcalls += _textBuffer->draw(_textVertices);
+    drawcalls += _textBuffer->draw(_glyphs.data(), _glyphs.size());
 
     glDisable(GL_BLEND);
-  }
+  }).write(RenderGraph::Backbuffer).setEnabled(!_glyphs.empty());
 
-  if (_debugEnabled) {
+  _renderGraph.addPass("DebugShadowmap", [&](RenderGraph& graph) {
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _fboShadowmap->depthAttachment());
+    glBindTexture(GL_TEXTURE_2D, graph.getTarget(shadowMap)->depthAttachment());
     _screenQuadDepthShader->use();
     _screenQuadDepthShader->setUniformMatrix4(
       "mtx_model",
@@ -325,30 +701,424 @@ void Renderer::endFrame() {
     );
     _screenQuadDepthShader->setUniformInt("depth_map", 0);
     _screenDebugQuad->draw();
-  }
+  }).read(shadowMap).write(RenderGraph::Backbuffer).setEnabled(_debugEnabled);
 
-  ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  _renderGraph.addPass("ImGui", [&](RenderGraph& graph) {
+    renderGUI(frame);
+  }).write(RenderGraph::Backbuffer);
 
-  _stats.pointlights = _lightsList.size();
+  _renderGraph.execute();
+
+  _stats.pointlights = _lightClusters.getLightCount();
+  _stats.lightIndices = _lightClusters.getIndexCount();
   _stats.drawcalls = drawcalls;
   _stats.drawcallsShadows = drawcallsShadows;
+  _stats.drawcallsPrepass = drawcallsPrepass;
+  _stats.gpuShadowMs = _renderGraph.getGpuMs("Shadow");
+  _stats.gpuPrepassMs = _renderGraph.getGpuMs("DepthPrepass");
+  _stats.gpuMainMs = _renderGraph.getGpuMs("GBuffer") + _renderGraph.getGpuMs("DeferredLighting") + _renderGraph.getGpuMs("Main");
+  _stats.drawItems = _drawCommands.size();
+
+  // Retried next frame while both readbacks are in flight
+  _screenshotPending |= frame.captureScreen;
+  if (_screenshotPending && _screenshotReadback->request(_viewportWidth, _viewportHeight, time(NULL))) {
+    _screenshotPending = false;
+  }
+  saveScreenshots(false);
+  _frameRecorder.captureFrame(_viewportWidth, _viewportHeight);
+
+  _stats.recordedFrames = _frameRecorder.getCapturedCount();
+  _stats.recordFps = _frameRecorder.isRecording() ? _frameRecorder.getCapturedFps() : 0.0f;
+  _stats.recordWaitMs = _frameRecorder.getWaitMs();
+  _stats.recordDropped = _frameRecorder.getDroppedCount();
+
+  {
+    std::lock_guard<std::mutex> lock(_publishMutex);
+    _publishedStats = _stats;
+    _publishedPassTimings = _renderGraph.getTimings();
+    _publishedPooledTargets = _renderGraph.getPooledTargetCount();
+  }
+
+  _mainPassList = RenderList();
+  _shadowPassList = RenderList();
+  _lightsList = LightsList();
+  _glyphs = LinearArray<GlyphInstance>();
+
+  ResourcePools::collect(frame.resourceFrame);
 
   GL_CHECK_ERROR();
 }
 
-void Renderer::captureScreen() {
-  ImageData img;
-  img.width = _viewportWidth;
-  img.height = _viewportHeight;
-  img.bytesPerPixel = 3; // RGB
-  img.data.resize(_viewportHeight*_viewportWidth*3);
+void Renderer::applySettings(const Settings& settings) {
+  if (settings.wireframe != _wireframeEnabled) {
+    if (settings.wireframe) {
+      glDisable(GL_CULL_FACE);
+      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+    else {
+      glEnable(GL_CULL_FACE);
+      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+  }
+
+  _clearColor = settings.clearColor;
+  _viewportWidth = settings.viewportWidth;
+  _viewportHeight = settings.viewportHeight;
+  _wireframeEnabled = settings.wireframe;
+  _debugEnabled = settings.debug;
+  _multiDrawEnabled = settings.multiDraw;
+  _gpuCullingEnabled = settings.gpuCulling;
+  _occlusionCullingEnabled = settings.occlusionCulling;
+  _depthPrepassEnabled = settings.depthPrepass;
+  _lightAssignment = settings.lightAssignment;
+  _renderPath = settings.renderPath;
+
+  if (settings.recordInterval != _recordInterval || settings.recordFormat != _recordFormat) {
+    if (settings.recordInterval > 0) {
+      _frameRecorder.start(settings.recordInterval, settings.recordFormat);
+    }
+    else {
+      _frameRecorder.stop();
+    }
+
+    _recordInterval = settings.recordInterval;
+    _recordFormat = settings.recordFormat;
+  }
+}
+
+void Renderer::renderGUI(FrameData& frame) {
+  ImDrawData drawData;
+  drawData.Valid = true;
+  drawData.CmdLists = frame.guiDrawLists.data();
+  drawData.CmdListsCount = (int)frame.guiDrawLists.size();
+  drawData.DisplayPos = ImVec2(frame.guiDisplayPos.x, frame.guiDisplayPos.y);
+  drawData.DisplaySize = ImVec2(frame.guiDisplaySize.x, frame.guiDisplaySize.y);
+  drawData.FramebufferScale = ImVec2(frame.guiFramebufferScale.x, frame.guiFramebufferScale.y);
+  for (auto list : frame.guiDrawLists) {
+    drawData.TotalVtxCount += list->VtxBuffer.Size;
+    drawData.TotalIdxCount += list->IdxBuffer.Size;
+  }
+
+  ImGui_ImplOpenGL3_RenderDrawData(&drawData);
+  VAO::invalidateBindCache();
+
+  for (auto list : frame.guiDrawLists) {
+    IM_DELETE(list);
+  }
+  frame.guiDrawLists.clear();
+}
+
+void Renderer::renderOccluders(const Frustum& frustum) {
+  // Biggest items on screen, estimated by bounding radius over distance to the camera
+  const glm::vec3 cameraPosition = _renderCamera.getPosition();
+
+  _occluderCandidates.clear();
+  for (uint32_t i = 0; i < _mainPassList.size(); ++i) {
+    const auto& item = _mainPassList[i];
+    if ((item.flags & DrawFlags_NoCulling) != 0)
+      continue;
+
+    const AABB bounds = item.mesh->getBounds().transform(item.modelTM);
+    if (!frustum.intersects(bounds))
+      continue;
+
+    const float radius = glm::length(bounds.extents());
+    const float distance = std::max(glm::distance(cameraPosition, bounds.center()), 0.1f);
+    const float screenSize = radius / distance;
+
+    if (screenSize >= OCCLUDER_MIN_SCREEN_SIZE) {
+      _occluderCandidates.push_back({ screenSize, i });
+    }
+  }
+
+  const size_t occluderCount = std::min(_occluderCandidates.size(), (size_t)OcclusionCuller::MaxOccluders);
+  std::partial_sort(
+    _occluderCandidates.begin(),
+    _occluderCandidates.begin() + occluderCount,
+    _occluderCandidates.end(),
+    [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; }
+  );
+
+  const glm::vec2& viewport = _renderCamera.getViewport();
+  _occlusionCuller.begin(_renderCamera.getViewProjection(), viewport.x / viewport.y);
+
+  for (size_t i = 0; i < occluderCount; ++i) {
+    const auto& item = _mainPassList[_occluderCandidates[i].second];
+    const bool positionOnly = item.mesh->hasPositionStream();
+
+    _occlusionCuller.drawOccluder(positionOnly ? item.mesh->getPositionGeometry() : item.mesh->getGeometry(), item.modelTM);
+  }
+
+  _occlusionCuller.end();
+  _stats.occluders = _occlusionCuller.getOccluderCount();
+}
+
+void Renderer::recordCommands(PassType pass, const Frustum& frustum, uint32_t begin, uint32_t end, LinearAllocator& allocator, CommandRecorder::TaskOutput& output) const {
+  // Runs on recorder workers, only reads renderer state
+  const RenderList& list = (pass == PassType::Shadow) ? _shadowPassList : _mainPassList;
+  const bool depthOnly = (pass != PassType::Main);
+  const bool objectLights = (pass == PassType::Main) && _lightAssignment == LightAssignment::PerObject;
+
+  // World bounds of the whole range first, the frustum test runs as one batch
+  const uint32_t count = end - begin;
+  AABB* bounds = allocator.allocate<AABB>(count);
+  uint8_t* inFrustum = allocator.allocate<uint8_t>(count);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto& item = list[begin + i];
+    bounds[i] = (item.flags & DrawFlags_NoCulling) == 0 ? item.mesh->getBounds().transform(item.modelTM) : AABB();
+  }
+  SimdMath::testAABBs(frustum, bounds, count, inFrustum);
+
+  for (uint32_t i = begin; i < end; ++i) {
+    const auto& item = list[i];
+    const auto& geometry = geometryFor(item, depthOnly);
+    if (!geometry.valid())
+      continue;
+
+    if (pass == PassType::DepthPrepass && !item.mesh->hasPositionStream())
+      continue;
+
+    const bool cullable = (item.flags & DrawFlags_NoCulling) == 0;
+    const AABB& itemBounds = bounds[i - begin];
+
+    if (cullable) {
+      if (!inFrustum[i - begin]) {
+        output.culled++;
+        continue;
+      }
+
+      if (pass != PassType::Shadow && _occlusionCullingEnabled && !_occlusionCuller.isVisible(itemBounds)) {
+        output.occluded++;
+        continue;
+      }
+    }
+
+    // Items sharing shader, material and geometry buffer end up adjacent, pre-passed items first
+    uint64_t key = (uint64_t)(geometry.buffer->id() & 0xFFFF) << 16;
+    if (!depthOnly) {
+      const uint64_t late = isPrepassed(item) ? 0 : 1;
+      key |= (late << 63)
+        | ((uint64_t)(item.material->getShader()->id() & 0x7FFF) << 48)
+        | ((uint64_t)(item.material->getSortId() & 0xFFFF) << 32);
+    }
+
+    uint32_t* lights = nullptr;
+    if (objectLights) {
+      lights = allocator.allocate<uint32_t>(MaxObjectLights);
+      output.objectLights += computeObjectLights(itemBounds, lights);
+    }
+
+    output.packets[output.count++] = { key, lights, i };
+  }
+}
+
+void Renderer::buildDrawBatches(const RenderList& list, const std::vector<CommandPacket>& packets, PassType pass, DrawBatches& batches) {
+  batches.clear();
+
+  const bool depthOnly = (pass != PassType::Main);
+
+  for (const auto& packet : packets) {
+    const auto& item = list[packet.item];
+    const auto& geometry = geometryFor(item, depthOnly);
+
+    if (_drawTransforms.size() >= GeometryArena::MaxDrawIds) {
+      LOG_WARN("[Renderer] Draw limit {} reached, skipping remaining items", (int)GeometryArena::MaxDrawIds);
+      break;
+    }
+
+    Material* material = depthOnly ? nullptr : item.material;
+    const bool prepassed = (pass == PassType::Main) && isPrepassed(item);
+    if (batches.empty() || batches.back().material != material || batches.back().buffer != geometry.buffer.get() || batches.back().depthPrepassed != prepassed) {
+      batches.push_back({ material, geometry.buffer.get(), (uint32_t)_drawCommands.size(), 0, prepassed });
+    }
+
+    DrawElementsIndirectCommand command;
+    command.count = geometry.indexCount;
+    command.instanceCount = 1;
+    command.firstIndex = geometry.firstIndex;
+    command.baseVertex = geometry.baseVertex;
+    command.baseInstance = _drawTransforms.size();
+
+    _drawCommands.push_back(command);
+    _drawTransforms.push_back(item.modelTM);
+    batches.back().commandCount++;
+
+    // Light lists stay aligned with the draw transforms, depth-only draws get empty ones
+    if (_lightAssignment == LightAssignment::PerObject) {
+      const uint32_t* lights = packet.lights;
+      _drawLights.push_back(lights ? glm::uvec4(lights[0], lights[1], lights[2], lights[3]) : glm::uvec4(INVALID_LIGHT));
+      _drawLights.push_back(lights ? glm::uvec4(lights[4], lights[5], lights[6], lights[7]) : glm::uvec4(INVALID_LIGHT));
+    }
+
+    if (pass == PassType::Main) {
+      _stats.visibleItems++;
+    }
+  }
+}
+
+const GeometryRange& Renderer::geometryFor(const RenderItem& item, bool depthOnly) const {
+  const bool positionOnly = depthOnly && item.mesh->hasPositionStream();
+
+  return positionOnly ? item.mesh->getPositionGeometry() : item.mesh->getGeometry();
+}
+
+bool Renderer::isPrepassed(const RenderItem& item) const {
+  // Only meshes with a position stream go through the pre-pass (not the skybox or other custom vertex transforms)
+  return isDepthPrepassActive() && item.mesh->hasPositionStream();
+}
+
+uint32_t Renderer::computeObjectLights(const AABB& bounds, uint32_t* indices) const {
+  std::array<float, MaxObjectLights> distances;
+  uint32_t count = 0;
+
+  std::fill(indices, indices + MaxObjectLights, INVALID_LIGHT);
+
+  if (bounds.valid()) {
+    const auto& radii = _lightClusters.getLightRadii();
+
+    for (uint32_t i = 0; i < radii.size(); ++i) {
+      const glm::vec3& position = _lightsList[i].position;
+      const glm::vec3 offset = position - glm::clamp(position, bounds.min, bounds.max);
+      const float distanceSq = glm::dot(offset, offset);
+
+      if (distanceSq > radii[i] * radii[i])
+        continue;
+      if (count == MaxObjectLights && distanceSq >= distances[count - 1])
+        continue;
+
+      // Insert sorted by distance, dropping the farthest when full
+      uint32_t pos = std::min(count, (uint32_t)MaxObjectLights - 1);
+      while (pos > 0 && distances[pos - 1] > distanceSq) {
+        distances[pos] = distances[pos - 1];
+        indices[pos] = indices[pos - 1];
+        pos--;
+      }
+
+      distances[pos] = distanceSq;
+      indices[pos] = i;
+      count = std::min(count + 1, (uint32_t)MaxObjectLights);
+    }
+  }
+
+  return count;
+}
+
+void Renderer::bindDrawData() {
+  _drawTransformsBuffer->bind(DRAW_TRANSFORMS_TEXTURE_SLOT);
+  _drawLightsBuffer->bind(DRAW_LIGHTS_TEXTURE_SLOT);
+  if (_multiDrawEnabled) {
+    _drawCommandsBuffer->bind();
+  }
+}
+
+void Renderer::bindMainPassShader(Shader& shader, const glm::mat4& lightViewProj, bool objectLights) {
+  shader.use();
+  shader.setUniformBlockBind("Camera", UBO_CAMERA_IDX);
+  shader.setUniformBlockBind("Lights", UBO_LIGHTS_IDX);
+  shader.setUniformInt("shadow_depth_map", SHADOW_MAP_TEXTURE_SLOT);
+  shader.setUniformInt("draw_transforms", DRAW_TRANSFORMS_TEXTURE_SLOT);
+  shader.setUniformInt("point_lights", POINT_LIGHTS_TEXTURE_SLOT);
+  shader.setUniformInt("light_clusters", LIGHT_CLUSTERS_TEXTURE_SLOT);
+  shader.setUniformInt("light_indices", LIGHT_INDICES_TEXTURE_SLOT);
+  shader.setUniformInt("draw_lights", DRAW_LIGHTS_TEXTURE_SLOT);
+  shader.setUniformInt("object_lights", objectLights ? 1 : 0);
+  shader.setUniformMatrix4("mtx_light_vp", lightViewProj);
+}
+
+bool Renderer::isDeferred(const Material& material) const {
+  return _renderPath == RenderPath::Deferred && material.getShader()->getGBufferVariant() != nullptr;
+}
+
+void Renderer::renderDeferredLighting(const FBO& gbuffer, const glm::mat4& lightViewProj) {
+  for (uint32_t i = 0; i < 2; ++i) {
+    glActiveTexture(GL_TEXTURE0 + GBUFFER_TEXTURE_SLOT + i);
+    glBindTexture(GL_TEXTURE_2D, gbuffer.colorAttachment(i));
+  }
+  glActiveTexture(GL_TEXTURE0 + GBUFFER_TEXTURE_SLOT + 2);
+  glBindTexture(GL_TEXTURE_2D, gbuffer.depthAttachment());
+
+  auto& shader = *_deferredLightingShader;
+  bindMainPassShader(shader, lightViewProj, false);
+  shader.setUniformInt("gbuffer_albedo_spec", GBUFFER_TEXTURE_SLOT);
+  shader.setUniformInt("gbuffer_normal", GBUFFER_TEXTURE_SLOT + 1);
+  shader.setUniformInt("gbuffer_depth", GBUFFER_TEXTURE_SLOT + 2);
+  shader.setUniformMatrix4("mtx_inv_viewproj", glm::inverse(_renderCamera.getViewProjection()));
+
+  // One screen pass writes color and the G-buffer depth, forward materials then depth test against it
+  glDepthFunc(GL_ALWAYS);
+  _screenDebugQuad->draw();
+  glDepthFunc(GL_LEQUAL);
+}
+
+void Renderer::setDepthEqual(bool enabled) {
+  // Pre-passed geometry matches the stored depth exactly, nothing to write
+  glDepthFunc(enabled ? GL_EQUAL : GL_LEQUAL);
+  glDepthMask(enabled ? GL_FALSE : GL_TRUE);
+}
+
+uint32_t Renderer::submitDrawBatch(Shader& shader, const DrawBatch& batch) {
+  batch.buffer->bind();
+
+  if (_multiDrawEnabled) {
+    shader.setUniformInt("draw_offset", 0);
+    glMultiDrawElementsIndirect(
+      GL_TRIANGLES,
+      GL_UNSIGNED_INT,
+      INT_TO_VOIDPTR(sizeof(DrawElementsIndirectCommand) * batch.firstCommand),
+      batch.commandCount,
+      0
+    );
+
+    return 1;
+  }
+
+  // Fallback: the instanced draw id stays 0, the draw index comes from the uniform
+  for (uint32_t i = 0; i < batch.commandCount; ++i) {
+    const auto& command = _drawCommands[batch.firstCommand + i];
+
+    shader.setUniformInt("draw_offset", command.baseInstance);
+    glDrawElementsBaseVertex(
+      GL_TRIANGLES,
+      command.count,
+      GL_UNSIGNED_INT,
+      INT_TO_VOIDPTR(sizeof(uint32_t) * command.firstIndex),
+      command.baseVertex
+    );
+  }
+
+  return batch.commandCount;
+}
+
+uint32_t Renderer::submitCulledBatch(Shader& shader, const DrawBatch& batch) {
+  // Instance counts and draw ids were written by the culling pass
+  batch.buffer->bind(DrawIdSource::InstanceList);
+  shader.setUniformInt("draw_offset", 0);
+  glMultiDrawElementsIndirect(
+    GL_TRIANGLES,
+    GL_UNSIGNED_INT,
+    INT_TO_VOIDPTR(sizeof(DrawElementsIndirectCommand) * batch.firstCommand),
+    batch.commandCount,
+    0
+  );
+
+  return 1;
+}
+
+void Renderer::saveScreenshots(bool wait) {
+  _screenshotReadback->update([this, wait](const FrameReadback::Frame& frame) {
+    // Writer busy with earlier screenshots, the readback stays pending until a buffer is free
+    ImageData* image = _imageWriter.acquire(wait);
+    if (image == nullptr)
+      return false;
+
+    FrameReadback::CopyToImage(frame, *image);
 
-  glReadPixels(0, 0, _viewportWidth, _viewportWidth, GL_RGB, GL_UNSIGNED_BYTE, img.data.data());
+    char filename[128];
+    sprintf(filename, "_captures/screenshot_%llu.png", (unsigned long long)frame.tag);
 
-  char filename[128];
-  long int t = time(NULL);
-  sprintf(filename, "_captures/screenshot_%ld.png", t);
+    _imageWriter.write(image, filename);
 
-  FileUtils::saveImageToFile(FileUtils::getAbsolutePath(filename).c_str(), img);
+    return true;
+  }, wait);
 }
@@ -1,23 +1,32 @@
 #pragma once
 
 #include "camera.h"
+#include "image_writer.h"
+#include "graphics/command_recorder.h"
+#include "graphics/draw_batch.h"
 #include "graphics/font_atlas.h"
+#include "graphics/frame_readback.h"
+#include "graphics/frame_recorder.h"
+#include "graphics/gpu_scene.h"
+#include "graphics/light_clusters.h"
 #include "graphics/lights.h"
 #include "graphics/material.h"
 #include "graphics/mesh.h"
+#include "graphics/occlusion_culler.h"
+#include "graphics/render_graph.h"
 #include "graphics/text_buffer.h"
+#include "graphics/text_cache.h"
 
-enum DrawFlags {
-  DrawFlags_None = 0,
-  DrawFlags_Shadow = BIT(0)
-};
+struct ImDrawList;
 
 class Renderer {
 private:
+  // Non-owning, whoever submits the item keeps the mesh and material alive until the frame is rendered
   struct RenderItem {
-    MeshRef     mesh;
-    MaterialRef material;
+    Mesh*       mesh;
+    Material*   material;
     glm::mat4   modelTM;
+    uint32_t    flags;
   };
 
   struct Stats {
@@ -27,25 +36,157 @@ private:
 
     void reset() {
       drawcalls =  0;
+      drawcallsShadows = 0;
+      drawItems = 0;
+      culledItems = 0;
+      occludedItems = 0;
+      drawcallsPrepass = 0;
+      gpuShadowMs = 0.0f;
+      gpuPrepassMs = 0.0f;
+      gpuMainMs = 0.0f;
+      visibleItems = 0;
+      occluders = 0;
+      renderObjects = 0;
       pointlights = 0;
+      lightIndices = 0;
+      objectLights = 0;
+      deferredItems = 0;
+      recordThreads = 0;
+      glyphs = 0;
+      textRuns = 0;
+      textLayouts = 0;
+      atlasGlyphs = 0;
+      atlasUploads = 0;
+      streamStalls = 0;
+      streamPersistent = false;
+      recordedFrames = 0;
+      recordFps = 0.0f;
+      recordWaitMs = 0.0f;
+      recordDropped = 0;
     }
 
     uint32_t drawcalls;
     uint32_t drawcallsShadows;
+    uint32_t drawItems;
+    uint32_t culledItems;
+    uint32_t occludedItems;
+    uint32_t drawcallsPrepass;
+    float    gpuShadowMs;
+    float    gpuPrepassMs;
+    float    gpuMainMs;
+    uint32_t visibleItems;
+    uint32_t occluders;
+    uint32_t renderObjects;
     uint32_t pointlights;
+    uint32_t lightIndices;
+    uint32_t objectLights;
+    uint32_t deferredItems;
+    uint32_t recordThreads;
+    uint32_t glyphs;
+    uint32_t textRuns;    // Cached
+    uint32_t textLayouts; // Laid out this frame, the rest were reused
+    uint32_t atlasGlyphs;
+    uint32_t atlasUploads;
+    uint32_t streamStalls; // Since startup
+    bool     streamPersistent;
+    uint32_t recordedFrames; // Written since startup
+    float    recordFps;
+    float    recordWaitMs;   // Render thread blocked on the writer, since the recording started
+    uint32_t recordDropped;  // Readbacks lost to GL failures, since startup
+  };
+
+public:
+  enum {
+    MaxFrameLatency = 2
+  };
+
+  enum class LightAssignment {
+    Clustered,
+    PerObject   // At most MaxObjectLights nearest lights per draw
+  };
+
+  enum class RenderPath {
+    Forward,
+    Deferred    // Materials with a G-buffer shader variant are lit in a screen pass, the rest stay forward
+  };
+
+private:
+  // Also the pass index in the CommandRecorder
+  enum class PassType {
+    Shadow = 0,
+    DepthPrepass,
+    Main
   };
 
-  typedef std::vector<RenderItem>  RenderList;
-  typedef std::vector<Light> LightsList;
+  typedef LinearArray<RenderItem> RenderList;
+  typedef LinearArray<Light> LightsList;
 
   enum {
-    MaxPointLights = 8,
+    MaxPointLights = LightClusters::MaxLights,
+    MaxObjectLights = 8,
+  };
+
+  struct Settings {
+    ColorRGB clearColor;
+    uint32_t viewportWidth;
+    uint32_t viewportHeight;
+    bool     wireframe;
+    bool     debug;
+    bool     multiDraw;
+    bool     gpuCulling;
+    bool     occlusionCulling;
+    bool     depthPrepass;
+    LightAssignment lightAssignment;
+    RenderPath renderPath;
+    uint32_t recordInterval; // 0 while not recording
+    FrameRecorder::Format recordFormat;
+  };
+
+  // Retained object changes are applied when the frame is rendered, so the render side never sees them mid-frame
+  struct ObjectOp {
+    RenderObjectId id;
+    glm::mat4      worldTM;
+    bool           destroy;
+  };
+
+  // Resolved into glyphs in endFrame, once every anchor of the frame is projected
+  struct TextDraw {
+    const TextRun* run;
+    glm::vec3      position;
+    ColorRGB       color;
+    bool           center;
+  };
+
+  // Everything submitted for one frame. Written between beginFrame and endFrame, read by renderFrame,
+  // which may run on the render thread while the next frame is being submitted.
+  struct FrameData {
+    LinearAllocator allocator; // Backs the lists below, reset when the slot is reused
+    RenderList mainPassList;
+    RenderList shadowPassList;
+    LightsList lightsList;
+    LinearArray<TextDraw> textDraws;
+    LinearArray<GlyphInstance> glyphs;
+    LinearArray<FontAtlas::Upload> glyphUploads;
+    LinearArray<ObjectOp> objectOps;
+    std::vector<ImDrawList*> guiDrawLists; // Cloned from the ImGui draw data
+    glm::vec2 guiDisplayPos;
+    glm::vec2 guiDisplaySize;
+    glm::vec2 guiFramebufferScale;
+    Camera    camera;
+    Light     mainLight;
+    Settings  settings;
+    bool      captureScreen;
+    uint64_t  resourceFrame; // ResourcePools frame, resources destroyed after it are released once it is rendered
+    uint32_t  textRuns;
+    uint32_t  textLayouts;
+    uint32_t  atlasGlyphs;
   };
 
 public:
   Renderer();
+  ~Renderer();
 
-  void init(int width, int height);
+  void init(int width, int height, JobSystem& jobSystem);
 
   Camera& getViewCamera() { return _viewCamera; };
   const Camera& getViewCamera() const { return _viewCamera; }
@@ -53,46 +194,159 @@ public:
   Light& getMainLight() { return _mainLight; }
   const Light& getMainLight() const { return _mainLight; }
 
-  const Stats& getStats() const { return _stats; }
+  // Results of the last rendered frame, refreshed by beginFrame
+  const Stats& getStats() const { return _frameStats; }
+  const std::vector<RenderGraph::PassTiming>& getPassTimings() const { return _framePassTimings; }
+  uint32_t getPooledTargetCount() const { return _framePooledTargets; }
 
   void setViewport(int width, int height);
-  void setClearColor(const ColorRGB& c) { _clearColor = c; }
+  void setClearColor(const ColorRGB& c) { _settings.clearColor = c; }
   void toggleWireframe();
   void toggleDebug();
+  void toggleMultiDraw();
+  void toggleGPUCulling();
+  void toggleOcclusionCulling();
+  void toggleDepthPrepass();
+  void setLightAssignment(LightAssignment assignment) { _settings.lightAssignment = assignment; }
+  void setRenderPath(RenderPath path) { _settings.renderPath = path; }
+
+  bool isMultiDrawSupported() const { return _multiDrawSupported; }
+  bool isMultiDrawEnabled() const { return _settings.multiDraw; }
+  bool isGPUCullingSupported() const { return _gpuScene.isSupported(); }
+  bool isGPUCullingEnabled() const { return _settings.gpuCulling && _settings.multiDraw; }
+  bool isOcclusionCullingEnabled() const { return _settings.occlusionCulling; }
+  bool isDepthPrepassEnabled() const { return _settings.depthPrepass; }
+  LightAssignment getLightAssignment() const { return _settings.lightAssignment; }
+  RenderPath getRenderPath() const { return _settings.renderPath; }
 
   void drawText(const std::string& text, const glm::vec3& position, const ColorRGB& = ColorRGB(1.0f), bool center = true, float scale = 1.0f);
   void drawLight(const Light& light);
-  void drawMesh(MeshRef mesh, MaterialRef material, const glm::mat4& worldTM, uint32_t drawFlags = DrawFlags_None);
+  void drawMesh(const MeshRef& mesh, const MaterialRef& material, const glm::mat4& worldTM, uint32_t drawFlags = DrawFlags_None);
+
+  // Retained objects, drawn every frame until destroyed (culled on the GPU when supported)
+  RenderObjectId createRenderObject(MeshRef mesh, MaterialRef material, const glm::mat4& worldTM, uint32_t drawFlags = DrawFlags_None);
+  void updateRenderObject(RenderObjectId id, const glm::mat4& worldTM);
+  void destroyRenderObject(RenderObjectId id);
 
+  // Update thread: beginFrame opens the next frame for submission, endFrame closes it
   void beginFrame();
   void endFrame();
+  // GL thread: renders the oldest closed frame, frames are rendered in submission order
+  void renderFrame();
+
+  // Frames closed and not rendered yet, only changed while no frame is in flight
+  void setFrameLatency(uint32_t latency);
+  uint32_t getFrameLatency() const { return _frameCount - 1; }
 
   void captureScreen();
+  // Records every interval-th frame until stopped, see FrameRecorder
+  void startRecording(uint32_t interval, FrameRecorder::Format format);
+  void stopRecording();
+  bool isRecording() const { return _settings.recordInterval > 0; }
+
+private:
+  static void addRenderItem(RenderList& mainList, RenderList& shadowList, const RenderItem& item);
+  void applySettings(const Settings& settings);
+  void renderGUI(FrameData& frame);
+  void emitText(FrameData& frame);
+  void saveScreenshots(bool wait);
+
+  void renderOccluders(const Frustum& frustum);
+  void recordCommands(PassType pass, const Frustum& frustum, uint32_t begin, uint32_t end, LinearAllocator& allocator, CommandRecorder::TaskOutput& output) const;
+  void buildDrawBatches(const RenderList& list, const std::vector<CommandPacket>& packets, PassType pass, DrawBatches& batches);
+  const GeometryRange& geometryFor(const RenderItem& item, bool depthOnly) const;
+  bool isPrepassed(const RenderItem& item) const;
+  uint32_t computeObjectLights(const AABB& bounds, uint32_t* indices) const;
+  void bindDrawData();
+  void bindMainPassShader(Shader& shader, const glm::mat4& lightViewProj, bool objectLights);
+  void setDepthEqual(bool enabled);
+  bool isDepthPrepassActive() const { return _depthPrepassEnabled && _renderPath == RenderPath::Forward; }
+  bool isDeferred(const Material& material) const;
+  void renderDeferredLighting(const FBO& gbuffer, const glm::mat4& lightViewProj);
+  uint32_t submitDrawBatch(Shader& shader, const DrawBatch& batch);
+  uint32_t submitCulledBatch(Shader& shader, const DrawBatch& batch);
 
 private:
-  Camera   _viewCamera;
   UBORef   _uboCamera;
   UBORef   _uboLights;
-  FBORef   _fboShadowmap;
+
+  TBORef            _drawTransformsBuffer;
+  TBORef            _drawLightsBuffer;
+  IndirectBufferRef _drawCommandsBuffer;
+  std::vector<glm::mat4> _drawTransforms;
+  std::vector<glm::uvec4> _drawLights;
+  std::vector<DrawElementsIndirectCommand> _drawCommands;
+  DrawBatches       _mainPassBatches;
+  DrawBatches       _shadowPassBatches;
+  DrawBatches       _depthPrepassBatches;
+  GPUScene          _gpuScene;
+  OcclusionCuller   _occlusionCuller;
+  LightClusters     _lightClusters;
+  CommandRecorder   _commandRecorder;
+  RenderGraph       _renderGraph;
+  std::vector<std::pair<float, uint32_t>> _occluderCandidates;
 
   FontAtlasRef  _font;
   ShaderRef     _textShader;
   TextBufferRef _textBuffer;
-  std::vector<TextVertex> _textVertices;
+  TextCache     _textCache; // Update thread side
+  LinearArray<GlyphInstance> _glyphs;
+
+  // Screenshots are read back a frame or two late and saved on the writer thread
+  FrameReadbackRef _screenshotReadback;
+  ImageWriter      _imageWriter;
+  bool             _screenshotPending;
+  FrameRecorder    _frameRecorder;
 
   ShaderRef     _shadowmapShader;
+  ShaderRef     _depthPrepassShader;
   ShaderRef     _screenQuadDepthShader;
+  ShaderRef     _deferredLightingShader;
   MeshRef       _screenDebugQuad;
 
+  // Update thread side
+  Camera    _viewCamera;
+  Light     _mainLight;
+  Settings  _settings;
+  bool      _captureRequested;
+  Stats     _frameStats;
+  std::vector<RenderGraph::PassTiming> _framePassTimings;
+  uint32_t  _framePooledTargets;
+
+  std::array<FrameData, MaxFrameLatency + 1> _frames;
+  uint32_t  _frameCount;
+  uint32_t  _submitIndex;
+  uint32_t  _renderIndex;
+
+  // Render side, swapped in from the frame being rendered
+  Camera     _renderCamera;
+  Light      _renderMainLight;
   RenderList _mainPassList;
   RenderList _shadowPassList;
-  Light      _mainLight;
   LightsList _lightsList;
 
+  // Retained objects are created from the update thread while the render side reads them
+  std::mutex _gpuSceneMutex;
+
+  // Render results handed back to the update thread
+  std::mutex _publishMutex;
+  Stats      _publishedStats;
+  std::vector<RenderGraph::PassTiming> _publishedPassTimings;
+  uint32_t   _publishedPooledTargets;
+
   Stats    _stats;
   uint32_t _viewportHeight;
   uint32_t _viewportWidth;
   ColorRGB _clearColor;
   bool     _wireframeEnabled;
   bool     _debugEnabled;
+  bool     _multiDrawSupported;
+  bool     _multiDrawEnabled;
+  bool     _gpuCullingEnabled;
+  bool     _occlusionCullingEnabled;
+  bool     _depthPrepassEnabled;
+  LightAssignment _lightAssignment;
+  RenderPath _renderPath;
+  uint32_t _recordInterval;
+  FrameRecorder::Format _recordFormat;
 };
@@ -0,0 +1,39 @@
+#include "resource_pool.h"
+
+std::vector<ResourcePools::Pool*> ResourcePools::_pools;
+std::mutex ResourcePools::_poolsMutex;
+std::atomic<uint64_t> ResourcePools::_submitFrame(0);
+
+/*static*/ void ResourcePools::registerPool(Pool* pool) {
+  std::lock_guard<std::mutex> lock(_poolsMutex);
+  _pools.push_back(pool);
+}
+
+/*static*/ ResourcePools::Pool* ResourcePools::getPool(size_t i) {
+  std::lock_guard<std::mutex> lock(_poolsMutex);
+  return i < _pools.size() ? _pools[i] : nullptr;
+}
+
+/*static*/ void ResourcePools::collect(uint64_t renderedFrame) {
+  // Not locked while collecting, destructors may use a pool for the first time
+  for (size_t i = 0; Pool* pool = getPool(i); ++i) {
+    pool->collect(renderedFrame);
+  }
+}
+
+/*static*/ void ResourcePools::shutdown() {
+  // Releasing a resource can destroy others (models own their meshes), repeat until nothing is left
+  auto releaseAll = [](bool alive) {
+    uint32_t released = 1;
+    while (released > 0) {
+      released = 0;
+      for (size_t i = 0; Pool* pool = getPool(i); ++i) {
+        released += alive ? pool->releaseAlive() : pool->releasePending();
+      }
+      alive = false;
+    }
+  };
+
+  releaseAll(false);
+  releaseAll(true);
+}
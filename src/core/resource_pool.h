@@ -0,0 +1,314 @@
+#pragma once
+
+#include <atomic>
+#include <typeinfo>
+
+#if !defined(NDEBUG)
+#define GFX_VALIDATE_HANDLES 1
+#endif
+
+template<typename T>
+class ResourcePool;
+
+// Slot index in the low bits, slot generation in the high bits, 0 is the null id. Tag only keeps ids of
+// different kinds from mixing, whoever issued the id resolves it.
+template<typename Tag>
+class GenerationalId {
+public:
+  enum : uint32_t {
+    IndexBits = 20,
+    IndexMask = (1u << IndexBits) - 1,
+    GenerationMask = (1u << (32 - IndexBits)) - 1,
+  };
+
+  GenerationalId()
+    : _value(0) {
+  }
+  GenerationalId(std::nullptr_t)
+    : _value(0) {
+  }
+
+  static GenerationalId Make(uint32_t index, uint32_t generation) {
+    GenerationalId id;
+    id._value = (index & IndexMask) | ((generation & GenerationMask) << IndexBits);
+    return id;
+  }
+
+  uint32_t index() const { return _value & IndexMask; }
+  uint32_t generation() const { return _value >> IndexBits; }
+  uint32_t value() const { return _value; }
+
+  explicit operator bool() const { return _value != 0; }
+  bool operator==(const GenerationalId& other) const { return _value == other._value; }
+  bool operator!=(const GenerationalId& other) const { return _value != other._value; }
+  bool operator==(std::nullptr_t) const { return _value == 0; }
+  bool operator!=(std::nullptr_t) const { return _value != 0; }
+
+private:
+  uint32_t _value;
+};
+
+// 32-bit reference to a pooled resource, resolved through its ResourcePool. Plain value, copying it costs
+// nothing and does not keep the resource alive.
+template<typename T>
+class Handle : public GenerationalId<T> {
+public:
+  Handle() {}
+  Handle(std::nullptr_t) {}
+  Handle(const GenerationalId<T>& id)
+    : GenerationalId<T>(id) {
+  }
+
+  static Handle Make(uint32_t index, uint32_t generation) { return GenerationalId<T>::Make(index, generation); }
+
+  T* get() const { return ResourcePool<T>::Get().resolve(*this); }
+  T* operator->() const { return get(); }
+  T& operator*() const { return *get(); }
+};
+
+// Frame bookkeeping shared by every pool. Destroyed resources are released on the render side once
+// the GPU is done with the frames that may still use them.
+class ResourcePools {
+public:
+  enum {
+    RetireFrames = 2, // Frames the GPU may run behind the frame the render side just finished
+  };
+
+  // Submit side, resources destroyed from now on are tagged with the new frame
+  static void beginFrame() { _submitFrame.fetch_add(1, std::memory_order_relaxed); }
+  static uint64_t getSubmitFrame() { return _submitFrame.load(std::memory_order_relaxed); }
+
+  // Render side, with the GL context current, once frame is rendered
+  static void collect(uint64_t renderedFrame);
+  // Releases everything, pending or alive. Live resources at this point are leaks and get logged.
+  static void shutdown();
+
+private:
+  template<typename T>
+  friend class ResourcePool;
+
+  class Pool {
+  public:
+    virtual ~Pool() {}
+    virtual void collect(uint64_t renderedFrame) = 0;
+    virtual uint32_t releasePending() = 0;
+    virtual uint32_t releaseAlive() = 0;
+  };
+
+  static void registerPool(Pool* pool);
+  // Indexed and locked per step, destructors may use a pool for the first time and register it
+  static Pool* getPool(size_t i);
+
+  static std::vector<Pool*> _pools;
+  static std::mutex _poolsMutex; // Pools register on first use, from any thread
+  static std::atomic<uint64_t> _submitFrame;
+};
+
+// Slots are allocated in fixed chunks that never move, so resolving a handle is an index into a chunk
+// and resources of one type sit next to each other. Create and destroy lock, resolve does not.
+template<typename T>
+class ResourcePool : public ResourcePools::Pool {
+public:
+  enum {
+    ChunkSize = 256,
+    MaxChunks = (Handle<T>::IndexMask + 1) / ChunkSize,
+  };
+
+  static ResourcePool& Get() {
+    static ResourcePool* pool = new ResourcePool(); // Released by ResourcePools::shutdown, never at exit
+    return *pool;
+  }
+
+  template<typename... Args>
+  Handle<T> create(Args&&... args) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t index;
+    if (!_freeSlots.empty()) {
+      index = _freeSlots.back();
+      _freeSlots.pop_back();
+    }
+    else {
+      index = _slotCount.load(std::memory_order_relaxed);
+      if (index > Handle<T>::IndexMask) {
+        LOG_ERROR("[ResourcePool] Out of {} slots ({})", Handle<T>::IndexMask + 1, typeid(T).name());
+        return Handle<T>();
+      }
+
+      if (_chunks[index / ChunkSize] == nullptr) {
+        _chunks[index / ChunkSize] = new Slot[ChunkSize];
+      }
+      _slotCount.store(index + 1, std::memory_order_release);
+    }
+
+    Slot& slot = getSlot(index);
+    new (slot.storage) T(std::forward<Args>(args)...);
+    slot.alive = true;
+    slot.pendingDestroy = false;
+    _aliveCount++;
+
+    return Handle<T>::Make(index, slot.generation);
+  }
+
+  // The resource stays valid until the frames submitted so far are done on the GPU
+  void destroy(Handle<T> handle) {
+    if (!handle)
+      return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Slot* slot = findSlot(handle);
+    if (slot == nullptr || slot->pendingDestroy) {
+#if GFX_VALIDATE_HANDLES
+      LOG_ERROR("[ResourcePool] Destroying a stale handle {:#x} ({})", handle.value(), typeid(T).name());
+#endif
+      return;
+    }
+
+    slot->pendingDestroy = true;
+    _pending.push_back({ handle.index(), ResourcePools::getSubmitFrame() });
+  }
+
+  T* resolve(Handle<T> handle) const {
+#if GFX_VALIDATE_HANDLES
+    Slot* slot = findSlot(handle);
+    if (slot == nullptr) {
+      if (handle) {
+        LOG_ERROR("[ResourcePool] Stale handle {:#x} ({})", handle.value(), typeid(T).name());
+      }
+      return nullptr;
+    }
+    return slot->object();
+#else
+    return handle ? getSlot(handle.index()).object() : nullptr;
+#endif
+  }
+
+  uint32_t getAliveCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _aliveCount;
+  }
+  uint32_t getPendingCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (uint32_t)_pending.size();
+  }
+
+private:
+  struct Slot {
+    Slot()
+      : generation(1)
+      , alive(false)
+      , pendingDestroy(false) {
+    }
+
+    T* object() { return reinterpret_cast<T*>(storage); }
+    const T* object() const { return reinterpret_cast<const T*>(storage); }
+
+    alignas(T) uint8_t storage[sizeof(T)];
+    uint32_t generation;
+    bool     alive;
+    bool     pendingDestroy;
+  };
+
+  struct PendingDestroy {
+    uint32_t index;
+    uint64_t frame;
+  };
+
+  ResourcePool()
+    : _slotCount(0)
+    , _aliveCount(0) {
+    _chunks.fill(nullptr);
+    ResourcePools::registerPool(this);
+  }
+
+  Slot& getSlot(uint32_t index) const { return _chunks[index / ChunkSize][index % ChunkSize]; }
+
+  Slot* findSlot(Handle<T> handle) const {
+    if (!handle || handle.index() >= _slotCount.load(std::memory_order_acquire))
+      return nullptr;
+
+    Slot& slot = getSlot(handle.index());
+    return (slot.alive && slot.generation == handle.generation()) ? &slot : nullptr;
+  }
+
+  // Called without the lock held, destructors may destroy other resources
+  void release(const std::vector<PendingDestroy>& entries) {
+    for (const auto& entry : entries) {
+      getSlot(entry.index).object()->~T();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& entry : entries) {
+      Slot& slot = getSlot(entry.index);
+      slot.alive = false;
+      slot.pendingDestroy = false;
+
+      // Generation 0 would make the null handle, skip it on wrap around
+      slot.generation = (slot.generation + 1) & Handle<T>::GenerationMask;
+      if (slot.generation == 0) {
+        slot.generation = 1;
+      }
+
+      _freeSlots.push_back(entry.index);
+      _aliveCount--;
+    }
+  }
+
+  virtual void collect(uint64_t renderedFrame) override {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      // Pending entries are in frame order, so are the ones ready to go
+      size_t ready = 0;
+      while (ready < _pending.size() && _pending[ready].frame + ResourcePools::RetireFrames <= renderedFrame) {
+        ready++;
+      }
+      if (ready == 0)
+        return;
+
+      _released.assign(_pending.begin(), _pending.begin() + ready);
+      _pending.erase(_pending.begin(), _pending.begin() + ready);
+    }
+
+    release(_released);
+  }
+
+  virtual uint32_t releasePending() override {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _released.swap(_pending);
+      _pending.clear();
+    }
+
+    release(_released);
+
+    return (uint32_t)_released.size();
+  }
+
+  virtual uint32_t releaseAlive() override {
+    uint32_t leaked = 0;
+    const uint32_t slotCount = _slotCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < slotCount; ++i) {
+      if (getSlot(i).alive && !getSlot(i).pendingDestroy) {
+        destroy(Handle<T>::Make(i, getSlot(i).generation));
+        leaked++;
+      }
+    }
+
+    if (leaked > 0) {
+      LOG_WARN("[ResourcePool] {} {} never destroyed", leaked, typeid(T).name());
+    }
+
+    return leaked + releasePending();
+  }
+
+private:
+  std::array<Slot*, MaxChunks> _chunks;
+  std::atomic<uint32_t> _slotCount;
+  uint32_t _aliveCount;
+  std::vector<uint32_t> _freeSlots;
+  std::vector<PendingDestroy> _pending;
+  std::vector<PendingDestroy> _released; // Render side scratch
+  mutable std::mutex _mutex;
+};
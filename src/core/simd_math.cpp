@@ -0,0 +1,579 @@
+#include "simd_math.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::quat) == 16 && sizeof(glm::mat4) == 64, "Kernels read glm types as packed floats");
+
+namespace SimdMath {
+  typedef void (*ComposeTRSFn)(const glm::vec3*, const glm::quat*, const glm::vec3*, glm::mat4*, uint32_t);
+  typedef void (*MultiplyFn)(const glm::mat4*, const uint32_t*, const glm::mat4*, glm::mat4*, uint32_t);
+  typedef void (*TestAABBsFn)(const Frustum&, const AABB*, uint32_t, uint8_t*);
+  typedef void (*ProjectPointsFn)(const glm::mat4&, const glm::vec4&, const glm::vec3*, glm::vec3*, uint32_t);
+
+  struct Kernels {
+    ComposeTRSFn    composeTRS;
+    MultiplyFn      multiply;
+    TestAABBsFn     testAABBs;
+    ProjectPointsFn projectPoints;
+  };
+
+  // Scalar
+
+  static void composeTRSScalar(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      const glm::vec3& p = positions[i];
+      const glm::quat& q = rotations[i];
+      const glm::vec3& s = scales[i];
+
+      const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+      const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+      const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+      float* m = &out[i][0][0];
+      m[0]  = (1.0f - 2.0f * (yy + zz)) * s.x;
+      m[1]  = 2.0f * (xy + wz) * s.x;
+      m[2]  = 2.0f * (xz - wy) * s.x;
+      m[3]  = 0.0f;
+      m[4]  = 2.0f * (xy - wz) * s.y;
+      m[5]  = (1.0f - 2.0f * (xx + zz)) * s.y;
+      m[6]  = 2.0f * (yz + wx) * s.y;
+      m[7]  = 0.0f;
+      m[8]  = 2.0f * (xz + wy) * s.z;
+      m[9]  = 2.0f * (yz - wx) * s.z;
+      m[10] = (1.0f - 2.0f * (xx + yy)) * s.z;
+      m[11] = 0.0f;
+      m[12] = p.x;
+      m[13] = p.y;
+      m[14] = p.z;
+      m[15] = 1.0f;
+    }
+  }
+
+  static void multiplyScalar(const glm::mat4* a, const uint32_t* aIndices, const glm::mat4* b, glm::mat4* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      const float* A = &a[aIndices != nullptr ? aIndices[i] : i][0][0];
+      const float* B = &b[i][0][0];
+
+      float result[16];
+      for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row) {
+          result[column * 4 + row] = A[row] * B[column * 4] + A[4 + row] * B[column * 4 + 1]
+            + A[8 + row] * B[column * 4 + 2] + A[12 + row] * B[column * 4 + 3];
+        }
+      }
+
+      memcpy(&out[i][0][0], result, sizeof(result));
+    }
+  }
+
+  static void testAABBsScalar(const Frustum& frustum, const AABB* boxes, uint32_t count, uint8_t* visible) {
+    for (uint32_t i = 0; i < count; ++i) {
+      visible[i] = frustum.intersects(boxes[i]) ? 1 : 0;
+    }
+  }
+
+  static void projectPointsScalar(const glm::mat4& viewProjection, const glm::vec4& viewport, const glm::vec3* points, glm::vec3* out, uint32_t count) {
+    const float* m = &viewProjection[0][0];
+
+    for (uint32_t i = 0; i < count; ++i) {
+      const glm::vec3& p = points[i];
+      const float x = m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12];
+      const float y = m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13];
+      const float z = m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14];
+      const float w = m[3] * p.x + m[7] * p.y + m[11] * p.z + m[15];
+
+      out[i].x = viewport.x + viewport.z * ((x / w) * 0.5f + 0.5f);
+      out[i].y = viewport.y + viewport.w * ((y / w) * 0.5f + 0.5f);
+      out[i].z = (z / w) * 0.5f + 0.5f;
+    }
+  }
+
+#if SIMD_X86
+
+  // SSE2, 4 items per iteration
+
+  SIMD_TARGET_SSE2 static void composeTRSSSE2(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      // Quaternions are x, y, z, w, transposing four of them gives one register per component
+      __m128 qx = _mm_loadu_ps(&rotations[i].x);
+      __m128 qy = _mm_loadu_ps(&rotations[i + 1].x);
+      __m128 qz = _mm_loadu_ps(&rotations[i + 2].x);
+      __m128 qw = _mm_loadu_ps(&rotations[i + 3].x);
+      _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+      const __m128 sx = _mm_setr_ps(scales[i].x, scales[i + 1].x, scales[i + 2].x, scales[i + 3].x);
+      const __m128 sy = _mm_setr_ps(scales[i].y, scales[i + 1].y, scales[i + 2].y, scales[i + 3].y);
+      const __m128 sz = _mm_setr_ps(scales[i].z, scales[i + 1].z, scales[i + 2].z, scales[i + 3].z);
+
+      const __m128 x2 = _mm_add_ps(qx, qx);
+      const __m128 y2 = _mm_add_ps(qy, qy);
+      const __m128 z2 = _mm_add_ps(qz, qz);
+      const __m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+      const __m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+      const __m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+
+      __m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+      __m128 c0y = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+      __m128 c0z = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+      __m128 c0w = zero;
+      __m128 c1x = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+      __m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+      __m128 c1z = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+      __m128 c1w = zero;
+      __m128 c2x = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+      __m128 c2y = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+      __m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+      __m128 c2w = zero;
+
+      // Back to one column per register
+      _MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+      _MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+      _MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+
+      const __m128 columns0[4] = { c0x, c0y, c0z, c0w };
+      const __m128 columns1[4] = { c1x, c1y, c1z, c1w };
+      const __m128 columns2[4] = { c2x, c2y, c2z, c2w };
+
+      for (int k = 0; k < 4; ++k) {
+        float* m = &out[i + k][0][0];
+        const glm::vec3& p = positions[i + k];
+        _mm_storeu_ps(m, columns0[k]);
+        _mm_storeu_ps(m + 4, columns1[k]);
+        _mm_storeu_ps(m + 8, columns2[k]);
+        _mm_storeu_ps(m + 12, _mm_setr_ps(p.x, p.y, p.z, 1.0f));
+      }
+    }
+
+    composeTRSScalar(positions + i, rotations + i, scales + i, out + i, count - i);
+  }
+
+  SIMD_TARGET_SSE2 static void multiplySSE2(const glm::mat4* a, const uint32_t* aIndices, const glm::mat4* b, glm::mat4* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      const float* A = &a[aIndices != nullptr ? aIndices[i] : i][0][0];
+      const float* B = &b[i][0][0];
+
+      const __m128 a0 = _mm_loadu_ps(A);
+      const __m128 a1 = _mm_loadu_ps(A + 4);
+      const __m128 a2 = _mm_loadu_ps(A + 8);
+      const __m128 a3 = _mm_loadu_ps(A + 12);
+
+      // Every column is computed before storing, out may alias b
+      __m128 result[4];
+      for (int column = 0; column < 4; ++column) {
+        const __m128 bc = _mm_loadu_ps(B + column * 4);
+        __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+        result[column] = r;
+      }
+
+      float* O = &out[i][0][0];
+      for (int column = 0; column < 4; ++column) {
+        _mm_storeu_ps(O + column * 4, result[column]);
+      }
+    }
+  }
+
+  SIMD_TARGET_SSE2 static void testAABBsSSE2(const Frustum& frustum, const AABB* boxes, uint32_t count, uint8_t* visible) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      const AABB* b = boxes + i;
+      const __m128 minX = _mm_setr_ps(b[0].min.x, b[1].min.x, b[2].min.x, b[3].min.x);
+      const __m128 minY = _mm_setr_ps(b[0].min.y, b[1].min.y, b[2].min.y, b[3].min.y);
+      const __m128 minZ = _mm_setr_ps(b[0].min.z, b[1].min.z, b[2].min.z, b[3].min.z);
+      const __m128 maxX = _mm_setr_ps(b[0].max.x, b[1].max.x, b[2].max.x, b[3].max.x);
+      const __m128 maxY = _mm_setr_ps(b[0].max.y, b[1].max.y, b[2].max.y, b[3].max.y);
+      const __m128 maxZ = _mm_setr_ps(b[0].max.z, b[1].max.z, b[2].max.z, b[3].max.z);
+
+      const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+      const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+      const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+      const __m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+      const __m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+      const __m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+      __m128 outside = _mm_setzero_ps();
+      for (const auto& plane : frustum.planes) {
+        const __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+        const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(plane.w)));
+        const __m128 r = _mm_add_ps(_mm_add_ps(
+          _mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+          _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_xor_ps(r, signMask)));
+      }
+
+      const int mask = _mm_movemask_ps(outside);
+      for (int k = 0; k < 4; ++k) {
+        visible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+      }
+    }
+
+    testAABBsScalar(frustum, boxes + i, count - i, visible + i);
+  }
+
+  SIMD_TARGET_SSE2 static void projectPointsSSE2(const glm::mat4& viewProjection, const glm::vec4& viewport, const glm::vec3* points, glm::vec3* out, uint32_t count) {
+    const float* m = &viewProjection[0][0];
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      const glm::vec3* p = points + i;
+      const __m128 px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+      const __m128 py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+      const __m128 pz = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+
+      __m128 clip[4];
+      for (int row = 0; row < 4; ++row) {
+        clip[row] = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[row]), px), _mm_mul_ps(_mm_set1_ps(m[4 + row]), py)),
+          _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[8 + row]), pz), _mm_set1_ps(m[12 + row])));
+      }
+
+      const __m128 sx = _mm_add_ps(_mm_mul_ps(_mm_div_ps(clip[0], clip[3]), half), half);
+      const __m128 sy = _mm_add_ps(_mm_mul_ps(_mm_div_ps(clip[1], clip[3]), half), half);
+      const __m128 sz = _mm_add_ps(_mm_mul_ps(_mm_div_ps(clip[2], clip[3]), half), half);
+
+      alignas(16) float x[4], y[4], z[4];
+      _mm_store_ps(x, _mm_add_ps(_mm_set1_ps(viewport.x), _mm_mul_ps(_mm_set1_ps(viewport.z), sx)));
+      _mm_store_ps(y, _mm_add_ps(_mm_set1_ps(viewport.y), _mm_mul_ps(_mm_set1_ps(viewport.w), sy)));
+      _mm_store_ps(z, sz);
+
+      for (int k = 0; k < 4; ++k) {
+        out[i + k] = glm::vec3(x[k], y[k], z[k]);
+      }
+    }
+
+    projectPointsScalar(viewProjection, viewport, points + i, out + i, count - i);
+  }
+
+  // AVX2 + FMA, 8 items per iteration
+
+  SIMD_TARGET_AVX2 static void composeTRSAVX2(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      // Two 4x4 transposes, one per 128-bit lane
+      __m128 lx = _mm_loadu_ps(&rotations[i].x), ly = _mm_loadu_ps(&rotations[i + 1].x);
+      __m128 lz = _mm_loadu_ps(&rotations[i + 2].x), lw = _mm_loadu_ps(&rotations[i + 3].x);
+      __m128 hx = _mm_loadu_ps(&rotations[i + 4].x), hy = _mm_loadu_ps(&rotations[i + 5].x);
+      __m128 hz = _mm_loadu_ps(&rotations[i + 6].x), hw = _mm_loadu_ps(&rotations[i + 7].x);
+      _MM_TRANSPOSE4_PS(lx, ly, lz, lw);
+      _MM_TRANSPOSE4_PS(hx, hy, hz, hw);
+
+      const __m256 qx = _mm256_insertf128_ps(_mm256_castps128_ps256(lx), hx, 1);
+      const __m256 qy = _mm256_insertf128_ps(_mm256_castps128_ps256(ly), hy, 1);
+      const __m256 qz = _mm256_insertf128_ps(_mm256_castps128_ps256(lz), hz, 1);
+      const __m256 qw = _mm256_insertf128_ps(_mm256_castps128_ps256(lw), hw, 1);
+
+      const glm::vec3* s = scales + i;
+      const __m256 sx = _mm256_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x, s[4].x, s[5].x, s[6].x, s[7].x);
+      const __m256 sy = _mm256_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y, s[4].y, s[5].y, s[6].y, s[7].y);
+      const __m256 sz = _mm256_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z, s[4].z, s[5].z, s[6].z, s[7].z);
+
+      const __m256 x2 = _mm256_add_ps(qx, qx);
+      const __m256 y2 = _mm256_add_ps(qy, qy);
+      const __m256 z2 = _mm256_add_ps(qz, qz);
+      const __m256 xx = _mm256_mul_ps(qx, x2), yy = _mm256_mul_ps(qy, y2), zz = _mm256_mul_ps(qz, z2);
+      const __m256 xy = _mm256_mul_ps(qx, y2), xz = _mm256_mul_ps(qx, z2), yz = _mm256_mul_ps(qy, z2);
+      const __m256 wx = _mm256_mul_ps(qw, x2), wy = _mm256_mul_ps(qw, y2), wz = _mm256_mul_ps(qw, z2);
+
+      const __m256 rows[9] = {
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+        _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+        _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+        _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+        _mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+        _mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+        _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+      };
+
+      // Each lane is transposed back to one column per register
+      for (int lane = 0; lane < 2; ++lane) {
+        __m128 columns[3][4];
+        for (int column = 0; column < 3; ++column) {
+          __m128 cx = lane == 0 ? _mm256_castps256_ps128(rows[column * 3]) : _mm256_extractf128_ps(rows[column * 3], 1);
+          __m128 cy = lane == 0 ? _mm256_castps256_ps128(rows[column * 3 + 1]) : _mm256_extractf128_ps(rows[column * 3 + 1], 1);
+          __m128 cz = lane == 0 ? _mm256_castps256_ps128(rows[column * 3 + 2]) : _mm256_extractf128_ps(rows[column * 3 + 2], 1);
+          __m128 cw = zero;
+          _MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+          columns[column][0] = cx;
+          columns[column][1] = cy;
+          columns[column][2] = cz;
+          columns[column][3] = cw;
+        }
+
+        for (int k = 0; k < 4; ++k) {
+          const uint32_t index = i + lane * 4 + k;
+          const glm::vec3& p = positions[index];
+          float* m = &out[index][0][0];
+          _mm_storeu_ps(m, columns[0][k]);
+          _mm_storeu_ps(m + 4, columns[1][k]);
+          _mm_storeu_ps(m + 8, columns[2][k]);
+          _mm_storeu_ps(m + 12, _mm_setr_ps(p.x, p.y, p.z, 1.0f));
+        }
+      }
+    }
+
+    composeTRSScalar(positions + i, rotations + i, scales + i, out + i, count - i);
+  }
+
+  SIMD_TARGET_AVX2 static void multiplyAVX2(const glm::mat4* a, const uint32_t* aIndices, const glm::mat4* b, glm::mat4* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      const float* A = &a[aIndices != nullptr ? aIndices[i] : i][0][0];
+      const float* B = &b[i][0][0];
+
+      // Columns of a in both lanes, two columns of b per register
+      const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A));
+      const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A + 4));
+      const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A + 8));
+      const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(A + 12));
+
+      const __m256 b01 = _mm256_loadu_ps(B);
+      const __m256 b23 = _mm256_loadu_ps(B + 8);
+
+      __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+      r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+      r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+      r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+
+      __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+      r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+      r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+      r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+
+      float* O = &out[i][0][0];
+      _mm256_storeu_ps(O, r01);
+      _mm256_storeu_ps(O + 8, r23);
+    }
+  }
+
+  SIMD_TARGET_AVX2 static void testAABBsAVX2(const Frustum& frustum, const AABB* boxes, uint32_t count, uint8_t* visible) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    __m256 planes[Frustum::PlaneCount][7];
+    for (int p = 0; p < Frustum::PlaneCount; ++p) {
+      const glm::vec4& plane = frustum.planes[p];
+      planes[p][0] = _mm256_set1_ps(plane.x);
+      planes[p][1] = _mm256_set1_ps(plane.y);
+      planes[p][2] = _mm256_set1_ps(plane.z);
+      planes[p][3] = _mm256_set1_ps(plane.w);
+      planes[p][4] = _mm256_set1_ps(fabsf(plane.x));
+      planes[p][5] = _mm256_set1_ps(fabsf(plane.y));
+      planes[p][6] = _mm256_set1_ps(fabsf(plane.z));
+    }
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const AABB* b = boxes + i;
+      const __m256 minX = _mm256_setr_ps(b[0].min.x, b[1].min.x, b[2].min.x, b[3].min.x, b[4].min.x, b[5].min.x, b[6].min.x, b[7].min.x);
+      const __m256 minY = _mm256_setr_ps(b[0].min.y, b[1].min.y, b[2].min.y, b[3].min.y, b[4].min.y, b[5].min.y, b[6].min.y, b[7].min.y);
+      const __m256 minZ = _mm256_setr_ps(b[0].min.z, b[1].min.z, b[2].min.z, b[3].min.z, b[4].min.z, b[5].min.z, b[6].min.z, b[7].min.z);
+      const __m256 maxX = _mm256_setr_ps(b[0].max.x, b[1].max.x, b[2].max.x, b[3].max.x, b[4].max.x, b[5].max.x, b[6].max.x, b[7].max.x);
+      const __m256 maxY = _mm256_setr_ps(b[0].max.y, b[1].max.y, b[2].max.y, b[3].max.y, b[4].max.y, b[5].max.y, b[6].max.y, b[7].max.y);
+      const __m256 maxZ = _mm256_setr_ps(b[0].max.z, b[1].max.z, b[2].max.z, b[3].max.z, b[4].max.z, b[5].max.z, b[6].max.z, b[7].max.z);
+
+      const __m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+      const __m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+      const __m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+      const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+      const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+      const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+      __m256 outside = _mm256_setzero_ps();
+      for (const auto& plane : planes) {
+        const __m256 d = _mm256_fmadd_ps(plane[0], cx, _mm256_fmadd_ps(plane[1], cy, _mm256_fmadd_ps(plane[2], cz, plane[3])));
+        const __m256 r = _mm256_fmadd_ps(plane[4], ex, _mm256_fmadd_ps(plane[5], ey, _mm256_mul_ps(plane[6], ez)));
+
+        outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, _mm256_xor_ps(r, signMask), _CMP_LT_OQ));
+      }
+
+      const int mask = _mm256_movemask_ps(outside);
+      for (int k = 0; k < 8; ++k) {
+        visible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+      }
+    }
+
+    testAABBsSSE2(frustum, boxes + i, count - i, visible + i);
+  }
+
+  SIMD_TARGET_AVX2 static void projectPointsAVX2(const glm::mat4& viewProjection, const glm::vec4& viewport, const glm::vec3* points, glm::vec3* out, uint32_t count) {
+    const float* m = &viewProjection[0][0];
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    __m256 columns[16];
+    for (int k = 0; k < 16; ++k) {
+      columns[k] = _mm256_set1_ps(m[k]);
+    }
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const glm::vec3* p = points + i;
+      const __m256 px = _mm256_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x, p[4].x, p[5].x, p[6].x, p[7].x);
+      const __m256 py = _mm256_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y, p[4].y, p[5].y, p[6].y, p[7].y);
+      const __m256 pz = _mm256_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z, p[4].z, p[5].z, p[6].z, p[7].z);
+
+      __m256 clip[4];
+      for (int row = 0; row < 4; ++row) {
+        clip[row] = _mm256_fmadd_ps(columns[row], px, _mm256_fmadd_ps(columns[4 + row], py, _mm256_fmadd_ps(columns[8 + row], pz, columns[12 + row])));
+      }
+
+      const __m256 sx = _mm256_fmadd_ps(_mm256_div_ps(clip[0], clip[3]), half, half);
+      const __m256 sy = _mm256_fmadd_ps(_mm256_div_ps(clip[1], clip[3]), half, half);
+      const __m256 sz = _mm256_fmadd_ps(_mm256_div_ps(clip[2], clip[3]), half, half);
+
+      alignas(32) float x[8], y[8], z[8];
+      _mm256_store_ps(x, _mm256_fmadd_ps(_mm256_set1_ps(viewport.z), sx, _mm256_set1_ps(viewport.x)));
+      _mm256_store_ps(y, _mm256_fmadd_ps(_mm256_set1_ps(viewport.w), sy, _mm256_set1_ps(viewport.y)));
+      _mm256_store_ps(z, sz);
+
+      for (int k = 0; k < 8; ++k) {
+        out[i + k] = glm::vec3(x[k], y[k], z[k]);
+      }
+    }
+
+    projectPointsSSE2(viewProjection, viewport, points + i, out + i, count - i);
+  }
+
+  static void cpuid(int info[4], int leaf) {
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, 0);
+#else
+    __cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+  }
+
+  static uint64_t xgetbv() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+  }
+
+#endif // SIMD_X86
+
+  static const Kernels SCALAR_KERNELS = { composeTRSScalar, multiplyScalar, testAABBsScalar, projectPointsScalar };
+#if SIMD_X86
+  static const Kernels SSE2_KERNELS = { composeTRSSSE2, multiplySSE2, testAABBsSSE2, projectPointsSSE2 };
+  static const Kernels AVX2_KERNELS = { composeTRSAVX2, multiplyAVX2, testAABBsAVX2, projectPointsAVX2 };
+#endif
+
+  static Kernels sKernels = SCALAR_KERNELS;
+  static Level sLevel = Level::Scalar;
+  static Level sSupportedLevel = Level::Scalar;
+
+  static Level detectLevel() {
+#if SIMD_X86
+    // The vector paths load quaternions as x, y, z, w
+    const glm::quat q(1.0f, 0.0f, 0.0f, 0.0f);
+    if (reinterpret_cast<const float*>(&q)[3] != 1.0f)
+      return Level::Scalar;
+
+    int info[4];
+    cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    // AVX state must also be enabled by the OS
+    bool avx2 = false;
+    if (maxLeaf >= 7 && fma && osxsave && avx && (xgetbv() & 0x6) == 0x6) {
+      cpuid(info, 7);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+
+    return avx2 ? Level::AVX2 : (sse2 ? Level::SSE2 : Level::Scalar);
+#else
+    return Level::Scalar;
+#endif
+  }
+
+  void init() {
+    sSupportedLevel = detectLevel();
+    setLevel(sSupportedLevel);
+
+    LOG_INFO("[SimdMath] Using {} kernels", getLevelName(sLevel));
+  }
+
+  Level getSupportedLevel() {
+    return sSupportedLevel;
+  }
+
+  Level getLevel() {
+    return sLevel;
+  }
+
+  void setLevel(Level level) {
+    sLevel = std::min(level, sSupportedLevel);
+
+#if SIMD_X86
+    if (sLevel == Level::AVX2) {
+      sKernels = AVX2_KERNELS;
+      return;
+    }
+    if (sLevel == Level::SSE2) {
+      sKernels = SSE2_KERNELS;
+      return;
+    }
+#endif
+    sKernels = SCALAR_KERNELS;
+  }
+
+  const char* getLevelName(Level level) {
+    switch (level) {
+      case Level::AVX2: return "AVX2";
+      case Level::SSE2: return "SSE2";
+      default: return "Scalar";
+    }
+  }
+
+  void composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count) {
+    sKernels.composeTRS(positions, rotations, scales, out, count);
+  }
+
+  void multiply(const glm::mat4* a, const uint32_t* aIndices, const glm::mat4* b, glm::mat4* out, uint32_t count) {
+    sKernels.multiply(a, aIndices, b, out, count);
+  }
+
+  void testAABBs(const Frustum& frustum, const AABB* boxes, uint32_t count, uint8_t* visible) {
+    sKernels.testAABBs(frustum, boxes, count, visible);
+  }
+
+  void projectPoints(const glm::mat4& viewProjection, const glm::vec4& viewport, const glm::vec3* points, glm::vec3* out, uint32_t count) {
+    sKernels.projectPoints(viewProjection, viewport, points, out, count);
+  }
+}
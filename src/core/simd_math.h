@@ -0,0 +1,34 @@
+#pragma once
+
+#include "bounds.h"
+
+// Batch math kernels with SSE2 and AVX2 (+FMA) paths and a scalar fallback. init() picks the widest level
+// the CPU supports, setLevel() switches for comparisons. Non-x86 builds only have the scalar kernels.
+// Kernels match the glm functions they replace up to float rounding.
+namespace SimdMath {
+  enum class Level {
+    Scalar = 0,
+    SSE2,
+    AVX2,
+  };
+
+  void init();
+
+  Level getSupportedLevel();
+  Level getLevel();
+  // Clamped to the supported level
+  void setLevel(Level level);
+  const char* getLevelName(Level level);
+
+  // out[i] = translate(positions[i]) * toMat4(rotations[i]) * scale(scales[i])
+  void composeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count);
+
+  // out[i] = a[aIndices[i]] * b[i], or a[i] * b[i] without indices. out may be b.
+  void multiply(const glm::mat4* a, const uint32_t* aIndices, const glm::mat4* b, glm::mat4* out, uint32_t count);
+
+  // visible[i] = 1 unless boxes[i] is entirely outside one of the planes, same test as Frustum::intersects
+  void testAABBs(const Frustum& frustum, const AABB* boxes, uint32_t count, uint8_t* visible);
+
+  // out[i] = glm::project(points[i]) with the view-projection already combined. viewport is (x, y, width, height).
+  void projectPoints(const glm::mat4& viewProjection, const glm::vec4& viewport, const glm::vec3* points, glm::vec3* out, uint32_t count);
+}
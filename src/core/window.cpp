@@ -69,3 +69,9 @@ void Window::onResized(int width, int height) {
 void Window::update() {
   SDL_GL_SwapWindow(_window);
 }
+
+void Window::makeContextCurrent(bool current) {
+  if (SDL_GL_MakeCurrent(_window, current ? _context : nullptr) != 0) {
+    LOG_ERROR("[Window] Failed to change the current GL context. {}", SDL_GetError());
+  }
+}
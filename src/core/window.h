@@ -22,6 +22,8 @@ public:
   void resize(int width, int height);
   void onResized(int width, int height);
   void update();
+  // The GL context is current on one thread at a time, release it before another thread takes it
+  void makeContextCurrent(bool current);
 
   SDL_Window*   getWindow() const { return _window; }
   SDL_GLContext getGLContext() const { return _context; }
@@ -0,0 +1,484 @@
+#include "world.h"
+#include "renderer.h"
+#include "simd_math.h"
+
+// Moves the last item into index, the dense arrays of a component all shrink the same way
+template<typename T>
+static void swapRemove(std::vector<T>& items, uint32_t index) {
+  if (index + 1 < items.size()) {
+    items[index] = std::move(items.back());
+  }
+  items.pop_back();
+}
+
+// Moves items[i] to items[remap[i]]
+template<typename T>
+static void permute(std::vector<T>& items, const std::vector<uint32_t>& remap) {
+  std::vector<T> sorted(items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    sorted[remap[i]] = std::move(items[i]);
+  }
+  items.swap(sorted);
+}
+
+World::World()
+  : _transformsDirty(false)
+  , _orderDirty(false) {
+}
+
+EntityId World::createEntity(const glm::vec3& position) {
+  uint32_t index;
+  if (!_freeSlots.empty()) {
+    index = _freeSlots.back();
+    _freeSlots.pop_back();
+  }
+  else {
+    if (_slots.size() > EntityId::IndexMask) {
+      LOG_ERROR("[World] Entity limit {} reached", (uint32_t)EntityId::IndexMask + 1);
+      return nullptr;
+    }
+
+    index = (uint32_t)_slots.size();
+    _slots.push_back({ 1, InvalidIndex, InvalidIndex, InvalidIndex });
+  }
+
+  Slot& slot = _slots[index];
+  slot.transform = _transforms.size();
+  slot.renderable = InvalidIndex;
+  slot.light = InvalidIndex;
+
+  _transforms.positions.push_back(position);
+  _transforms.rotations.push_back(glm::identity<glm::quat>());
+  _transforms.scales.push_back(glm::vec3(1.0f));
+  _transforms.worldTMs.push_back(glm::translate(glm::mat4(1.0f), position));
+  _transforms.dirty.push_back(0);
+  _transforms.parents.push_back(InvalidIndex);
+  _transforms.childCounts.push_back(0);
+  _transforms.entities.push_back(index);
+
+  // Roots appended after deeper levels break the order
+  if (!_levels.empty()) {
+    _orderDirty = true;
+  }
+
+  return EntityId::Make(index, slot.generation);
+}
+
+void World::destroyEntity(EntityId id) {
+  Slot* slot = findSlot(id);
+  if (slot == nullptr)
+    return;
+
+  // Only entities with children pay for looking them up
+  if (_transforms.childCounts[slot->transform] > 0) {
+    std::vector<EntityId> children;
+    for (uint32_t i = 0; i < _transforms.size(); ++i) {
+      if (_transforms.parents[i] == slot->transform) {
+        const uint32_t child = _transforms.entities[i];
+        children.push_back(EntityId::Make(child, _slots[child].generation));
+      }
+    }
+
+    for (auto child : children) {
+      destroyEntity(child);
+    }
+  }
+
+  removeRenderable(id);
+  removeLight(id);
+
+  const uint32_t parent = _transforms.parents[slot->transform];
+  if (parent != InvalidIndex) {
+    _transforms.childCounts[parent]--;
+  }
+  removeTransform(slot->transform);
+
+  if (!_levels.empty()) {
+    _orderDirty = true;
+  }
+
+  // Generation 0 would make the invalid id, skip it on wrap around
+  slot->generation = (slot->generation + 1) & EntityId::GenerationMask;
+  if (slot->generation == 0) {
+    slot->generation = 1;
+  }
+  slot->transform = InvalidIndex;
+  _freeSlots.push_back(id.index());
+}
+
+void World::clear() {
+  _slots.clear();
+  _freeSlots.clear();
+  _transforms = Transforms();
+  _renderables = Renderables();
+  _lights = Lights();
+  _transformsDirty = false;
+  _levels.clear();
+  _orderDirty = false;
+}
+
+bool World::isAlive(EntityId id) const {
+  return findSlot(id) != nullptr;
+}
+
+void World::setPosition(EntityId id, const glm::vec3& position) {
+  const uint32_t index = transformIndex(id);
+  if (index == InvalidIndex)
+    return;
+
+  _transforms.positions[index] = position;
+  _transforms.dirty[index] = 1;
+  _transformsDirty = true;
+}
+
+void World::setRotation(EntityId id, const glm::quat& rotation) {
+  const uint32_t index = transformIndex(id);
+  if (index == InvalidIndex)
+    return;
+
+  _transforms.rotations[index] = rotation;
+  _transforms.dirty[index] = 1;
+  _transformsDirty = true;
+}
+
+void World::setScale(EntityId id, const glm::vec3& scale) {
+  const uint32_t index = transformIndex(id);
+  if (index == InvalidIndex)
+    return;
+
+  _transforms.scales[index] = scale;
+  _transforms.dirty[index] = 1;
+  _transformsDirty = true;
+}
+
+glm::vec3 World::getPosition(EntityId id) const {
+  const uint32_t index = transformIndex(id);
+  return index != InvalidIndex ? _transforms.positions[index] : glm::vec3(0.0f);
+}
+
+glm::quat World::getRotation(EntityId id) const {
+  const uint32_t index = transformIndex(id);
+  return index != InvalidIndex ? _transforms.rotations[index] : glm::identity<glm::quat>();
+}
+
+glm::vec3 World::getScale(EntityId id) const {
+  const uint32_t index = transformIndex(id);
+  return index != InvalidIndex ? _transforms.scales[index] : glm::vec3(1.0f);
+}
+
+const glm::mat4& World::getWorldTM(EntityId id) const {
+  static const glm::mat4 identity(1.0f);
+
+  const uint32_t index = transformIndex(id);
+  return index != InvalidIndex ? _transforms.worldTMs[index] : identity;
+}
+
+void World::setParent(EntityId id, EntityId parent) {
+  Slot* slot = findSlot(id);
+  if (slot == nullptr)
+    return;
+
+  uint32_t parentIndex = InvalidIndex;
+  if (parent) {
+    parentIndex = transformIndex(parent);
+    if (parentIndex == InvalidIndex)
+      return;
+
+    for (uint32_t i = parentIndex; i != InvalidIndex; i = _transforms.parents[i]) {
+      if (i == slot->transform) {
+        LOG_WARN("[World] Parenting entity {:#x} to {:#x} would make a cycle", id.value(), parent.value());
+        return;
+      }
+    }
+  }
+
+  uint32_t& current = _transforms.parents[slot->transform];
+  if (current == parentIndex)
+    return;
+
+  if (current != InvalidIndex) {
+    _transforms.childCounts[current]--;
+  }
+  if (parentIndex != InvalidIndex) {
+    _transforms.childCounts[parentIndex]++;
+  }
+  current = parentIndex;
+
+  _transforms.dirty[slot->transform] = 1;
+  _transformsDirty = true;
+  _orderDirty = true;
+}
+
+EntityId World::getParent(EntityId id) const {
+  const uint32_t index = transformIndex(id);
+  if (index == InvalidIndex || _transforms.parents[index] == InvalidIndex)
+    return nullptr;
+
+  const uint32_t parent = _transforms.entities[_transforms.parents[index]];
+  return EntityId::Make(parent, _slots[parent].generation);
+}
+
+void World::addRenderable(EntityId id, GfxModelRef model, MaterialRef material, uint32_t drawFlags) {
+  Slot* slot = findSlot(id);
+  if (slot == nullptr)
+    return;
+
+  if (slot->renderable != InvalidIndex) {
+    _renderables.models[slot->renderable] = model;
+    _renderables.materials[slot->renderable] = material;
+    _renderables.drawFlags[slot->renderable] = drawFlags;
+    return;
+  }
+
+  slot->renderable = _renderables.size();
+  _renderables.models.push_back(model);
+  _renderables.materials.push_back(material);
+  _renderables.drawFlags.push_back(drawFlags);
+  _renderables.transforms.push_back(slot->transform);
+  _renderables.entities.push_back(id.index());
+}
+
+void World::removeRenderable(EntityId id) {
+  Slot* slot = findSlot(id);
+  if (slot == nullptr || slot->renderable == InvalidIndex)
+    return;
+
+  const uint32_t index = slot->renderable;
+  const uint32_t moved = _renderables.entities.back();
+
+  swapRemove(_renderables.models, index);
+  swapRemove(_renderables.materials, index);
+  swapRemove(_renderables.drawFlags, index);
+  swapRemove(_renderables.transforms, index);
+  swapRemove(_renderables.entities, index);
+
+  _slots[moved].renderable = index;
+  slot->renderable = InvalidIndex;
+}
+
+void World::addLight(EntityId id, const Light::Properties& properties) {
+  Slot* slot = findSlot(id);
+  if (slot == nullptr)
+    return;
+
+  if (slot->light != InvalidIndex) {
+    _lights.properties[slot->light] = properties;
+    return;
+  }
+
+  slot->light = _lights.size();
+  _lights.properties.push_back(properties);
+  _lights.transforms.push_back(slot->transform);
+  _lights.entities.push_back(id.index());
+}
+
+void World::removeLight(EntityId id) {
+  Slot* slot = findSlot(id);
+  if (slot == nullptr || slot->light == InvalidIndex)
+    return;
+
+  const uint32_t index = slot->light;
+  const uint32_t moved = _lights.entities.back();
+
+  swapRemove(_lights.properties, index);
+  swapRemove(_lights.transforms, index);
+  swapRemove(_lights.entities, index);
+
+  _slots[moved].light = index;
+  slot->light = InvalidIndex;
+}
+
+void World::markDirty(uint32_t begin, uint32_t end) {
+  end = std::min(end, _transforms.size());
+  if (begin >= end)
+    return;
+
+  memset(_transforms.dirty.data() + begin, 1, end - begin);
+  _transformsDirty = true;
+}
+
+void World::updateTransforms(JobSystem& jobSystem) {
+  if (_orderDirty) {
+    sortByDepth();
+    _orderDirty = false;
+  }
+
+  if (!_transformsDirty)
+    return;
+
+  // Levels run one after the other, parents are final by the time their children read them. A transform
+  // is recomputed when it or its parent changed, and stays flagged so the change reaches its children.
+  Transforms& transforms = _transforms;
+  for (uint32_t level = 0; level < getLevelCount(); ++level) {
+    const uint32_t first = _levels.empty() ? 0 : _levels[level];
+    const uint32_t last = _levels.empty() ? transforms.size() : _levels[level + 1];
+
+    const bool hasParents = level > 0;
+
+    // Runs of transforms to recompute go through the batch kernels, local matrices first and then the
+    // parent multiply in place
+    jobSystem.parallelFor(last - first, TransformBatchSize, [&transforms, first, hasParents](uint32_t begin, uint32_t end) {
+      auto needsUpdate = [&transforms](uint32_t i) {
+        const uint32_t parent = transforms.parents[i];
+        return transforms.dirty[i] || (parent != InvalidIndex && transforms.dirty[parent]);
+      };
+
+      for (uint32_t i = first + begin; i < first + end;) {
+        if (!needsUpdate(i)) {
+          ++i;
+          continue;
+        }
+
+        uint32_t runEnd = i + 1;
+        while (runEnd < first + end && needsUpdate(runEnd)) {
+          ++runEnd;
+        }
+
+        const uint32_t count = runEnd - i;
+        SimdMath::composeTRS(&transforms.positions[i], &transforms.rotations[i], &transforms.scales[i], &transforms.worldTMs[i], count);
+        if (hasParents) {
+          SimdMath::multiply(transforms.worldTMs.data(), &transforms.parents[i], &transforms.worldTMs[i], &transforms.worldTMs[i], count);
+        }
+        memset(&transforms.dirty[i], 1, count);
+
+        i = runEnd;
+      }
+    });
+  }
+
+  memset(transforms.dirty.data(), 0, transforms.size());
+  _transformsDirty = false;
+}
+
+void World::render(Renderer& renderer) const {
+  Light light(Light::Type::Point);
+  for (uint32_t i = 0; i < _lights.size(); ++i) {
+    light.position = glm::vec3(_transforms.worldTMs[_lights.transforms[i]][3]);
+    light.properties = _lights.properties[i];
+    renderer.drawLight(light);
+  }
+
+  // Neighbours usually share the model, resolve it once per run
+  GfxModelRef lastModel;
+  const GfxModel* model = nullptr;
+
+  for (uint32_t i = 0; i < _renderables.size(); ++i) {
+    if (_renderables.models[i] != lastModel) {
+      lastModel = _renderables.models[i];
+      model = lastModel.get();
+    }
+    if (model == nullptr)
+      continue;
+
+    const MaterialRef& material = _renderables.materials[i] ? _renderables.materials[i] : model->getMaterial();
+    const glm::mat4& worldTM = _transforms.worldTMs[_renderables.transforms[i]];
+
+    for (uint32_t mesh = 0; mesh < model->getMeshCount(); ++mesh) {
+      renderer.drawMesh(model->getMesh(mesh), material, worldTM, _renderables.drawFlags[i]);
+    }
+  }
+}
+
+const World::Slot* World::findSlot(EntityId id) const {
+  if (!id || id.index() >= _slots.size())
+    return nullptr;
+
+  const Slot& slot = _slots[id.index()];
+  return (slot.generation == id.generation() && slot.transform != InvalidIndex) ? &slot : nullptr;
+}
+
+uint32_t World::transformIndex(EntityId id) const {
+  const Slot* slot = findSlot(id);
+  return slot != nullptr ? slot->transform : InvalidIndex;
+}
+
+void World::removeTransform(uint32_t index) {
+  const uint32_t moved = _transforms.entities.back();
+
+  swapRemove(_transforms.positions, index);
+  swapRemove(_transforms.rotations, index);
+  swapRemove(_transforms.scales, index);
+  swapRemove(_transforms.worldTMs, index);
+  swapRemove(_transforms.dirty, index);
+  swapRemove(_transforms.parents, index);
+  swapRemove(_transforms.childCounts, index);
+  swapRemove(_transforms.entities, index);
+
+  // Children and components of the moved entity follow its transform
+  const uint32_t last = _transforms.size();
+  if (index != last && _transforms.childCounts[index] > 0) {
+    for (auto& parent : _transforms.parents) {
+      if (parent == last) {
+        parent = index;
+      }
+    }
+  }
+
+  Slot& slot = _slots[moved];
+  slot.transform = index;
+  if (slot.renderable != InvalidIndex) {
+    _renderables.transforms[slot.renderable] = index;
+  }
+  if (slot.light != InvalidIndex) {
+    _lights.transforms[slot.light] = index;
+  }
+}
+
+void World::sortByDepth() {
+  const uint32_t count = _transforms.size();
+
+  std::vector<uint32_t> depths(count);
+  uint32_t maxDepth = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t depth = 0;
+    for (uint32_t parent = _transforms.parents[i]; parent != InvalidIndex; parent = _transforms.parents[parent]) {
+      depth++;
+    }
+    depths[i] = depth;
+    maxDepth = std::max(maxDepth, depth);
+  }
+
+  if (maxDepth == 0) {
+    _levels.clear();
+    return;
+  }
+
+  // Counting sort, stable so siblings keep their relative order
+  _levels.assign(maxDepth + 2, 0);
+  for (uint32_t depth : depths) {
+    _levels[depth + 1]++;
+  }
+  for (size_t level = 1; level < _levels.size(); ++level) {
+    _levels[level] += _levels[level - 1];
+  }
+
+  std::vector<uint32_t> cursors(_levels.begin(), _levels.end() - 1);
+  std::vector<uint32_t> remap(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    remap[i] = cursors[depths[i]]++;
+  }
+
+  permute(_transforms.positions, remap);
+  permute(_transforms.rotations, remap);
+  permute(_transforms.scales, remap);
+  permute(_transforms.worldTMs, remap);
+  permute(_transforms.dirty, remap);
+  permute(_transforms.parents, remap);
+  permute(_transforms.childCounts, remap);
+  permute(_transforms.entities, remap);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t& parent = _transforms.parents[i];
+    if (parent != InvalidIndex) {
+      parent = remap[parent];
+    }
+    _slots[_transforms.entities[i]].transform = i;
+  }
+
+  for (auto& transform : _renderables.transforms) {
+    transform = remap[transform];
+  }
+  for (auto& transform : _lights.transforms) {
+    transform = remap[transform];
+  }
+}
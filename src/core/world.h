@@ -0,0 +1,132 @@
+#pragma once
+
+#include "gfx_model.h"
+#include "job_system.h"
+#include "graphics/draw_batch.h"
+#include "graphics/lights.h"
+
+class Renderer;
+
+// Resolved by the World that created it
+struct WorldEntity;
+typedef GenerationalId<WorldEntity> EntityId;
+
+// Entity-component store. Components are kept as structure of arrays, densely packed and swapped on
+// removal, so systems walk plain contiguous arrays. Every entity has a transform, render and light
+// components are optional.
+//
+// Transforms can be parented. Setters only flag the transform, world matrices are recomputed once in
+// updateTransforms(). Transforms are kept sorted by depth so parents come before their children, and
+// each depth level is updated in one parallel pass after the previous one.
+class World {
+public:
+  enum : uint32_t {
+    InvalidIndex = ~0u,
+    TransformBatchSize = 1024,
+  };
+
+  // Dense transform arrays, index i of every array belongs to entities[i]. Position, rotation and scale
+  // are relative to the parent.
+  struct Transforms {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> worldTMs;
+    std::vector<uint8_t>   dirty;
+    std::vector<uint32_t>  parents;     // Transform index, InvalidIndex for roots
+    std::vector<uint32_t>  childCounts;
+    std::vector<uint32_t>  entities;
+
+    uint32_t size() const { return (uint32_t)entities.size(); }
+  };
+
+  struct Renderables {
+    std::vector<GfxModelRef> models;
+    std::vector<MaterialRef> materials; // Overrides the model material when set
+    std::vector<uint32_t>    drawFlags;
+    std::vector<uint32_t>    transforms;
+    std::vector<uint32_t>    entities;
+
+    uint32_t size() const { return (uint32_t)entities.size(); }
+  };
+
+  struct Lights {
+    std::vector<Light::Properties> properties;
+    std::vector<uint32_t> transforms;
+    std::vector<uint32_t> entities;
+
+    uint32_t size() const { return (uint32_t)entities.size(); }
+  };
+
+public:
+  World();
+
+  EntityId createEntity(const glm::vec3& position = glm::vec3(0.0f));
+  // Children are destroyed with their parent
+  void destroyEntity(EntityId id);
+  void clear();
+
+  bool isAlive(EntityId id) const;
+  uint32_t getEntityCount() const { return _transforms.size(); }
+
+  // Transform component
+  void setPosition(EntityId id, const glm::vec3& position);
+  void setRotation(EntityId id, const glm::quat& rotation);
+  void setScale(EntityId id, const glm::vec3& scale);
+  glm::vec3 getPosition(EntityId id) const;
+  glm::quat getRotation(EntityId id) const;
+  glm::vec3 getScale(EntityId id) const;
+  // As of the last updateTransforms()
+  const glm::mat4& getWorldTM(EntityId id) const;
+
+  // The local transform is kept, it becomes relative to the new parent. A null parent makes a root.
+  void setParent(EntityId id, EntityId parent);
+  EntityId getParent(EntityId id) const;
+
+  // Render component, the model and material are referenced, not owned
+  void addRenderable(EntityId id, GfxModelRef model, MaterialRef material = nullptr, uint32_t drawFlags = DrawFlags_None);
+  void removeRenderable(EntityId id);
+
+  // Light component, a point light at the entity position
+  void addLight(EntityId id, const Light::Properties& properties);
+  void removeLight(EntityId id);
+
+  // Bulk access for systems. Writing transforms directly needs markDirty() for the touched range.
+  Transforms& getTransforms() { return _transforms; }
+  const Transforms& getTransforms() const { return _transforms; }
+  const Renderables& getRenderables() const { return _renderables; }
+  const Lights& getLights() const { return _lights; }
+  void markDirty(uint32_t begin, uint32_t end);
+
+  // Systems. Transforms changed since the last update, or whose parent changed, are recomputed.
+  void updateTransforms(JobSystem& jobSystem);
+  uint32_t getLevelCount() const { return _levels.size() > 1 ? (uint32_t)_levels.size() - 1 : 1; }
+  void render(Renderer& renderer) const;
+
+private:
+  struct Slot {
+    uint32_t generation;
+    uint32_t transform;
+    uint32_t renderable;
+    uint32_t light;
+  };
+
+  const Slot* findSlot(EntityId id) const;
+  Slot* findSlot(EntityId id) { return const_cast<Slot*>(static_cast<const World*>(this)->findSlot(id)); }
+  uint32_t transformIndex(EntityId id) const;
+
+  void removeTransform(uint32_t index);
+  void sortByDepth();
+
+private:
+  std::vector<Slot>     _slots;
+  std::vector<uint32_t> _freeSlots;
+
+  Transforms  _transforms;
+  Renderables _renderables;
+  Lights      _lights;
+  bool        _transformsDirty;
+
+  std::vector<uint32_t> _levels; // First transform of each depth, plus the end. Empty while everything is a root.
+  bool        _orderDirty;
+};
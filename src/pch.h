@@ -1,13 +1,21 @@
 // Standard library
 #include <algorithm>
 #include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <functional>
+#include <limits>
 #include <map>
+#include <numeric>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <string>
+#include <thread>
 #include <time.h>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 